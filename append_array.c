@@ -0,0 +1,131 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include "append_array.h"
+
+/**
+ * Same layout as a segmented array: Chunk k has space for 2^(first_chunk_bits + k)
+ * elements and the highest set bit of index + first chunk capacity selects the chunk.
+ */
+static size_t append_array_chunk_of(append_array_p array, size_t index, size_t* offset){
+	size_t shifted = index + ((size_t)1 << array->first_chunk_bits);
+	size_t high_bit = 63 - __builtin_clzll(shifted);
+	*offset = shifted - ((size_t)1 << high_bit);
+	return high_bit - array->first_chunk_bits;
+}
+
+append_array_p append_array_new(size_t first_chunk_capacity, size_t element_size){
+	append_array_p array = calloc(1, sizeof(append_array_t));
+	if (array == NULL)
+		return NULL;
+	
+	if (first_chunk_capacity == 0)
+		first_chunk_capacity = APPEND_ARRAY_DEFAULT_FIRST_CHUNK_CAPACITY;
+	
+	array->element_size = element_size;
+	array->failed_start = SIZE_MAX;
+	while (((size_t)1 << array->first_chunk_bits) < first_chunk_capacity)
+		array->first_chunk_bits++;
+	
+	return array;
+}
+
+void append_array_destroy(append_array_p array){
+	for(size_t i = 0; i < APPEND_ARRAY_MAX_CHUNKS; i++)
+		free(array->chunks[i]);
+	free(array);
+}
+
+/**
+ * Several writers might need the same new chunk. Each one allocates it but only the
+ * first one publishes it, the others free their copy again.
+ */
+static bool append_array_alloc_chunk(append_array_p array, size_t chunk){
+	if ( __atomic_load_n(&array->chunks[chunk], __ATOMIC_ACQUIRE) != NULL )
+		return true;
+	
+	void* memory = malloc(((size_t)1 << (array->first_chunk_bits + chunk)) * array->element_size);
+	if (memory == NULL)
+		return false;
+	
+	void* expected = NULL;
+	if ( !__atomic_compare_exchange_n(&array->chunks[chunk], &expected, memory, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) )
+		free(memory);
+	return true;
+}
+
+bool append_array_reserve(append_array_p array, size_t n, size_t* start){
+	*start = __atomic_fetch_add(&array->reserved_length, n, __ATOMIC_RELAXED);
+	if (n == 0)
+		return true;
+	
+	size_t offset;
+	size_t first_chunk = append_array_chunk_of(array, *start, &offset);
+	size_t last_chunk = append_array_chunk_of(array, *start + n - 1, &offset);
+	for(size_t chunk = first_chunk; chunk <= last_chunk; chunk++) {
+		if ( !append_array_alloc_chunk(array, chunk) ) {
+			// Keep the smallest start, ranges before it can still be sealed
+			size_t failed_start = __atomic_load_n(&array->failed_start, __ATOMIC_RELAXED);
+			while ( *start < failed_start && !__atomic_compare_exchange_n(&array->failed_start, &failed_start, *start, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED) )
+				;
+			return false;
+		}
+	}
+	
+	return true;
+}
+
+void* append_array_elem_ptr(append_array_p array, size_t index){
+	size_t offset;
+	size_t chunk = append_array_chunk_of(array, index, &offset);
+	char* data = __atomic_load_n(&array->chunks[chunk], __ATOMIC_ACQUIRE);
+	return data + offset * array->element_size;
+}
+
+// Copies chunk by chunk, the range may span several chunks
+void append_array_write(append_array_p array, size_t start, const void* elems, size_t n){
+	while (n > 0) {
+		size_t offset;
+		size_t chunk = append_array_chunk_of(array, start, &offset);
+		size_t space_in_chunk = ((size_t)1 << (array->first_chunk_bits + chunk)) - offset;
+		size_t count = (n < space_in_chunk) ? n : space_in_chunk;
+		
+		memcpy(append_array_elem_ptr(array, start), elems, count * array->element_size);
+		elems = (const char*)elems + count * array->element_size;
+		start += count;
+		n -= count;
+	}
+}
+
+/**
+ * The release store of the sealed length makes the elements written before visible to
+ * readers that load it with acquire. Only ranges at or after a failed one give up, the
+ * ones before it are still sealed by their writers.
+ */
+bool append_array_commit(append_array_p array, size_t start, size_t n){
+	while ( __atomic_load_n(&array->sealed_length, __ATOMIC_ACQUIRE) != start ) {
+		if ( start >= __atomic_load_n(&array->failed_start, __ATOMIC_ACQUIRE) )
+			return false;
+		sched_yield();
+	}
+	
+	__atomic_store_n(&array->sealed_length, start + n, __ATOMIC_RELEASE);
+	return true;
+}
+
+ssize_t append_array_append(append_array_p array, const void* elem){
+	size_t index;
+	if ( !append_array_reserve(array, 1, &index) )
+		return -1;
+	
+	memcpy(append_array_elem_ptr(array, index), elem, array->element_size);
+	if ( !append_array_commit(array, index, 1) )
+		return -1;
+	return index;
+}
+
+size_t append_array_sealed_length(append_array_p array){
+	return __atomic_load_n(&array->sealed_length, __ATOMIC_ACQUIRE);
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+/**
+
+# Concurrent append-only arrays
+
+Many threads can append to an append array at the same time without a lock. A writer
+reserves a range of indices with one atomic fetch-and-add, writes its elements and
+then commits the range. The elements are stored in chunks that double in size (like a
+segmented array, see seg_array.h), new chunks are allocated by whichever writer
+needs them first. Elements are never moved, so readers can read while others append.
+
+Readers may only read elements below the sealed length. It's the end of the longest
+prefix of completely written and committed elements. Ranges are sealed in the order
+they were reserved: A commit waits (yielding the CPU) until all earlier reserved
+ranges are committed. So writers should commit soon after reserving.
+
+append_array_p a = append_array_of(record_t);
+
+// Writers: append one element (returns the index or -1 if a chunk couldn't be allocated)
+append_array_append(a, &record);
+
+// Or reserve a range, write it and commit it
+size_t start;
+if ( append_array_reserve(a, 16, &start) ) {
+	append_array_write(a, start, records, 16);
+	// or: *(record_t*)append_array_elem_ptr(a, start + i) = …
+	append_array_commit(a, start, 16);
+}
+
+// Readers
+size_t length = append_array_sealed_length(a);
+for(size_t i = 0; i < length; i++)
+	append_array_elem(a, record_t, i);
+
+append_array_destroy(a);  // Only when no other thread uses it anymore
+
+
+When a chunk can't be allocated append_array_reserve() returns false. The reserved
+indices are lost and the sealed length can't advance past them anymore. Commits of
+earlier ranges still succeed, commits of later ranges return false then instead of
+waiting forever.
+
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+
+#define APPEND_ARRAY_MAX_CHUNKS  64
+#define APPEND_ARRAY_DEFAULT_FIRST_CHUNK_CAPACITY  64
+
+typedef struct {
+	size_t element_size;
+	uint8_t first_chunk_bits;
+	void* chunks[APPEND_ARRAY_MAX_CHUNKS];
+	
+	// Updated atomically by the writers
+	size_t reserved_length;
+	size_t sealed_length;
+	size_t failed_start;  // Of the first range whose reserve failed, SIZE_MAX if none did
+} append_array_t, *append_array_p;
+
+#define append_array_of(type)  append_array_new(0, sizeof(type))
+#define append_array_elem(array, type, index)  (*(type*)append_array_elem_ptr(array, index))
+
+// A first chunk capacity of 0 uses APPEND_ARRAY_DEFAULT_FIRST_CHUNK_CAPACITY
+append_array_p append_array_new(size_t first_chunk_capacity, size_t element_size);
+void           append_array_destroy(append_array_p array);
+
+bool           append_array_reserve(append_array_p array, size_t n, size_t* start);
+void           append_array_write(append_array_p array, size_t start, const void* elems, size_t n);
+bool           append_array_commit(append_array_p array, size_t start, size_t n);
+ssize_t        append_array_append(append_array_p array, const void* elem);
+
+void*          append_array_elem_ptr(append_array_p array, size_t index);
+size_t         append_array_sealed_length(append_array_p array);
\ No newline at end of file
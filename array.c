@@ -1,19 +1,137 @@
+// For mremap()
+#define _GNU_SOURCE
+
 #include <stdlib.h>
 #include <string.h>  // for memcpy
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "array.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ARRAY_X86
+#endif
+
+// Inline elements start after the array_t, aligned for any type
+#define ARRAY_INLINE_OFFSET  ( (sizeof(array_t) + 15) / 16 * 16 )
+// Number of elements array_compact_threshold() evaluates and compacts at once
+#define ARRAY_COMPACT_CHUNK  4096
+
+static void array_init(array_p array, size_t length, size_t element_size, array_storage_t storage);
+static bool array_set_capacity(array_p array, size_t new_capacity);
+static size_t array_mapping_size(array_p array, size_t capacity);
+static bool array_truncate_file(array_p array, size_t size);
+
 array_p array_new(size_t length, size_t element_size){
 	array_p array = malloc(sizeof(array_t));
 	
 	if (array == NULL)
 		return NULL;
 	
-	array->length = length;
-	array->capacity = length;
-	array->element_size = element_size;
-	array->data = malloc(length * element_size);
+	array_init(array, length, element_size, ARRAY_MALLOC);
+	
+	// Empty arrays don't allocate any data until something is appended
+	if (length > 0) {
+		array->capacity = length;
+		array->data = malloc(length * element_size);
+		
+		if (array->data == NULL){
+			free(array);
+			return NULL;
+		}
+	}
+	
+	return array;
+}
+
+/**
+ * Creates an empty array with space for `inline_capacity` elements in the same memory
+ * block as the array_t itself. So small arrays need only one malloc(). When the array
+ * grows beyond that the elements are moved into a separately allocated block
+ * (ARRAY_MALLOC storage) and stay there, even if the array shrinks again.
+ */
+array_p array_new_inline(size_t inline_capacity, size_t element_size){
+	array_p array = malloc(ARRAY_INLINE_OFFSET + inline_capacity * element_size);
+	
+	if (array == NULL)
+		return NULL;
+	
+	array_init(array, 0, element_size, ARRAY_INLINE);
+	array->capacity = inline_capacity;
+	array->data = (char*)array + ARRAY_INLINE_OFFSET;
+	
+	return array;
+}
+
+/**
+ * Creates an array that stores its elements in an anonymous memory mapping. When it
+ * grows the pages are moved to a larger mapping with mremap() instead of copying them.
+ * Meant for huge arrays where a realloc() would copy gigabytes and temporarily needs
+ * twice the memory. The capacity is always rounded up to whole pages.
+ */
+array_p array_new_mmap(size_t length, size_t element_size){
+	array_p array = malloc(sizeof(array_t));
+	
+	if (array == NULL)
+		return NULL;
+	
+	array_init(array, length, element_size, ARRAY_MMAP);
+	
+	if ( !array_set_capacity(array, length) ){
+		free(array);
+		return NULL;
+	}
+	
+	return array;
+}
+
+/**
+ * Maps the file at `path` as the data of the array. The array starts with as many
+ * elements as fit into the file (a partial element at the end is ignored). Elements
+ * are read from and written to the file by the kernel as the pages are accessed, so
+ * the file can be larger than the memory. Growing extends the file with ftruncate()
+ * and remaps it with mremap(), like ARRAY_MMAP the capacity is rounded up to whole
+ * pages. So while the array is open the file size is that of the capacity,
+ * array_destroy() truncates it to the length.
+ * 
+ * Changes are written back to the file eventually, array_flush() forces that. Note that
+ * only array_destroy() sets the final file size.
+ */
+array_p array_open_mmap(const char* path, size_t element_size, array_file_mode_t mode){
+	int flags = (mode == ARRAY_FILE_READ) ? O_RDONLY : O_RDWR | O_CREAT;
+	if (mode == ARRAY_FILE_TRUNCATE)
+		flags |= O_TRUNC;
+	
+	int fd = open(path, flags, 0644);
+	if (fd == -1)
+		return NULL;
+	
+	struct stat file_stat;
+	array_p array = malloc(sizeof(array_t));
+	if (array == NULL || fstat(fd, &file_stat) != 0 || element_size == 0) {
+		free(array);
+		close(fd);
+		return NULL;
+	}
+	
+	array_init(array, file_stat.st_size / element_size, element_size, ARRAY_FILE);
+	array->fd = fd;
+	array->writable = (mode != ARRAY_FILE_READ);
+	
+	bool mapped;
+	if (array->writable) {
+		mapped = array_set_capacity(array, array->length);
+	} else {
+		// Read only arrays can't grow, so just map the elements there are
+		array->data = (array->length > 0) ? mmap(NULL, array->length * element_size, PROT_READ, MAP_SHARED, fd, 0) : NULL;
+		array->capacity = array->length;
+		mapped = (array->data != MAP_FAILED);
+	}
 	
-	if (array->data == NULL){
+	if ( !mapped ) {
+		close(fd);
 		free(array);
 		return NULL;
 	}
@@ -21,11 +139,185 @@ array_p array_new(size_t length, size_t element_size){
 	return array;
 }
 
+static void array_init(array_p array, size_t length, size_t element_size, array_storage_t storage){
+	array->length = length;
+	array->capacity = 0;
+	array->element_size = element_size;
+	array->storage = storage;
+	array->data = NULL;
+	array->fd = -1;
+	array->writable = false;
+	
+	array->growth_factor = ARRAY_DEFAULT_GROWTH_FACTOR;
+	array->shrink_threshold = ARRAY_DEFAULT_SHRINK_THRESHOLD;
+	array->min_capacity = 0;
+	
+	array->reallocs = 0;
+	array->bytes_copied = 0;
+}
+
 void array_destroy(array_p array){
-	free(array->data);
+	if (array->storage == ARRAY_FILE) {
+		// Keep the elements, only drop the unused capacity from the file
+		if (array->data != NULL)
+			munmap(array->data, array_mapping_size(array, array->capacity));
+		if (array->writable)
+			array_truncate_file(array, array->length * array->element_size);
+		close(array->fd);
+	} else {
+		array_set_capacity(array, 0);
+	}
 	free(array);
 }
 
+/**
+ * E.g. buffers that often swing between empty and full can use a shrink threshold of 0
+ * (never shrink) or a minimum capacity to avoid reallocating all the time. A growth
+ * factor of 1.5 wastes less memory than 2 but reallocates more often.
+ */
+void array_set_policy(array_p array, double growth_factor, double shrink_threshold, size_t min_capacity){
+	array->growth_factor = (growth_factor > 1) ? growth_factor : ARRAY_DEFAULT_GROWTH_FACTOR;
+	// Above 0.5 halving the capacity could cut it below the length
+	array->shrink_threshold = (shrink_threshold < 0) ? 0 : (shrink_threshold > 0.5) ? 0.5 : shrink_threshold;
+	array->min_capacity = min_capacity;
+}
+
+bool array_reserve(array_p array, size_t capacity){
+	if (capacity <= array->capacity)
+		return true;
+	return array_set_capacity(array, capacity);
+}
+
+bool array_shrink_to_fit(array_p array){
+	if (array->capacity == array->length)
+		return true;
+	return array_set_capacity(array, array->length);
+}
+
+bool array_advise(array_p array, array_advice_t advice){
+	if ( !(array->storage == ARRAY_MMAP || array->storage == ARRAY_FILE) )
+		return false;
+	if (array->data == NULL)
+		return true;
+	
+	int advices[] = {
+		[ARRAY_ADVICE_NORMAL] = MADV_NORMAL,
+		[ARRAY_ADVICE_SEQUENTIAL] = MADV_SEQUENTIAL,
+		[ARRAY_ADVICE_RANDOM] = MADV_RANDOM,
+		[ARRAY_ADVICE_WILLNEED] = MADV_WILLNEED,
+		[ARRAY_ADVICE_DONTNEED] = MADV_DONTNEED,
+	};
+	return madvise(array->data, array_mapping_size(array, array->capacity), advices[advice]) == 0;
+}
+
+bool array_flush(array_p array){
+	if (array->storage != ARRAY_FILE || !array->writable || array->data == NULL)
+		return true;
+	return msync(array->data, array_mapping_size(array, array->capacity), MS_SYNC) == 0;
+}
+
+static size_t array_mapping_size(array_p array, size_t capacity){
+	size_t page_size = sysconf(_SC_PAGESIZE);
+	return (capacity * array->element_size + page_size - 1) / page_size * page_size;
+}
+
+// When shrinking fails the file just keeps some unused space at its end, so callers
+// only check the result when growing
+static bool array_truncate_file(array_p array, size_t size){
+	return ftruncate(array->fd, size) == 0;
+}
+
+/**
+ * Reallocates the data for `new_capacity` elements. A capacity of 0 frees the data.
+ * Returns false if the memory could not be allocated, the array is unchanged then.
+ */
+static bool array_set_capacity(array_p array, size_t new_capacity){
+	// Views can't touch the memory of the array they point into, only shrink their length
+	if (array->storage == ARRAY_VIEW)
+		return new_capacity <= array->capacity;
+	
+	if (array->storage == ARRAY_INLINE) {
+		// The inline storage can't be resized, it's just used as long as everything fits
+		if (new_capacity <= array->capacity)
+			return true;
+		
+		void* heap_data = malloc(new_capacity * array->element_size);
+		if (heap_data == NULL)
+			return false;
+		
+		memcpy(heap_data, array->data, array->length * array->element_size);
+		array->reallocs++;
+		array->bytes_copied += array->length * array->element_size;
+		array->storage = ARRAY_MALLOC;
+		array->data = heap_data;
+		array->capacity = new_capacity;
+		return true;
+	}
+	
+	if (array->storage == ARRAY_MMAP || array->storage == ARRAY_FILE) {
+		// Read only files can't grow, only the length can shrink
+		if (array->storage == ARRAY_FILE && !array->writable)
+			return new_capacity <= array->capacity;
+		
+		size_t old_size = array_mapping_size(array, array->capacity);
+		size_t new_size = array_mapping_size(array, new_capacity);
+		void* new_data = NULL;
+		
+		// The file has to be large enough before its new pages are mapped. If mapping them
+		// fails afterwards the file just keeps the unused size until array_destroy().
+		if (array->storage == ARRAY_FILE && new_size > old_size && !array_truncate_file(array, new_size))
+			return false;
+		
+		if (new_size == old_size) {
+			new_data = array->data;
+		} else if (new_size == 0) {
+			munmap(array->data, old_size);
+		} else if (old_size == 0) {
+			if (array->storage == ARRAY_FILE)
+				new_data = mmap(NULL, new_size, PROT_READ | PROT_WRITE, MAP_SHARED, array->fd, 0);
+			else
+				new_data = mmap(NULL, new_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (new_data == MAP_FAILED)
+				return false;
+		} else {
+			new_data = mremap(array->data, old_size, new_size, MREMAP_MAYMOVE);
+			if (new_data == MAP_FAILED)
+				return false;
+		}
+		
+		// Only shrink the file after its pages are unmapped, accessing mapped pages past the
+		// end of the file crashes
+		if (array->storage == ARRAY_FILE && new_size < old_size)
+			array_truncate_file(array, new_size);
+		
+		// Moved pages are remapped, not copied
+		if (new_size != old_size)
+			array->reallocs++;
+		array->data = new_data;
+		array->capacity = (array->element_size > 0) ? new_size / array->element_size : new_capacity;
+		return true;
+	}
+	
+	if (new_capacity == 0) {
+		free(array->data);
+		array->data = NULL;
+		array->capacity = 0;
+		return true;
+	}
+	
+	void* reallocated_data = realloc(array->data, new_capacity * array->element_size);
+	if (reallocated_data == NULL)
+		return false;
+	
+	// When realloc() moved the data it copied everything that fit into the new block
+	array->reallocs++;
+	if (array->data != NULL && reallocated_data != array->data)
+		array->bytes_copied += (new_capacity < array->capacity ? new_capacity : array->capacity) * array->element_size;
+	array->data = reallocated_data;
+	array->capacity = new_capacity;
+	return true;
+}
+
 /**
  * Resize should return the pointer to the newly appended memory block on success.
  * NULL is returned when the array shrinks or the realloc failed.
@@ -34,26 +326,26 @@ void* array_resize(array_p array, size_t new_length){
 	size_t new_capacity = array->capacity;
 	
 	if (new_capacity == 0) {
-		new_capacity = new_length;
+		new_capacity = (new_length > array->min_capacity) ? new_length : array->min_capacity;
 	} else {
-		// If the requested length is greater than the capacity double it until we get
-		// a capacity large enough.
-		while(new_length > new_capacity)
-			new_capacity *= 2;
-		// If the length is smaller than a quater of the capacity half it until we get
-		// a capacity small enough.
-		while(new_length < new_capacity / 4)
+		// If the requested length is greater than the capacity grow it by the growth
+		// factor (but at least by one) until we get a capacity large enough.
+		while(new_length > new_capacity) {
+			size_t grown_capacity = new_capacity * array->growth_factor;
+			new_capacity = (grown_capacity > new_capacity) ? grown_capacity : new_capacity + 1;
+		}
+		// If the length is smaller than the shrink threshold (a quater of the capacity
+		// by default) half it until we get a capacity small enough. Only when the array
+		// shrinks, otherwise appending to an array with a reserved capacity would throw it
+		// away again.
+		while(new_length < array->length && new_length < (size_t)(new_capacity * array->shrink_threshold) && new_capacity / 2 >= array->min_capacity && new_capacity / 2 >= new_length)
 			new_capacity /= 2;
 	}
 	
 	// Realloc the array data if the capacity has to change
 	if (new_capacity != array->capacity) {
-		void* reallocated_data = realloc(array->data, new_capacity * array->element_size);
-		if (reallocated_data == NULL)
+		if ( !array_set_capacity(array, new_capacity) )
 			return NULL;
-		
-		array->data = reallocated_data;
-		array->capacity = new_capacity;
 	}
 	
 	size_t old_length = array->length;
@@ -70,37 +362,196 @@ void* array_elem_ptr(array_p array, size_t index) {
 	return (char*)array->data + array->element_size * index;
 }
 
+/**
+ * Sets bit i of mask[i / 64] (relative to `start`) for every element in [start, start + count)
+ * the function returns true for. Returns the number of set bits.
+ */
+static size_t array_mask_range(array_p array, array_elem_func_t func, size_t start, size_t count, uint64_t* mask){
+	size_t set_bits = 0;
+	
+	for(size_t w = 0; w < (count + 63) / 64; w++) {
+		uint64_t word = 0;
+		size_t bits = (count - w * 64 < 64) ? count - w * 64 : 64;
+		for(size_t i = 0; i < bits; i++)
+			word |= (uint64_t)func(array, start + w * 64 + i) << i;
+		mask[w] = word;
+		set_bits += __builtin_popcountll(word);
+	}
+	
+	return set_bits;
+}
+
+size_t array_mask_func(array_p array, array_elem_func_t func, uint64_t* mask){
+	return array_mask_range(array, func, 0, array->length, mask);
+}
+
+#ifdef ARRAY_X86
+
+// Compress the kept elements of 64 into one block with AVX-512. Each vector is loaded
+// before its compressed elements are stored, and the destination is never behind the
+// source. So the full width stores only overwrite elements that were already read.
+
+__attribute__((target("avx512f")))
+static void array_compact_word_avx512_32(char* dest, const char* src, uint64_t keep){
+	for(size_t i = 0; i < 4; i++) {
+		__mmask16 bits = keep >> (i * 16);
+		__m512i v = _mm512_loadu_si512(src + i * 64);
+		_mm512_storeu_si512(dest, _mm512_maskz_compress_epi32(bits, v));
+		dest += __builtin_popcount(bits) * 4;
+	}
+}
+
+__attribute__((target("avx512f")))
+static void array_compact_word_avx512_64(char* dest, const char* src, uint64_t keep){
+	for(size_t i = 0; i < 8; i++) {
+		__mmask8 bits = keep >> (i * 8);
+		__m512i v = _mm512_loadu_si512(src + i * 64);
+		_mm512_storeu_si512(dest, _mm512_maskz_compress_epi64(bits, v));
+		dest += __builtin_popcount(bits) * 8;
+	}
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vbmi2")))
+static void array_compact_word_avx512_8(char* dest, const char* src, uint64_t keep){
+	__m512i v = _mm512_loadu_si512(src);
+	_mm512_storeu_si512(dest, _mm512_maskz_compress_epi8(keep, v));
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vbmi2")))
+static void array_compact_word_avx512_16(char* dest, const char* src, uint64_t keep){
+	for(size_t i = 0; i < 2; i++) {
+		__mmask32 bits = keep >> (i * 32);
+		__m512i v = _mm512_loadu_si512(src + i * 64);
+		_mm512_storeu_si512(dest, _mm512_maskz_compress_epi16(bits, v));
+		dest += __builtin_popcount(bits) * 2;
+	}
+}
+
+#endif
+
+typedef void (*array_compact_word_func_t)(char* dest, const char* src, uint64_t keep);
+
+static array_compact_word_func_t array_compact_word_func(size_t element_size){
+#ifdef ARRAY_X86
+	if (element_size == 4 && __builtin_cpu_supports("avx512f"))
+		return array_compact_word_avx512_32;
+	if (element_size == 8 && __builtin_cpu_supports("avx512f"))
+		return array_compact_word_avx512_64;
+	if (element_size == 1 && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vbmi2"))
+		return array_compact_word_avx512_8;
+	if (element_size == 2 && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vbmi2"))
+		return array_compact_word_avx512_16;
+#else
+	(void)element_size;
+#endif
+	return NULL;
+}
+
+// Copies every element and only advances the destination for kept ones, no branches
+#define ARRAY_COMPACT_BRANCHLESS(type, data, out, base, bits, keep)  do {  \
+	type* elements = (type*)(data);                                        \
+	for(size_t i = 0; i < (bits); i++) {                                   \
+		elements[out] = elements[(base) + i];                              \
+		out += ((keep) >> i) & 1;                                          \
+	}                                                                      \
+} while(0)
+
+/**
+ * Moves the elements in [start, start + count) whose bit in `remove_mask` is not set to
+ * `out` and following (out <= start). Returns the index after the last moved element.
+ * 
+ * Each 64 bit word of the mask is handled on its own: Words without removed elements
+ * are moved with one memmove(), words with only removed elements are skipped. Mixed
+ * words of small elements are compressed with AVX-512 if available or copied without
+ * branches. Larger elements are moved in runs of kept elements with memmove().
+ */
+static size_t array_compact_range(array_p array, const uint64_t* remove_mask, size_t start, size_t count, size_t out){
+	char* data = array->data;
+	size_t size = array->element_size;
+	array_compact_word_func_t compact_word = array_compact_word_func(size);
+	
+	for(size_t w = 0; w < (count + 63) / 64; w++) {
+		size_t base = start + w * 64;
+		size_t bits = (count - w * 64 < 64) ? count - w * 64 : 64;
+		uint64_t all = (bits == 64) ? ~(uint64_t)0 : ((uint64_t)1 << bits) - 1;
+		uint64_t keep = ~remove_mask[w] & all;
+		
+		if (keep == 0)
+			continue;
+		
+		if (keep == all) {
+			if (out != base)
+				memmove(data + out * size, data + base * size, bits * size);
+			out += bits;
+		} else if (compact_word != NULL && bits == 64) {
+			compact_word(data + out * size, data + base * size, keep);
+			out += __builtin_popcountll(keep);
+		} else if (size == 1) {
+			ARRAY_COMPACT_BRANCHLESS(uint8_t, data, out, base, bits, keep);
+		} else if (size == 2) {
+			ARRAY_COMPACT_BRANCHLESS(uint16_t, data, out, base, bits, keep);
+		} else if (size == 4) {
+			ARRAY_COMPACT_BRANCHLESS(uint32_t, data, out, base, bits, keep);
+		} else if (size == 8) {
+			ARRAY_COMPACT_BRANCHLESS(uint64_t, data, out, base, bits, keep);
+		} else {
+			while (keep != 0) {
+				// A run never covers the entire word here, that was handled above
+				size_t run_start = __builtin_ctzll(keep);
+				size_t run_length = __builtin_ctzll(~(keep >> run_start));
+				memmove(data + out * size, data + (base + run_start) * size, run_length * size);
+				out += run_length;
+				keep &= ~((((uint64_t)1 << run_length) - 1) << run_start);
+			}
+		}
+	}
+	
+	return out;
+}
+
+void array_remove_mask(array_p array, const uint64_t* remove_mask){
+	size_t length = array_compact_range(array, remove_mask, 0, array->length, 0);
+	array_resize(array, length);
+}
+
+/**
+ * The function is called only once per element. For a threshold of 0 or 1 the elements
+ * are evaluated and compacted in chunks with a mask on the stack. Otherwise we have to
+ * know the number of empty elements before touching anything, so the mask of the whole
+ * array is allocated.
+ */
 void array_compact_threshold(array_p array, size_t empty_elements_threshold, array_elem_func_t is_empty_function){
-	// First check if enough elements are empty. If the threshold is 0 or 1 we don't need this because
-	// we have to compact each found element anyway.
 	if (empty_elements_threshold > 1) {
+		uint64_t* mask = malloc((array->length + 63) / 64 * sizeof(uint64_t));
+		if (mask != NULL) {
+			if ( array_mask_func(array, is_empty_function, mask) >= empty_elements_threshold )
+				array_remove_mask(array, mask);
+			free(mask);
+			return;
+		}
+		
+		// Without memory for the mask count the empty elements first and evaluate them
+		// again when compacting
 		size_t empty_elements = 0;
-		for(size_t index = 0; index < array->length; index++) {
-			if ( is_empty_function(array, index) ) {
+		for(size_t index = 0; index < array->length && empty_elements < empty_elements_threshold; index++) {
+			if ( is_empty_function(array, index) )
 				empty_elements++;
-				
-				if (empty_elements >= empty_elements_threshold)
-					break;
-			}
 		}
 		
 		if (empty_elements < empty_elements_threshold)
 			return;
 	}
 	
-	// Then overwrite empty elements with the following filled ones
-	size_t compacted_index = 0;
-	for(size_t index = 0; index < array->length; index++) {
-		if ( !is_empty_function(array, index) ) {
-			if (index != compacted_index)
-				memcpy((char*)array->data + compacted_index * array->element_size, (char*)array->data + index * array->element_size, array->element_size);
-			
-			compacted_index++;
-		}
+	uint64_t mask[ARRAY_COMPACT_CHUNK / 64];
+	size_t compacted_length = 0, count = 0;
+	for(size_t start = 0; start < array->length; start += count) {
+		count = (array->length - start < ARRAY_COMPACT_CHUNK) ? array->length - start : ARRAY_COMPACT_CHUNK;
+		array_mask_range(array, is_empty_function, start, count, mask);
+		compacted_length = array_compact_range(array, mask, start, count, compacted_length);
 	}
 	
 	// And finally chop off the empty end of the array
-	array_resize(array, compacted_index);
+	array_resize(array, compacted_length);
 }
 
 ssize_t array_find(array_p array, array_elem_func_t check_function){
@@ -121,6 +572,152 @@ void array_remove(array_p array, size_t index){
 	array_resize(array, array->length - 1);
 }
 
+/**
+ * Appends `n` elements with one resize. If `src` is NULL the new elements are left
+ * uninitialized. Returns a pointer to the first new element or NULL if the array couldn't
+ * grow.
+ */
+void* array_append_n(array_p array, const void* src, size_t n){
+	return array_insert_n(array, array->length, src, n);
+}
+
+/**
+ * Inserts `n` elements before `index` (the length appends them). `src` must not point
+ * into the array itself. Returns a pointer to the first inserted element or NULL if the
+ * index is out of range or the array couldn't grow.
+ */
+void* array_insert_n(array_p array, size_t index, const void* src, size_t n){
+	if (index > array->length)
+		return NULL;
+	
+	size_t old_length = array->length, size = array->element_size;
+	if (n > 0 && array_resize(array, old_length + n) == NULL)
+		return NULL;
+	
+	char* inserted = (char*)array->data + index * size;
+	if (n > 0) {
+		memmove(inserted + n * size, inserted, (old_length - index) * size);
+		if (src != NULL)
+			memcpy(inserted, src, n * size);
+	}
+	
+	return inserted;
+}
+
+/**
+ * Removes the elements at the `count` indices, which have to be sorted in ascending
+ * order. Duplicates and indices beyond the end are ignored. The kept elements between
+ * two removed ones are moved with one memmove() each, so every element moves at most
+ * once.
+ */
+void array_remove_indices(array_p array, const size_t* indices, size_t count){
+	char* data = array->data;
+	size_t size = array->element_size, out = 0, next = 0;
+	
+	for(size_t i = 0; i < count && indices[i] < array->length; i++) {
+		if (indices[i] < next)
+			continue;
+		
+		// Move the kept elements before this index
+		if (out != next)
+			memmove(data + out * size, data + next * size, (indices[i] - next) * size);
+		out += indices[i] - next;
+		next = indices[i] + 1;
+	}
+	
+	if (next == 0)
+		return;
+	
+	if (out != next)
+		memmove(data + out * size, data + next * size, (array->length - next) * size);
+	array_resize(array, out + array->length - next);
+}
+
+/**
+ * Replaces the element with the last one. Doesn't keep the order but doesn't move the
+ * following elements either.
+ */
+void array_swap_remove(array_p array, size_t index){
+	if (index >= array->length)
+		return;
+	
+	size_t last = array->length - 1;
+	if (index != last)
+		memcpy((char*)array->data + index * array->element_size, (char*)array->data + last * array->element_size, array->element_size);
+	array_resize(array, last);
+}
+
+/**
+ * Turns `start` and `length` into the index range [from, to), see array.h.
+ */
+static void array_range(array_p array, ssize_t start, ssize_t length, size_t* from, size_t* to){
+	size_t len = array->length;
+	
+	if (start >= 0) {
+		*from = ((size_t)start < len) ? (size_t)start : len;
+		*to = (length > 0 && (size_t)length < len - *from) ? *from + length : len;
+	} else {
+		// The range ends with the element `start` and extends backwards
+		*to = ((size_t)-start <= len) ? len + start + 1 : 0;
+		*from = (length > 0 && (size_t)length < *to) ? *to - length : 0;
+	}
+}
+
+array_view_t array_slice(array_p array, ssize_t start, ssize_t length){
+	size_t from, to;
+	array_range(array, start, length, &from, &to);
+	
+	array_view_t view;
+	array_init(&view, to - from, array->element_size, ARRAY_VIEW);
+	view.capacity = to - from;
+	view.data = (char*)array->data + from * array->element_size;
+	return view;
+}
+
+array_p array_copy_slice(array_p array, ssize_t start, ssize_t length){
+	size_t from, to;
+	array_range(array, start, length, &from, &to);
+	
+	array_p copy = array_new(to - from, array->element_size);
+	if (copy == NULL)
+		return NULL;
+	
+	if (to > from)
+		memcpy(copy->data, (char*)array->data + from * array->element_size, (to - from) * array->element_size);
+	array_set_policy(copy, array->growth_factor, array->shrink_threshold, array->min_capacity);
+	return copy;
+}
+
+void array_remove_slice(array_p array, ssize_t start, ssize_t length){
+	size_t from, to;
+	array_range(array, start, length, &from, &to);
+	if (from == to)
+		return;
+	
+	char* data = array->data;
+	memmove(data + from * array->element_size, data + to * array->element_size, (array->length - to) * array->element_size);
+	array_resize(array, array->length - (to - from));
+}
+
+ssize_t array_find_in(array_p array, array_elem_func_t check_function, ssize_t start, ssize_t length){
+	size_t from, to;
+	array_range(array, start, length, &from, &to);
+	
+	if (start < 0) {
+		for(size_t index = to; index > from; index--) {
+			if ( check_function(array, index - 1) )
+				return index - 1;
+		}
+	} else {
+		for(size_t index = from; index < to; index++) {
+			if ( check_function(array, index) )
+				return index;
+		}
+	}
+	
+	return -1;
+}
+
 void array_remove_func(array_p array, array_elem_func_t func){
 	array_compact_threshold(array, 1, func);
 }
\ No newline at end of file
@@ -1,28 +1,110 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdbool.h>
 #include <sys/types.h>
 
 
+// Where the elements of an array are stored
+typedef enum {
+	ARRAY_MALLOC,  // malloc() and realloc(), the default
+	ARRAY_MMAP,    // Anonymous mmap() grown with mremap(), pages are remapped instead of copied
+	ARRAY_INLINE,  // Right after the array_t in the same malloc() block until it outgrows it
+	ARRAY_VIEW,    // Part of the data of another array, see array_slice()
+	ARRAY_FILE,    // Shared mmap() of a file, see array_open_mmap()
+} array_storage_t;
+
+typedef enum {
+	ARRAY_FILE_READ,      // Existing file, read only. The array can't grow and writing elements crashes.
+	ARRAY_FILE_WRITE,     // Creates the file if necessary and keeps its contents
+	ARRAY_FILE_TRUNCATE,  // Creates the file if necessary and starts with an empty array
+} array_file_mode_t;
+
+// Access pattern hints for the pages of ARRAY_MMAP and ARRAY_FILE arrays, see madvise()
+typedef enum {
+	ARRAY_ADVICE_NORMAL,
+	ARRAY_ADVICE_SEQUENTIAL,  // Aggressive read-ahead, pages can be dropped soon after access
+	ARRAY_ADVICE_RANDOM,      // No read-ahead
+	ARRAY_ADVICE_WILLNEED,    // Start reading everything in now
+	ARRAY_ADVICE_DONTNEED,    // Drop the pages from memory, ARRAY_MMAP elements are zeroed, ARRAY_FILE ones kept
+} array_advice_t;
+
+// Element or key types for the typed functions in array_search.h and array_sort.h
+typedef enum {
+	ARRAY_INT8,
+	ARRAY_INT16,
+	ARRAY_INT32,
+	ARRAY_INT64,
+	ARRAY_UINT8,
+	ARRAY_UINT16,
+	ARRAY_UINT32,
+	ARRAY_UINT64,
+	ARRAY_FLOAT,
+	ARRAY_DOUBLE,
+	ARRAY_RECORD,  // Compared with memcmp(), any element size
+} array_elem_type_t;
+
 typedef struct {
 	size_t length, capacity;
 	size_t element_size;
+	array_storage_t storage;
 	void* data;
+	int fd;         // ARRAY_FILE only
+	bool writable;  // ARRAY_FILE only, false for ARRAY_FILE_READ
+	
+	// Growth policy, see array_set_policy()
+	double growth_factor, shrink_threshold;
+	size_t min_capacity;
+	
+	// Instrumentation: number of reallocations and bytes copied by them
+	size_t reallocs, bytes_copied;
 } array_t, *array_p;
 
+// A view is an array_t by value that points into the data of another array. It owns
+// nothing, so it must not be destroyed and is invalid once the other array changes its
+// capacity. It works with everything that doesn't grow the array. When a view shrinks
+// (e.g. by removing elements) the elements of the other array behind the new end of
+// the view are undefined.
+typedef array_t array_view_t;
+
+#define ARRAY_DEFAULT_GROWTH_FACTOR     2.0
+#define ARRAY_DEFAULT_SHRINK_THRESHOLD  0.25
+
 
 #define array_with(length, type)  array_new(length, sizeof(type))
 #define array_of(type)            array_new(0, sizeof(type))
+#define array_of_mmap(type)       array_new_mmap(0, sizeof(type))
+#define array_of_inline(type, inline_capacity)  array_new_inline(inline_capacity, sizeof(type))
 
-#define array_data(array, type)           ((type*)array->data)
+#define array_data(array, type)           ((type*)(array)->data)
 #define array_elem(array, type, index)    (array_data(array, type)[index])
-#define array_append(array, type, value)  (*((type*)array_resize(array, array->length + 1)) = (value))
+#define array_append(array, type, value)  (*((type*)array_resize(array, (array)->length + 1)) = (value))
 
 array_p array_new(size_t length, size_t element_size);
+array_p array_new_mmap(size_t length, size_t element_size);
+array_p array_new_inline(size_t inline_capacity, size_t element_size);
+// Maps the file as the data of the array, see array.c for details. Returns NULL on error.
+array_p array_open_mmap(const char* path, size_t element_size, array_file_mode_t mode);
 void    array_destroy(array_p array);
 void*   array_resize(array_p array, size_t new_length);
 
+// Grow the capacity by `growth_factor` (> 1). When the length drops below
+// `shrink_threshold` * capacity the capacity is halved (0 never shrinks, clamped to 0.5
+// at most). The capacity is never shrunk below `min_capacity` or the length. Defaults are 2.0, 0.25 and 0.
+void    array_set_policy(array_p array, double growth_factor, double shrink_threshold, size_t min_capacity);
+
+// Makes sure the capacity is at least `capacity` elements, never shrinks the array
+bool    array_reserve(array_p array, size_t capacity);
+// Reduces the capacity to the length (rounded up to whole pages for ARRAY_MMAP and ARRAY_FILE)
+bool    array_shrink_to_fit(array_p array);
+
+// Returns false for other storage than ARRAY_MMAP and ARRAY_FILE or if madvise() failed
+bool    array_advise(array_p array, array_advice_t advice);
+// Writes changed pages of an ARRAY_FILE array back to the file and waits until they are
+// stored. True for other storage since there's nothing to write.
+bool    array_flush(array_p array);
+
 void*   array_elem_ptr(array_p array, size_t index);
 void*   array_append_ptr(array_p array);
 
@@ -31,12 +113,42 @@ typedef bool (*array_elem_func_t)(array_p array, size_t index);
 // Removes empty elements from an array if more than `empty_elements_threshold` are empty.
 void    array_compact_threshold(array_p array, size_t empty_elements_threshold, array_elem_func_t is_empty_function);
 
+// Masks have one bit per element, element i is bit i % 64 of mask[i / 64]. So a mask
+// needs (length + 63) / 64 words. array_mask_func() sets the bits of all elements the
+// function returns true for and returns the number of set bits. array_remove_mask()
+// removes all elements whose bit is set.
+size_t  array_mask_func(array_p array, array_elem_func_t func, uint64_t* mask);
+void    array_remove_mask(array_p array, const uint64_t* remove_mask);
+
 // Searches for the first occurence of value in the array. Returns -1 if no matching element was found.
+// For arrays of numbers array_find_first() and friends in array_search.h are a lot faster.
 ssize_t array_find(array_p array, array_elem_func_t check_function);
 
 // Removes one element from the array
 void    array_remove(array_p array, size_t index);
 
+// Bulk versions with at most one reallocation and one pass over the elements
+void*   array_append_n(array_p array, const void* src, size_t n);
+void*   array_insert_n(array_p array, size_t index, const void* src, size_t n);
+void    array_remove_indices(array_p array, const size_t* indices, size_t count);
+// Removes an element by moving the last one into its place
+void    array_swap_remove(array_p array, size_t index);
+
+// Ranges are given by `start` and `length`. A length of 0 means all remaining elements
+// after start. A negative start is an index from the end (-1 is the last element) and
+// the range extends backwards from there:
+// array_slice(a, 0, 0)  => the entire array
+// array_slice(a, 5, 10) => the 10 elements starting at index 5
+// array_slice(a, -1, 5) => the last 5 elements
+// Ranges reaching beyond the array are cut off.
+array_view_t array_slice(array_p array, ssize_t start, ssize_t length);
+array_p      array_copy_slice(array_p array, ssize_t start, ssize_t length);
+void         array_remove_slice(array_p array, ssize_t start, ssize_t length);
+
+// Like array_find() but only searches in the range, backwards for a negative start.
+// Returns the index in the entire array or -1.
+ssize_t array_find_in(array_p array, array_elem_func_t check_function, ssize_t start, ssize_t length);
+
 void    array_remove_func(array_p array, array_elem_func_t func);
 
 // This stuff requires the statement as expression GCC extention. Therefore only compile
@@ -88,24 +200,6 @@ void    array_remove_func(array_p array, array_elem_func_t func);
 
 /*
 
-Further ideas:
-
-
-// searches in region of the array. length = 0 means all remaining elements after start.
-// a negative start value means an index from the end (-1 is the last element)
-// array_find_in(a, 42, 0, 0)  => searches entire array
-// array_find_in(a, 42, 5, 10) => search from index 5 the next 10 elements
-// array_find_in(a, 42, -1, 0) => search the entire array backwards
-// array_find_in(a, 42, -1, 5) => search in the last 5 elements
-size_t array_find_in(array, value, start, length)
-
-// same meaning of the start and length parameter as above
-array_p array_slice(array, start, length);
-array_p array_copy_slice(array, start, length);
-
-
-void array_remove_slice(array, start, length);
-
 Strange stuff / Bugs:
 
 - array.h causes bug in sys/types.h header file. GCC error:
@@ -0,0 +1,597 @@
+// For posix_memalign()
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "array_search.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ARRAY_SEARCH_X86
+#endif
+
+/**
+ * All kernels compare blocks of 64 bytes (one cache line, one AVX-512 register) and
+ * produce a bit mask per block with one bit per element, bit 0 is the first element.
+ * Find-first, find-last, count and find-all then only differ in what they do with the
+ * masks (ctz, clz, popcount or iterating over the set bits). To keep the overhead of
+ * the indirect call small the kernels process up to ARRAY_SEARCH_CHUNK blocks at once.
+ */
+#define ARRAY_SEARCH_BLOCK  64
+#define ARRAY_SEARCH_CHUNK  64
+
+typedef void (*array_search_kernel_t)(const char* data, size_t blocks, const void* value, uint64_t* masks);
+
+typedef enum {
+	ARRAY_SEARCH_FIRST,
+	ARRAY_SEARCH_LAST,
+	ARRAY_SEARCH_COUNT,
+	ARRAY_SEARCH_ALL,
+} array_search_mode_t;
+
+static const size_t array_search_type_sizes[] = {
+	[ARRAY_INT8]   = sizeof(int8_t),
+	[ARRAY_INT16]  = sizeof(int16_t),
+	[ARRAY_INT32]  = sizeof(int32_t),
+	[ARRAY_INT64]  = sizeof(int64_t),
+	[ARRAY_UINT8]  = sizeof(uint8_t),
+	[ARRAY_UINT16] = sizeof(uint16_t),
+	[ARRAY_UINT32] = sizeof(uint32_t),
+	[ARRAY_UINT64] = sizeof(uint64_t),
+	[ARRAY_FLOAT]  = sizeof(float),
+	[ARRAY_DOUBLE] = sizeof(double),
+};
+
+
+//
+// Scalar kernels, used when nothing better is available
+//
+
+#define ARRAY_SEARCH_SCALAR_KERNEL(name, type)                                  \
+	static void name(const char* data, size_t blocks, const void* value, uint64_t* masks){  \
+		type v = *(const type*)value;                                           \
+		for(size_t b = 0; b < blocks; b++) {                                    \
+			const type* elements = (const type*)(data + b * ARRAY_SEARCH_BLOCK);  \
+			uint64_t mask = 0;                                                  \
+			for(size_t i = 0; i < ARRAY_SEARCH_BLOCK / sizeof(type); i++)       \
+				mask |= (uint64_t)(elements[i] == v) << i;                      \
+			masks[b] = mask;                                                    \
+		}                                                                       \
+	}
+
+ARRAY_SEARCH_SCALAR_KERNEL(scalar_int8,   int8_t)
+ARRAY_SEARCH_SCALAR_KERNEL(scalar_int16,  int16_t)
+ARRAY_SEARCH_SCALAR_KERNEL(scalar_int32,  int32_t)
+ARRAY_SEARCH_SCALAR_KERNEL(scalar_int64,  int64_t)
+ARRAY_SEARCH_SCALAR_KERNEL(scalar_float,  float)
+ARRAY_SEARCH_SCALAR_KERNEL(scalar_double, double)
+
+
+#ifdef ARRAY_SEARCH_X86
+
+//
+// SSE2 kernels, four 16 byte vectors per block
+//
+
+__attribute__((target("sse2")))
+static void sse2_int8(const char* data, size_t blocks, const void* value, uint64_t* masks){
+	__m128i v = _mm_set1_epi8(*(const int8_t*)value);
+	for(size_t b = 0; b < blocks; b++) {
+		const __m128i* p = (const __m128i*)(data + b * ARRAY_SEARCH_BLOCK);
+		uint64_t mask = 0;
+		for(size_t i = 0; i < 4; i++)
+			mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(p + i), v)) << (i * 16);
+		masks[b] = mask;
+	}
+}
+
+__attribute__((target("sse2")))
+static void sse2_int16(const char* data, size_t blocks, const void* value, uint64_t* masks){
+	__m128i v = _mm_set1_epi16(*(const int16_t*)value);
+	for(size_t b = 0; b < blocks; b++) {
+		const __m128i* p = (const __m128i*)(data + b * ARRAY_SEARCH_BLOCK);
+		uint64_t mask = 0;
+		for(size_t i = 0; i < 2; i++) {
+			// Pack the 16 bit compare results to bytes so movemask yields one bit per element
+			__m128i c0 = _mm_cmpeq_epi16(_mm_loadu_si128(p + i * 2 + 0), v);
+			__m128i c1 = _mm_cmpeq_epi16(_mm_loadu_si128(p + i * 2 + 1), v);
+			mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_packs_epi16(c0, c1)) << (i * 16);
+		}
+		masks[b] = mask;
+	}
+}
+
+__attribute__((target("sse2")))
+static void sse2_int32(const char* data, size_t blocks, const void* value, uint64_t* masks){
+	__m128i v = _mm_set1_epi32(*(const int32_t*)value);
+	for(size_t b = 0; b < blocks; b++) {
+		const __m128i* p = (const __m128i*)(data + b * ARRAY_SEARCH_BLOCK);
+		uint64_t mask = 0;
+		for(size_t i = 0; i < 4; i++)
+			mask |= (uint64_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_loadu_si128(p + i), v))) << (i * 4);
+		masks[b] = mask;
+	}
+}
+
+__attribute__((target("sse2")))
+static void sse2_int64(const char* data, size_t blocks, const void* value, uint64_t* masks){
+	__m128i v = _mm_set1_epi64x(*(const int64_t*)value);
+	for(size_t b = 0; b < blocks; b++) {
+		const __m128i* p = (const __m128i*)(data + b * ARRAY_SEARCH_BLOCK);
+		uint64_t mask = 0;
+		for(size_t i = 0; i < 4; i++) {
+			// SSE2 has no 64 bit compare, both 32 bit halves have to be equal
+			__m128i c = _mm_cmpeq_epi32(_mm_loadu_si128(p + i), v);
+			c = _mm_and_si128(c, _mm_shuffle_epi32(c, _MM_SHUFFLE(2, 3, 0, 1)));
+			mask |= (uint64_t)_mm_movemask_pd(_mm_castsi128_pd(c)) << (i * 2);
+		}
+		masks[b] = mask;
+	}
+}
+
+__attribute__((target("sse2")))
+static void sse2_float(const char* data, size_t blocks, const void* value, uint64_t* masks){
+	__m128 v = _mm_set1_ps(*(const float*)value);
+	for(size_t b = 0; b < blocks; b++) {
+		const float* p = (const float*)(data + b * ARRAY_SEARCH_BLOCK);
+		uint64_t mask = 0;
+		for(size_t i = 0; i < 4; i++)
+			mask |= (uint64_t)_mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(p + i * 4), v)) << (i * 4);
+		masks[b] = mask;
+	}
+}
+
+__attribute__((target("sse2")))
+static void sse2_double(const char* data, size_t blocks, const void* value, uint64_t* masks){
+	__m128d v = _mm_set1_pd(*(const double*)value);
+	for(size_t b = 0; b < blocks; b++) {
+		const double* p = (const double*)(data + b * ARRAY_SEARCH_BLOCK);
+		uint64_t mask = 0;
+		for(size_t i = 0; i < 4; i++)
+			mask |= (uint64_t)_mm_movemask_pd(_mm_cmpeq_pd(_mm_loadu_pd(p + i * 2), v)) << (i * 2);
+		masks[b] = mask;
+	}
+}
+
+
+//
+// AVX2 kernels, two 32 byte vectors per block
+//
+
+__attribute__((target("avx2")))
+static void avx2_int8(const char* data, size_t blocks, const void* value, uint64_t* masks){
+	__m256i v = _mm256_set1_epi8(*(const int8_t*)value);
+	for(size_t b = 0; b < blocks; b++) {
+		const __m256i* p = (const __m256i*)(data + b * ARRAY_SEARCH_BLOCK);
+		uint64_t lo = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(p + 0), v));
+		uint64_t hi = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(p + 1), v));
+		masks[b] = lo | hi << 32;
+	}
+}
+
+__attribute__((target("avx2")))
+static void avx2_int16(const char* data, size_t blocks, const void* value, uint64_t* masks){
+	__m256i v = _mm256_set1_epi16(*(const int16_t*)value);
+	for(size_t b = 0; b < blocks; b++) {
+		const __m256i* p = (const __m256i*)(data + b * ARRAY_SEARCH_BLOCK);
+		__m256i c0 = _mm256_cmpeq_epi16(_mm256_loadu_si256(p + 0), v);
+		__m256i c1 = _mm256_cmpeq_epi16(_mm256_loadu_si256(p + 1), v);
+		// Packing works per 128 bit lane, the permute puts the 64 bit quarters back in order
+		__m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(c0, c1), _MM_SHUFFLE(3, 1, 2, 0));
+		masks[b] = (uint32_t)_mm256_movemask_epi8(packed);
+	}
+}
+
+__attribute__((target("avx2")))
+static void avx2_int32(const char* data, size_t blocks, const void* value, uint64_t* masks){
+	__m256i v = _mm256_set1_epi32(*(const int32_t*)value);
+	for(size_t b = 0; b < blocks; b++) {
+		const __m256i* p = (const __m256i*)(data + b * ARRAY_SEARCH_BLOCK);
+		uint64_t lo = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_loadu_si256(p + 0), v)));
+		uint64_t hi = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_loadu_si256(p + 1), v)));
+		masks[b] = lo | hi << 8;
+	}
+}
+
+__attribute__((target("avx2")))
+static void avx2_int64(const char* data, size_t blocks, const void* value, uint64_t* masks){
+	__m256i v = _mm256_set1_epi64x(*(const int64_t*)value);
+	for(size_t b = 0; b < blocks; b++) {
+		const __m256i* p = (const __m256i*)(data + b * ARRAY_SEARCH_BLOCK);
+		uint64_t lo = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_loadu_si256(p + 0), v)));
+		uint64_t hi = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_loadu_si256(p + 1), v)));
+		masks[b] = lo | hi << 4;
+	}
+}
+
+__attribute__((target("avx2")))
+static void avx2_float(const char* data, size_t blocks, const void* value, uint64_t* masks){
+	__m256 v = _mm256_set1_ps(*(const float*)value);
+	for(size_t b = 0; b < blocks; b++) {
+		const float* p = (const float*)(data + b * ARRAY_SEARCH_BLOCK);
+		uint64_t lo = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(p + 0), v, _CMP_EQ_OQ));
+		uint64_t hi = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(p + 8), v, _CMP_EQ_OQ));
+		masks[b] = lo | hi << 8;
+	}
+}
+
+__attribute__((target("avx2")))
+static void avx2_double(const char* data, size_t blocks, const void* value, uint64_t* masks){
+	__m256d v = _mm256_set1_pd(*(const double*)value);
+	for(size_t b = 0; b < blocks; b++) {
+		const double* p = (const double*)(data + b * ARRAY_SEARCH_BLOCK);
+		uint64_t lo = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(p + 0), v, _CMP_EQ_OQ));
+		uint64_t hi = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(p + 4), v, _CMP_EQ_OQ));
+		masks[b] = lo | hi << 4;
+	}
+}
+
+
+//
+// AVX-512 kernels, one block is one vector and the compare yields the mask directly
+//
+
+__attribute__((target("avx512f,avx512bw")))
+static void avx512_int8(const char* data, size_t blocks, const void* value, uint64_t* masks){
+	__m512i v = _mm512_set1_epi8(*(const int8_t*)value);
+	for(size_t b = 0; b < blocks; b++)
+		masks[b] = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(data + b * ARRAY_SEARCH_BLOCK), v);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void avx512_int16(const char* data, size_t blocks, const void* value, uint64_t* masks){
+	__m512i v = _mm512_set1_epi16(*(const int16_t*)value);
+	for(size_t b = 0; b < blocks; b++)
+		masks[b] = _mm512_cmpeq_epi16_mask(_mm512_loadu_si512(data + b * ARRAY_SEARCH_BLOCK), v);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void avx512_int32(const char* data, size_t blocks, const void* value, uint64_t* masks){
+	__m512i v = _mm512_set1_epi32(*(const int32_t*)value);
+	for(size_t b = 0; b < blocks; b++)
+		masks[b] = _mm512_cmpeq_epi32_mask(_mm512_loadu_si512(data + b * ARRAY_SEARCH_BLOCK), v);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void avx512_int64(const char* data, size_t blocks, const void* value, uint64_t* masks){
+	__m512i v = _mm512_set1_epi64(*(const int64_t*)value);
+	for(size_t b = 0; b < blocks; b++)
+		masks[b] = _mm512_cmpeq_epi64_mask(_mm512_loadu_si512(data + b * ARRAY_SEARCH_BLOCK), v);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void avx512_float(const char* data, size_t blocks, const void* value, uint64_t* masks){
+	__m512 v = _mm512_set1_ps(*(const float*)value);
+	for(size_t b = 0; b < blocks; b++)
+		masks[b] = _mm512_cmp_ps_mask(_mm512_loadu_ps(data + b * ARRAY_SEARCH_BLOCK), v, _CMP_EQ_OQ);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void avx512_double(const char* data, size_t blocks, const void* value, uint64_t* masks){
+	__m512d v = _mm512_set1_pd(*(const double*)value);
+	for(size_t b = 0; b < blocks; b++)
+		masks[b] = _mm512_cmp_pd_mask(_mm512_loadu_pd(data + b * ARRAY_SEARCH_BLOCK), v, _CMP_EQ_OQ);
+}
+
+#endif
+
+
+//
+// Dispatch
+//
+
+// Equality doesn't care about the sign, unsigned types use the kernels of the signed ones
+#define ARRAY_SEARCH_KERNELS(prefix)  {                             \
+	[ARRAY_INT8]  = prefix##_int8,  [ARRAY_UINT8]  = prefix##_int8,   \
+	[ARRAY_INT16] = prefix##_int16, [ARRAY_UINT16] = prefix##_int16,  \
+	[ARRAY_INT32] = prefix##_int32, [ARRAY_UINT32] = prefix##_int32,  \
+	[ARRAY_INT64] = prefix##_int64, [ARRAY_UINT64] = prefix##_int64,  \
+	[ARRAY_FLOAT] = prefix##_float, [ARRAY_DOUBLE] = prefix##_double, \
+}
+
+static const array_search_kernel_t array_search_kernels[][ARRAY_RECORD] = {
+	[ARRAY_SEARCH_SCALAR] = ARRAY_SEARCH_KERNELS(scalar),
+#ifdef ARRAY_SEARCH_X86
+	[ARRAY_SEARCH_SSE2]   = ARRAY_SEARCH_KERNELS(sse2),
+	[ARRAY_SEARCH_AVX2]   = ARRAY_SEARCH_KERNELS(avx2),
+	[ARRAY_SEARCH_AVX512] = ARRAY_SEARCH_KERNELS(avx512),
+#endif
+};
+
+static array_search_isa_t array_search_isa_limit = ARRAY_SEARCH_AVX512;
+
+/**
+ * __builtin_cpu_supports() only reads a variable initialized at startup so it's cheap
+ * enough to check on every search.
+ */
+array_search_isa_t array_search_isa(){
+	array_search_isa_t isa = ARRAY_SEARCH_SCALAR;
+
+#ifdef ARRAY_SEARCH_X86
+	if ( __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") )
+		isa = ARRAY_SEARCH_AVX512;
+	else if ( __builtin_cpu_supports("avx2") )
+		isa = ARRAY_SEARCH_AVX2;
+	else if ( __builtin_cpu_supports("sse2") )
+		isa = ARRAY_SEARCH_SSE2;
+#endif
+
+	return (isa < array_search_isa_limit) ? isa : array_search_isa_limit;
+}
+
+/**
+ * Not thread safe, call it before other threads start searching.
+ */
+void array_search_limit_isa(array_search_isa_t isa){
+	array_search_isa_limit = isa;
+}
+
+
+//
+// Search functions
+//
+
+/**
+ * Fills `masks` for `count` blocks starting at block `first`. The last block of an array
+ * can be only partially filled. It's copied into a zeroed buffer so the kernel never
+ * reads past the end of the data and the bits of the missing elements are cleared.
+ */
+static void array_search_blocks(array_p array, array_search_kernel_t kernel, size_t elements_per_block, size_t first, size_t count, const void* value, uint64_t* masks){
+	const char* data = array->data;
+	size_t full_blocks = array->length / elements_per_block;
+	size_t full = (first + count <= full_blocks) ? count : full_blocks - first;
+	
+	if (full > 0)
+		kernel(data + first * ARRAY_SEARCH_BLOCK, full, value, masks);
+	
+	if (full < count) {
+		size_t remaining = array->length - (first + full) * elements_per_block;
+		uint64_t buffer[ARRAY_SEARCH_BLOCK / sizeof(uint64_t)] = { 0 };
+		memcpy(buffer, data + (first + full) * ARRAY_SEARCH_BLOCK, remaining * array->element_size);
+		kernel((const char*)buffer, 1, value, masks + full);
+		masks[full] &= ((uint64_t)1 << remaining) - 1;
+	}
+}
+
+/**
+ * Records are compared one after the other with memcmp(), there's no fixed number of
+ * them in a block.
+ */
+static ssize_t array_search_records(array_p array, const void* value, array_search_mode_t mode, array_p indices){
+	const char* data = array->data;
+	size_t size = array->element_size, matches = 0;
+	
+	if (mode == ARRAY_SEARCH_LAST) {
+		for(size_t index = array->length; index > 0; index--) {
+			if ( memcmp(data + (index - 1) * size, value, size) == 0 )
+				return index - 1;
+		}
+		return -1;
+	}
+	
+	for(size_t index = 0; index < array->length; index++) {
+		if ( memcmp(data + index * size, value, size) != 0 )
+			continue;
+		
+		if (mode == ARRAY_SEARCH_FIRST)
+			return index;
+		if (mode == ARRAY_SEARCH_ALL)
+			array_append(indices, size_t, index);
+		matches++;
+	}
+	
+	return (mode == ARRAY_SEARCH_FIRST) ? -1 : (ssize_t)matches;
+}
+
+/**
+ * Returns the index of the found element (or -1) for ARRAY_SEARCH_FIRST and
+ * ARRAY_SEARCH_LAST and the number of matches for ARRAY_SEARCH_COUNT and ARRAY_SEARCH_ALL.
+ */
+static ssize_t array_search(array_p array, array_elem_type_t type, const void* value, array_search_mode_t mode, array_p indices){
+	if (type == ARRAY_RECORD)
+		return array_search_records(array, value, mode, indices);
+	
+	array_search_kernel_t kernel = array_search_kernels[array_search_isa()][type];
+	size_t elements_per_block = ARRAY_SEARCH_BLOCK / array_search_type_sizes[type];
+	size_t blocks = (array->length + elements_per_block - 1) / elements_per_block;
+	uint64_t masks[ARRAY_SEARCH_CHUNK];
+	
+	if (mode == ARRAY_SEARCH_LAST) {
+		size_t count = 0;
+		for(size_t end = blocks; end > 0; end -= count) {
+			count = (end < ARRAY_SEARCH_CHUNK) ? end : ARRAY_SEARCH_CHUNK;
+			array_search_blocks(array, kernel, elements_per_block, end - count, count, value, masks);
+			for(size_t i = count; i > 0; i--) {
+				if (masks[i - 1] != 0)
+					return (end - count + i - 1) * elements_per_block + 63 - __builtin_clzll(masks[i - 1]);
+			}
+		}
+		return -1;
+	}
+	
+	size_t matches = 0, count = 0;
+	for(size_t first = 0; first < blocks; first += count) {
+		count = (blocks - first < ARRAY_SEARCH_CHUNK) ? blocks - first : ARRAY_SEARCH_CHUNK;
+		array_search_blocks(array, kernel, elements_per_block, first, count, value, masks);
+		
+		for(size_t i = 0; i < count; i++) {
+			uint64_t mask = masks[i];
+			if (mask == 0)
+				continue;
+			
+			size_t base = (first + i) * elements_per_block;
+			if (mode == ARRAY_SEARCH_FIRST)
+				return base + __builtin_ctzll(mask);
+			
+			matches += __builtin_popcountll(mask);
+			if (mode == ARRAY_SEARCH_ALL) {
+				for(; mask != 0; mask &= mask - 1)
+					array_append(indices, size_t, base + __builtin_ctzll(mask));
+			}
+		}
+	}
+	
+	return (mode == ARRAY_SEARCH_FIRST) ? -1 : (ssize_t)matches;
+}
+
+ssize_t array_find_first(array_p array, array_elem_type_t type, const void* value){
+	return array_search(array, type, value, ARRAY_SEARCH_FIRST, NULL);
+}
+
+ssize_t array_find_last(array_p array, array_elem_type_t type, const void* value){
+	return array_search(array, type, value, ARRAY_SEARCH_LAST, NULL);
+}
+
+size_t array_count(array_p array, array_elem_type_t type, const void* value){
+	return array_search(array, type, value, ARRAY_SEARCH_COUNT, NULL);
+}
+
+size_t array_find_all(array_p array, array_elem_type_t type, const void* value, array_p indices){
+	return array_search(array, type, value, ARRAY_SEARCH_ALL, indices);
+}
+
+
+//
+// Sorted arrays
+//
+
+/**
+ * Branchless binary search: The range always shrinks to its upper half, the compare
+ * only decides if the base moves. This compiles to a conditional move instead of a
+ * branch that is mispredicted half of the time. Both possible elements of the next step
+ * are prefetched so the memory latency of large arrays overlaps with the current step.
+ * 
+ * The Eytzinger search walks down the implicit tree, the children of k are 2k and 2k + 1.
+ * The prefetch loads the cache line with the 16 descendants of k four levels down (less
+ * for larger keys), the whole line is used by the next levels. At the end the
+ * lower bound is the last node where we went left. It is found by removing the trailing
+ * ones (right turns) and the final left turn from k.
+ */
+#define ARRAY_SEARCH_SORTED_FUNCS(suffix, type)                                                    \
+	static size_t array_bound_##suffix(const void* data, size_t length, const void* value, bool upper){  \
+		const type* first = data;                                                                  \
+		const type* base = first;                                                                  \
+		type x = *(const type*)value;                                                              \
+		if (length == 0)                                                                           \
+			return 0;                                                                              \
+		                                                                                           \
+		for(size_t n = length; n > 1; ) {                                                          \
+			size_t half = n / 2;                                                                   \
+			__builtin_prefetch(base + (n - half) / 2);                                             \
+			__builtin_prefetch(base + half + (n - half) / 2);                                      \
+			bool before = (base[half - 1] < x) | (upper & (base[half - 1] == x));                  \
+			base += before * half;                                                                 \
+			n -= half;                                                                             \
+		}                                                                                          \
+		                                                                                           \
+		return (base - first) + ((*base < x) | (upper & (*base == x)));                            \
+	}                                                                                              \
+	                                                                                               \
+	static size_t array_eytzinger_search_##suffix(const void* keys, size_t length, const void* value){  \
+		const type* b = keys;                                                                      \
+		type x = *(const type*)value;                                                              \
+		size_t k = 1;                                                                              \
+		while (k <= length) {                                                                      \
+			__builtin_prefetch(b + k * (64 / sizeof(type)));                                       \
+			k = 2 * k + (b[k] < x);                                                                \
+		}                                                                                          \
+		return k >> __builtin_ffsll(~k);                                                           \
+	}
+
+ARRAY_SEARCH_SORTED_FUNCS(int8,   int8_t)
+ARRAY_SEARCH_SORTED_FUNCS(int16,  int16_t)
+ARRAY_SEARCH_SORTED_FUNCS(int32,  int32_t)
+ARRAY_SEARCH_SORTED_FUNCS(int64,  int64_t)
+ARRAY_SEARCH_SORTED_FUNCS(uint8,  uint8_t)
+ARRAY_SEARCH_SORTED_FUNCS(uint16, uint16_t)
+ARRAY_SEARCH_SORTED_FUNCS(uint32, uint32_t)
+ARRAY_SEARCH_SORTED_FUNCS(uint64, uint64_t)
+ARRAY_SEARCH_SORTED_FUNCS(float,  float)
+ARRAY_SEARCH_SORTED_FUNCS(double, double)
+
+typedef size_t (*array_bound_func_t)(const void* data, size_t length, const void* value, bool upper);
+typedef size_t (*array_eytzinger_search_func_t)(const void* keys, size_t length, const void* value);
+
+#define ARRAY_SEARCH_SORTED_TABLE(prefix)  {                      \
+	[ARRAY_INT8]   = prefix##_int8,   [ARRAY_UINT8]  = prefix##_uint8,   \
+	[ARRAY_INT16]  = prefix##_int16,  [ARRAY_UINT16] = prefix##_uint16,  \
+	[ARRAY_INT32]  = prefix##_int32,  [ARRAY_UINT32] = prefix##_uint32,  \
+	[ARRAY_INT64]  = prefix##_int64,  [ARRAY_UINT64] = prefix##_uint64,  \
+	[ARRAY_FLOAT]  = prefix##_float,  [ARRAY_DOUBLE] = prefix##_double,  \
+}
+
+static const array_bound_func_t array_bound_funcs[ARRAY_RECORD] = ARRAY_SEARCH_SORTED_TABLE(array_bound);
+static const array_eytzinger_search_func_t array_eytzinger_search_funcs[ARRAY_RECORD] = ARRAY_SEARCH_SORTED_TABLE(array_eytzinger_search);
+
+size_t array_lower_bound(array_p array, array_elem_type_t type, const void* value){
+	if (type >= ARRAY_RECORD)
+		return array->length;
+	return array_bound_funcs[type](array->data, array->length, value, false);
+}
+
+size_t array_upper_bound(array_p array, array_elem_type_t type, const void* value){
+	if (type >= ARRAY_RECORD)
+		return array->length;
+	return array_bound_funcs[type](array->data, array->length, value, true);
+}
+
+size_t array_equal_range(array_p array, array_elem_type_t type, const void* value, size_t* start){
+	size_t lower = array_lower_bound(array, type, value);
+	size_t upper = array_upper_bound(array, type, value);
+	if (start != NULL)
+		*start = lower;
+	return upper - lower;
+}
+
+/**
+ * An in-order walk of the implicit tree visits the nodes in sorted order, so it takes
+ * the sorted elements one after the other.
+ */
+static size_t array_eytzinger_fill(array_eytzinger_p index, const char* sorted, size_t i, size_t k){
+	if (k > index->length)
+		return i;
+	
+	i = array_eytzinger_fill(index, sorted, i, 2 * k);
+	memcpy((char*)index->keys + k * index->key_size, sorted + i * index->key_size, index->key_size);
+	index->indices[k] = i;
+	return array_eytzinger_fill(index, sorted, i + 1, 2 * k + 1);
+}
+
+/**
+ * The keys start at index 1 and are aligned to a cache line. So the 64 / key_size
+ * descendants of a node a few levels down are all in the same cache line.
+ */
+array_eytzinger_p array_build_eytzinger(array_p sorted, array_elem_type_t type){
+	if (type >= ARRAY_RECORD)
+		return NULL;
+	
+	array_eytzinger_p index = malloc(sizeof(array_eytzinger_t));
+	if (index == NULL)
+		return NULL;
+	
+	index->type = type;
+	index->length = sorted->length;
+	index->key_size = array_search_type_sizes[type];
+	index->keys = NULL;
+	index->indices = malloc((index->length + 1) * sizeof(size_t));
+	if ( index->indices == NULL || posix_memalign(&index->keys, 64, (index->length + 1) * index->key_size) != 0 ) {
+		free(index->indices);
+		free(index);
+		return NULL;
+	}
+	
+	array_eytzinger_fill(index, sorted->data, 0, 1);
+	return index;
+}
+
+void array_eytzinger_destroy(array_eytzinger_p index){
+	free(index->keys);
+	free(index->indices);
+	free(index);
+}
+
+size_t array_eytzinger_lower_bound(array_eytzinger_p index, const void* value){
+	size_t k = array_eytzinger_search_funcs[index->type](index->keys, index->length, value);
+	return (k == 0) ? index->length : index->indices[k];
+}
\ No newline at end of file
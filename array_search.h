@@ -0,0 +1,91 @@
+#pragma once
+
+/**
+
+# Typed search in arrays of primitive types
+
+array_find() calls a function for every element and array_find_val() is a plain
+loop. The functions here know the element type and compare whole vectors of elements
+at once with SSE2, AVX2 or AVX-512 (picked at runtime, depending on what the CPU
+supports). On large arrays they are limited by memory bandwidth instead of the loop.
+
+The value is passed by pointer and has to be of the same type as the elements. Floats
+and doubles are compared with == (0.0 matches -0.0, NaN matches nothing). ARRAY_RECORD
+compares whole elements with memcmp(), e.g. for arrays of structs without padding.
+
+array_p a = array_of(int32_t);
+...
+ssize_t first = array_find_first(a, ARRAY_INT32, &(int32_t){ 42 });   // -1 if not found
+ssize_t last  = array_find_last(a, ARRAY_INT32, &(int32_t){ 42 });
+size_t  n     = array_count(a, ARRAY_INT32, &(int32_t){ 42 });
+
+// Appends the index of every match to an array of size_t
+array_p indices = array_of(size_t);
+array_find_all(a, ARRAY_INT32, &(int32_t){ 42 }, indices);
+
+
+## Sorted arrays
+
+Binary search without branches that prefetches the next steps. The bounds work like
+the ones of C++: The lower bound is the index of the first element >= value, the upper
+bound the one of the first element > value (the length if there is none).
+
+array_sort(ids, ARRAY_INT64, 0);
+size_t i = array_lower_bound(ids, ARRAY_INT64, &(int64_t){ 42 });
+bool found = (i < ids->length && array_elem(ids, int64_t, i) == 42);
+
+size_t start;
+size_t n = array_equal_range(ids, ARRAY_INT64, &(int64_t){ 42 }, &start);   // n elements == 42 at start
+
+For many lookups in large arrays an Eytzinger index is faster. It's a read-only copy of
+the keys in the order of a breadth first walk through the binary search tree, so the
+first levels share a few cache lines and the next levels can be prefetched. It maps
+values to indices in the sorted array. So it has to be rebuilt when the array changes.
+
+array_eytzinger_p index = array_build_eytzinger(ids, ARRAY_INT64);
+size_t i = array_eytzinger_lower_bound(index, &(int64_t){ 42 });   // same as array_lower_bound()
+array_eytzinger_destroy(index);
+
+*/
+
+#include <stddef.h>
+#include <sys/types.h>
+#include "array.h"
+
+
+// Instruction sets the search kernels can use, from slowest to fastest
+typedef enum {
+	ARRAY_SEARCH_SCALAR,
+	ARRAY_SEARCH_SSE2,
+	ARRAY_SEARCH_AVX2,
+	ARRAY_SEARCH_AVX512,
+} array_search_isa_t;
+
+ssize_t array_find_first(array_p array, array_elem_type_t type, const void* value);
+ssize_t array_find_last(array_p array, array_elem_type_t type, const void* value);
+size_t  array_count(array_p array, array_elem_type_t type, const void* value);
+// Appends the indices of all matching elements to `indices` (an array of size_t) and
+// returns the number of matches.
+size_t  array_find_all(array_p array, array_elem_type_t type, const void* value, array_p indices);
+
+// The instruction set used by the search functions. array_search_limit_isa() restricts
+// them to an older one, mostly for tests and benchmarks.
+array_search_isa_t array_search_isa();
+void               array_search_limit_isa(array_search_isa_t isa);
+
+// Sorted arrays, the elements have to be of the key type
+size_t  array_lower_bound(array_p array, array_elem_type_t type, const void* value);
+size_t  array_upper_bound(array_p array, array_elem_type_t type, const void* value);
+// Returns the number of elements equal to value, the first one is at `start`
+size_t  array_equal_range(array_p array, array_elem_type_t type, const void* value, size_t* start);
+
+typedef struct {
+	array_elem_type_t type;
+	size_t length, key_size;
+	void* keys;        // In Eytzinger order, starting at index 1
+	size_t* indices;   // Index in the sorted array for each key
+} array_eytzinger_t, *array_eytzinger_p;
+
+array_eytzinger_p array_build_eytzinger(array_p sorted, array_elem_type_t type);
+void              array_eytzinger_destroy(array_eytzinger_p index);
+size_t            array_eytzinger_lower_bound(array_eytzinger_p index, const void* value);
\ No newline at end of file
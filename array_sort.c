@@ -0,0 +1,322 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include "array_sort.h"
+
+// Length of the runs the merge sort sorts with insertion sort before merging them
+#define ARRAY_SORT_RUN_LENGTH  16
+// Don't split the array into parts smaller than this for threads
+#define ARRAY_SORT_MIN_PART    4096
+
+static const size_t array_sort_key_sizes[] = {
+	[ARRAY_INT8]   = sizeof(int8_t),
+	[ARRAY_INT16]  = sizeof(int16_t),
+	[ARRAY_INT32]  = sizeof(int32_t),
+	[ARRAY_INT64]  = sizeof(int64_t),
+	[ARRAY_UINT8]  = sizeof(uint8_t),
+	[ARRAY_UINT16] = sizeof(uint16_t),
+	[ARRAY_UINT32] = sizeof(uint32_t),
+	[ARRAY_UINT64] = sizeof(uint64_t),
+	[ARRAY_FLOAT]  = sizeof(float),
+	[ARRAY_DOUBLE] = sizeof(double),
+};
+
+
+//
+// Radix sort
+//
+
+static uint64_t array_sort_load_key(const char* key_ptr, size_t key_size){
+	switch(key_size) {
+		case 1:  { uint8_t  k; memcpy(&k, key_ptr, sizeof(k)); return k; }
+		case 2:  { uint16_t k; memcpy(&k, key_ptr, sizeof(k)); return k; }
+		case 4:  { uint32_t k; memcpy(&k, key_ptr, sizeof(k)); return k; }
+		default: { uint64_t k; memcpy(&k, key_ptr, sizeof(k)); return k; }
+	}
+}
+
+static void array_sort_store_key(char* key_ptr, size_t key_size, uint64_t key){
+	switch(key_size) {
+		case 1:  { uint8_t  k = key; memcpy(key_ptr, &k, sizeof(k)); break; }
+		case 2:  { uint16_t k = key; memcpy(key_ptr, &k, sizeof(k)); break; }
+		case 4:  { uint32_t k = key; memcpy(key_ptr, &k, sizeof(k)); break; }
+		default: { uint64_t k = key; memcpy(key_ptr, &k, sizeof(k)); break; }
+	}
+}
+
+/**
+ * Turns the keys into unsigned integers with the same order, in place. Signed integers
+ * get their sign bit flipped so negative numbers come first. Positive floats also get
+ * their sign bit flipped. For negative floats all bits are flipped, that reverses their
+ * order (a larger magnitude is smaller). With `decode` the original keys are restored.
+ * 
+ * The bytes of all keys are counted in the same pass.
+ */
+static void array_sort_encode_keys(array_p array, array_elem_type_t type, size_t key_offset, bool decode, size_t counts[][256]){
+	size_t key_size = array_sort_key_sizes[type];
+	uint64_t sign = (uint64_t)1 << (key_size * 8 - 1);
+	uint64_t all = (key_size == 8) ? ~(uint64_t)0 : ((uint64_t)1 << (key_size * 8)) - 1;
+	
+	for(size_t i = 0; i < array->length; i++) {
+		char* key_ptr = (char*)array->data + i * array->element_size + key_offset;
+		uint64_t key = array_sort_load_key(key_ptr, key_size);
+		
+		if (type == ARRAY_FLOAT || type == ARRAY_DOUBLE) {
+			// Encoded positive numbers have the sign bit set, negative ones not
+			bool negative = decode ? !(key & sign) : (key & sign);
+			key = negative ? ~key & all : key ^ sign;
+		} else if (type <= ARRAY_INT64) {
+			key ^= sign;
+		}
+		
+		array_sort_store_key(key_ptr, key_size, key);
+		if (counts != NULL) {
+			for(size_t b = 0; b < key_size; b++)
+				counts[b][(key >> (b * 8)) & 0xff]++;
+		}
+	}
+}
+
+// Moves each element of `src` to the next free place of its digit in `dest`
+#define ARRAY_SORT_SCATTER(copy)  do {                                       \
+	for(size_t i = 0; i < length; i++) {                                     \
+		const uint8_t* element = (const uint8_t*)src + i * size;             \
+		char* target = dest + offsets[element[digit_offset]]++ * size;       \
+		copy;                                                                \
+	}                                                                        \
+} while(0)
+
+/**
+ * LSD radix sort: The keys are encoded as unsigned integers, then the elements are
+ * distributed by one key byte after the other (least significant first) between the
+ * array data and a buffer. Each pass is stable so the order of the previous passes is
+ * kept for equal bytes. Afterwards the keys are decoded again.
+ */
+bool array_sort(array_p array, array_elem_type_t key_type, size_t key_offset){
+	size_t length = array->length, size = array->element_size;
+	if (length < 2 || key_type >= ARRAY_RECORD)
+		return true;
+	
+	char* buffer = malloc(length * size);
+	if (buffer == NULL)
+		return false;
+	
+	size_t key_size = array_sort_key_sizes[key_type];
+	size_t counts[sizeof(uint64_t)][256] = { { 0 } };
+	array_sort_encode_keys(array, key_type, key_offset, false, counts);
+	
+	char* src = array->data;
+	char* dest = buffer;
+	for(size_t b = 0; b < key_size; b++) {
+#		if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+		size_t digit_offset = key_offset + b;
+#		else
+		size_t digit_offset = key_offset + key_size - 1 - b;
+#		endif
+
+		// All keys have the same byte here, the pass wouldn't change anything
+		if (counts[b][(uint8_t)src[digit_offset]] == length)
+			continue;
+		
+		size_t offsets[256], offset = 0;
+		for(size_t digit = 0; digit < 256; digit++) {
+			offsets[digit] = offset;
+			offset += counts[b][digit];
+		}
+		
+		switch(size) {
+			case 1:  ARRAY_SORT_SCATTER( *(uint8_t*)target = *(const uint8_t*)element );    break;
+			case 2:  ARRAY_SORT_SCATTER( *(uint16_t*)target = *(const uint16_t*)element );  break;
+			case 4:  ARRAY_SORT_SCATTER( *(uint32_t*)target = *(const uint32_t*)element );  break;
+			case 8:  ARRAY_SORT_SCATTER( *(uint64_t*)target = *(const uint64_t*)element );  break;
+			default: ARRAY_SORT_SCATTER( memcpy(target, element, size) );
+		}
+		
+		char* swap = src;
+		src = dest;
+		dest = swap;
+	}
+	
+	if (src != array->data)
+		memcpy(array->data, src, length * size);
+	free(buffer);
+	
+	array_sort_encode_keys(array, key_type, key_offset, true, NULL);
+	return true;
+}
+
+
+//
+// Parallel merge sort
+//
+
+// Copies one element, most are small and memcpy() with a variable size is a function call
+static inline void array_sort_copy(char* dest, const char* src, size_t size){
+	switch(size) {
+		case 4:  { uint32_t e; memcpy(&e, src, 4); memcpy(dest, &e, 4); break; }
+		case 8:  { uint64_t e; memcpy(&e, src, 8); memcpy(dest, &e, 8); break; }
+		default: memcpy(dest, src, size);
+	}
+}
+
+/**
+ * Stable insertion sort. `temp` has to have space for one element.
+ */
+static void array_sort_insertion(char* data, size_t length, size_t size, array_compare_func_t compare, char* temp){
+	for(size_t i = 1; i < length; i++) {
+		if ( compare(data + (i - 1) * size, data + i * size) <= 0 )
+			continue;
+		
+		array_sort_copy(temp, data + i * size, size);
+		size_t j = i;
+		for(; j > 0 && compare(data + (j - 1) * size, temp) > 0; j--)
+			array_sort_copy(data + j * size, data + (j - 1) * size, size);
+		array_sort_copy(data + j * size, temp, size);
+	}
+}
+
+/**
+ * Merges the sorted ranges [start, middle) and [middle, end) of `src` into the same range
+ * of `dest`. On equal elements the one of the left range comes first.
+ */
+static void array_sort_merge(const char* src, char* dest, size_t start, size_t middle, size_t end, size_t size, array_compare_func_t compare){
+	// Already in order, e.g. for presorted arrays
+	if (start == middle || middle == end || compare(src + (middle - 1) * size, src + middle * size) <= 0) {
+		memcpy(dest + start * size, src + start * size, (end - start) * size);
+		return;
+	}
+	
+	size_t i = start, j = middle, k = start;
+	while (i < middle && j < end) {
+		if ( compare(src + j * size, src + i * size) < 0 )
+			array_sort_copy(dest + k++ * size, src + j++ * size, size);
+		else
+			array_sort_copy(dest + k++ * size, src + i++ * size, size);
+	}
+	
+	memcpy(dest + k * size, src + i * size, (middle - i) * size);
+	k += middle - i;
+	memcpy(dest + k * size, src + j * size, (end - j) * size);
+}
+
+/**
+ * Bottom up merge sort of `length` elements. Runs are sorted with insertion sort, then
+ * merged back and forth between the data and the buffer. The result is in `data`.
+ */
+static void array_sort_merge_sort(char* data, char* buffer, size_t length, size_t size, array_compare_func_t compare){
+	// The buffer isn't used yet so it can hold the temporary element of the insertion sort
+	for(size_t start = 0; start < length; start += ARRAY_SORT_RUN_LENGTH) {
+		size_t run = (length - start < ARRAY_SORT_RUN_LENGTH) ? length - start : ARRAY_SORT_RUN_LENGTH;
+		array_sort_insertion(data + start * size, run, size, compare, buffer);
+	}
+	
+	char* src = data;
+	char* dest = buffer;
+	for(size_t width = ARRAY_SORT_RUN_LENGTH; width < length; width *= 2) {
+		for(size_t start = 0; start < length; start += 2 * width) {
+			size_t middle = (start + width < length) ? start + width : length;
+			size_t end = (start + 2 * width < length) ? start + 2 * width : length;
+			array_sort_merge(src, dest, start, middle, end, size, compare);
+		}
+		
+		char* swap = src;
+		src = dest;
+		dest = swap;
+	}
+	
+	if (src != data)
+		memcpy(data, src, length * size);
+}
+
+typedef struct {
+	char *src, *dest;
+	size_t start, middle, end, size;
+	array_compare_func_t compare;
+	pthread_t thread;
+	bool started;
+} array_sort_task_t;
+
+static void* array_sort_part_worker(void* arg){
+	array_sort_task_t* task = arg;
+	array_sort_merge_sort(task->src + task->start * task->size, task->dest + task->start * task->size, task->end - task->start, task->size, task->compare);
+	return NULL;
+}
+
+static void* array_sort_merge_worker(void* arg){
+	array_sort_task_t* task = arg;
+	array_sort_merge(task->src, task->dest, task->start, task->middle, task->end, task->size, task->compare);
+	return NULL;
+}
+
+/**
+ * Runs the tasks in parallel, the first one on the calling thread. Tasks whose thread
+ * couldn't be started are run on the calling thread as well.
+ */
+static void array_sort_run_tasks(array_sort_task_t* tasks, size_t count, void* (*worker)(void*)){
+	for(size_t i = 1; i < count; i++)
+		tasks[i].started = pthread_create(&tasks[i].thread, NULL, worker, &tasks[i]) == 0;
+	
+	worker(&tasks[0]);
+	
+	for(size_t i = 1; i < count; i++) {
+		if (tasks[i].started)
+			pthread_join(tasks[i].thread, NULL);
+		else
+			worker(&tasks[i]);
+	}
+}
+
+/**
+ * The array is split into one part per thread and each thread merge sorts its part.
+ * Then neighbouring parts are merged in rounds, with one thread per pair of parts, until
+ * only one part is left. Each round moves all elements from the data to the buffer or
+ * back again.
+ */
+bool array_sort_func(array_p array, array_compare_func_t compare, size_t threads){
+	size_t length = array->length, size = array->element_size;
+	if (length < 2)
+		return true;
+	
+	char* buffer = malloc(length * size);
+	if (buffer == NULL)
+		return false;
+	
+	size_t parts = (threads > 1) ? threads : 1;
+	if (parts > length / ARRAY_SORT_MIN_PART)
+		parts = (length / ARRAY_SORT_MIN_PART > 1) ? length / ARRAY_SORT_MIN_PART : 1;
+	
+	array_sort_task_t single_task;
+	array_sort_task_t* tasks = (parts > 1) ? malloc(parts * sizeof(array_sort_task_t)) : NULL;
+	if (tasks == NULL) {
+		parts = 1;
+		tasks = &single_task;
+	}
+	
+	for(size_t p = 0; p < parts; p++)
+		tasks[p] = (array_sort_task_t){ array->data, buffer, length * p / parts, 0, length * (p + 1) / parts, size, compare, pthread_self(), false };
+	array_sort_run_tasks(tasks, parts, array_sort_part_worker);
+	
+	char* src = array->data;
+	char* dest = buffer;
+	for(size_t width = 1; width < parts; width *= 2) {
+		size_t merges = 0;
+		for(size_t p = 0; p < parts; p += 2 * width) {
+			size_t middle_part = (p + width < parts) ? p + width : parts;
+			size_t end_part = (p + 2 * width < parts) ? p + 2 * width : parts;
+			tasks[merges++] = (array_sort_task_t){ src, dest, length * p / parts, length * middle_part / parts, length * end_part / parts, size, compare, pthread_self(), false };
+		}
+		array_sort_run_tasks(tasks, merges, array_sort_merge_worker);
+		
+		char* swap = src;
+		src = dest;
+		dest = swap;
+	}
+	
+	if (src != array->data)
+		memcpy(array->data, src, length * size);
+	if (tasks != &single_task)
+		free(tasks);
+	free(buffer);
+	return true;
+}
\ No newline at end of file
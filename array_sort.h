@@ -0,0 +1,46 @@
+#pragma once
+
+/**
+
+# Sorting arrays
+
+array_sort() sorts by a number in each element with a stable LSD radix sort, one pass
+per key byte. Passes where all keys have the same byte are skipped. The key is either
+the element itself (offset 0) or a field of a struct. Floats and doubles are sorted
+numerically with -0.0 before 0.0. NaNs with the sign bit set go to the start, all
+other NaNs to the end.
+
+array_p ids = array_of(uint64_t);
+...
+array_sort(ids, ARRAY_UINT64, 0);
+
+typedef struct { char name[16]; double score; } player_t;
+array_p players = array_of(player_t);
+...
+array_sort_by(players, player_t, score, ARRAY_DOUBLE);
+
+array_sort_func() sorts with a qsort() comparison function and works for everything
+else. It's a stable merge sort, with `threads` threads sorting and merging parts of the
+array in parallel (0 or 1 sorts on the calling thread only).
+
+int compare_names(const void* a, const void* b){
+	return strcmp( ((player_t*)a)->name, ((player_t*)b)->name );
+}
+array_sort_func(players, compare_names, 4);
+
+Both need a temporary buffer as large as the array and return false if it can't be
+allocated. The array is unchanged then.
+
+*/
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "array.h"
+
+
+typedef int (*array_compare_func_t)(const void* a, const void* b);
+
+#define array_sort_by(array, type, field, key_type)  array_sort(array, key_type, offsetof(type, field))
+
+bool array_sort(array_p array, array_elem_type_t key_type, size_t key_offset);
+bool array_sort_func(array_p array, array_compare_func_t compare, size_t threads);
\ No newline at end of file
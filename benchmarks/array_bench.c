@@ -0,0 +1,63 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include "../array.h"
+
+/**
+ * Measures append throughput and peak resident memory of arrays with malloc() and
+ * mmap() storage, each with and without reserving the final capacity up front. Every
+ * run happens in its own child process so the peak RSS of one run doesn't hide the one
+ * of the next.
+ * 
+ * Usage: array_bench [elements]
+ */
+
+static double now(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void run_bench(const char* name, array_storage_t storage, bool reserve, size_t elements){
+	// Flush first, otherwise the child inherits and prints the buffered output again
+	fflush(stdout);
+	pid_t pid = fork();
+	if (pid == 0) {
+		double start = now();
+		array_p array = (storage == ARRAY_MMAP) ? array_of_mmap(uint64_t) : array_of(uint64_t);
+		if (reserve)
+			array_reserve(array, elements);
+		for(size_t i = 0; i < elements; i++)
+			array_append(array, uint64_t, i);
+		double elapsed = now() - start;
+		
+		printf("%-16s %14.0f %10.3f", name, elements / elapsed, elapsed);
+		fflush(stdout);
+		array_destroy(array);
+		_exit(0);
+	}
+	
+	int status = 0;
+	struct rusage usage;
+	wait4(pid, &status, 0, &usage);
+	printf(" %12ld\n", usage.ru_maxrss / 1024);
+}
+
+int main(int argc, char** argv){
+	size_t elements = (argc > 1) ? strtoul(argv[1], NULL, 10) : 64 * 1024 * 1024;
+	
+	printf("%zu uint64_t appends (%zu MiB of data)\n", elements, elements * sizeof(uint64_t) / (1024 * 1024));
+	printf("%-16s %14s %10s %12s\n", "storage", "appends/s", "seconds", "peak RSS MiB");
+	run_bench("malloc", ARRAY_MALLOC, false, elements);
+	run_bench("malloc reserved", ARRAY_MALLOC, true, elements);
+	run_bench("mmap", ARRAY_MMAP, false, elements);
+	run_bench("mmap reserved", ARRAY_MMAP, true, elements);
+	
+	return 0;
+}
\ No newline at end of file
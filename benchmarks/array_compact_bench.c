@@ -0,0 +1,97 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "../array.h"
+
+/**
+ * Measures how fast uint32_t rows are filtered with different fractions of removed rows:
+ * The old compaction (predicate called twice, memcpy() per element), array_remove_func()
+ * (predicate called once, mask based compaction) and array_remove_mask() with a mask
+ * built beforehand.
+ * 
+ * Usage: array_compact_bench [elements]
+ */
+
+static double now(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint32_t removed_below = 0;
+
+static bool is_removed(array_p array, size_t index){
+	return array_elem(array, uint32_t, index) < removed_below;
+}
+
+// array_compact_threshold() before it used masks
+static void old_compact(array_p array, size_t empty_elements_threshold, array_elem_func_t is_empty_function){
+	size_t empty_elements = 0;
+	for(size_t index = 0; index < array->length; index++) {
+		if ( is_empty_function(array, index) && ++empty_elements >= empty_elements_threshold )
+			break;
+	}
+	if (empty_elements < empty_elements_threshold)
+		return;
+	
+	size_t compacted_index = 0;
+	for(size_t index = 0; index < array->length; index++) {
+		if ( !is_empty_function(array, index) ) {
+			if (index != compacted_index)
+				memcpy((char*)array->data + compacted_index * array->element_size, (char*)array->data + index * array->element_size, array->element_size);
+			compacted_index++;
+		}
+	}
+	array_resize(array, compacted_index);
+}
+
+static array_p random_rows(size_t elements){
+	array_p array = array_with(elements, uint32_t);
+	uint64_t random = 1;
+	for(size_t i = 0; i < elements; i++) {
+		random = random * 6364136223846793005 + 1442695040888963407;
+		array_elem(array, uint32_t, i) = random >> 32;
+	}
+	return array;
+}
+
+int main(int argc, char** argv){
+	size_t elements = (argc > 1) ? strtoul(argv[1], NULL, 10) : 16 * 1024 * 1024;
+	double removed_fractions[] = { 0.01, 0.5, 0.99 };
+	
+	printf("filtering %zu uint32_t rows, million rows per second\n", elements);
+	printf("%-10s %14s %18s %18s\n", "removed", "old", "array_remove_func", "array_remove_mask");
+	
+	for(size_t f = 0; f < sizeof(removed_fractions) / sizeof(removed_fractions[0]); f++) {
+		removed_below = removed_fractions[f] * UINT32_MAX;
+		
+		array_p array = random_rows(elements);
+		double start = now();
+		old_compact(array, 2, is_removed);
+		double old_time = now() - start;
+		array_destroy(array);
+		
+		array = random_rows(elements);
+		start = now();
+		array_remove_func(array, is_removed);
+		double func_time = now() - start;
+		array_destroy(array);
+		
+		array = random_rows(elements);
+		uint64_t* mask = malloc((elements + 63) / 64 * sizeof(uint64_t));
+		array_mask_func(array, is_removed, mask);
+		start = now();
+		array_remove_mask(array, mask);
+		double mask_time = now() - start;
+		free(mask);
+		array_destroy(array);
+		
+		printf("%-10.2f %14.1f %18.1f %18.1f\n", removed_fractions[f], elements / old_time / 1e6, elements / func_time / 1e6, elements / mask_time / 1e6);
+	}
+	
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include "../array_search.h"
+
+/**
+ * Measures the throughput of counting a value in a large int64_t array with
+ * array_find() (one function call per element), a plain loop like array_find_val() and
+ * array_count() with each instruction set the CPU supports. array_count() has to read
+ * the entire array so the result is comparable to the memory bandwidth.
+ * 
+ * Usage: array_search_bench [elements]
+ */
+
+static double now(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int64_t searched_value = -1;
+
+static bool is_searched_value(array_p array, size_t index){
+	return array_elem(array, int64_t, index) == searched_value;
+}
+
+static int compare_int64(const void* a, const void* b){
+	int64_t x = *(const int64_t*)a, y = *(const int64_t*)b;
+	return (x > y) - (x < y);
+}
+
+static void report(const char* name, array_p array, double elapsed){
+	double bytes = (double)array->length * array->element_size;
+	printf("%-16s %10.3f %12.2f\n", name, elapsed, bytes / elapsed / 1e9);
+}
+
+int main(int argc, char** argv){
+	size_t elements = (argc > 1) ? strtoul(argv[1], NULL, 10) : 32 * 1024 * 1024;
+	const char* isa_names[] = { "scalar", "sse2", "avx2", "avx512" };
+	
+	array_p array = array_with(elements, int64_t);
+	for(size_t i = 0; i < elements; i++)
+		array_elem(array, int64_t, i) = i;
+	
+	printf("searching %zu int64_t elements (%zu MiB) for a missing value\n", elements, elements * sizeof(int64_t) / (1024 * 1024));
+	printf("%-16s %10s %12s\n", "method", "seconds", "GB/s");
+	
+	double start = now();
+	ssize_t index = array_find(array, is_searched_value);
+	report("array_find", array, now() - start);
+	
+	start = now();
+	size_t count = 0;
+	for(size_t i = 0; i < array->length; i++)
+		count += (array_elem(array, int64_t, i) == searched_value);
+	report("loop", array, now() - start);
+	
+	array_search_isa_t max_isa = array_search_isa();
+	for(array_search_isa_t isa = ARRAY_SEARCH_SCALAR; isa <= max_isa; isa++) {
+		array_search_limit_isa(isa);
+		start = now();
+		count += array_count(array, ARRAY_INT64, &searched_value);
+		report(isa_names[isa], array, now() - start);
+	}
+	
+	// Use the results so the compiler can't throw the loops away
+	if (index != -1 || count != 0)
+		printf("found something, that's a bug\n");
+	
+	// The array is already sorted, look up random existing values
+	size_t lookups = 4 * 1000 * 1000, found = 0;
+	uint64_t random = 1;
+	printf("\n%zu random lookups in the sorted array\n", lookups);
+	printf("%-16s %10s %12s\n", "method", "seconds", "lookups/s");
+	for(size_t method = 0; method < 3; method++) {
+		const char* names[] = { "bsearch", "lower_bound", "eytzinger" };
+		array_eytzinger_p eytzinger = (method == 2) ? array_build_eytzinger(array, ARRAY_INT64) : NULL;
+		
+		start = now();
+		for(size_t i = 0; i < lookups; i++) {
+			random = random * 6364136223846793005 + 1442695040888963407;
+			int64_t value = (random >> 16) % elements;
+			switch(method) {
+				case 0:  found += bsearch(&value, array->data, array->length, sizeof(int64_t), compare_int64) != NULL;  break;
+				case 1:  found += array_lower_bound(array, ARRAY_INT64, &value) < array->length;                        break;
+				default: found += array_eytzinger_lower_bound(eytzinger, &value) < array->length;
+			}
+		}
+		double elapsed = now() - start;
+		printf("%-16s %10.3f %12.0f\n", names[method], elapsed, lookups / elapsed);
+		
+		if (eytzinger)
+			array_eytzinger_destroy(eytzinger);
+	}
+	
+	if (found != 3 * lookups)
+		printf("missed some values, that's a bug\n");
+	
+	array_destroy(array);
+	return 0;
+}
\ No newline at end of file
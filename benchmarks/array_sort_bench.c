@@ -0,0 +1,70 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../array_sort.h"
+
+/**
+ * Sorts random uint64_t arrays of 1K up to `max_elements` elements (10M by default)
+ * with qsort(), array_sort() and array_sort_func() on one and on all CPUs. Prints
+ * million elements per second.
+ * 
+ * Usage: array_sort_bench [max_elements]
+ */
+
+static double now(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int compare_uint64(const void* a, const void* b){
+	uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+	return (x > y) - (x < y);
+}
+
+static array_p random_array(size_t elements){
+	array_p array = array_with(elements, uint64_t);
+	uint64_t random = 1;
+	for(size_t i = 0; i < elements; i++) {
+		random = random * 6364136223846793005 + 1442695040888963407;
+		array_elem(array, uint64_t, i) = random;
+	}
+	return array;
+}
+
+int main(int argc, char** argv){
+	size_t max_elements = (argc > 1) ? strtoul(argv[1], NULL, 10) : 10 * 1000 * 1000;
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	
+	printf("%-12s %10s %12s %16s %16s\n", "elements", "qsort", "array_sort", "sort_func(1)", "sort_func(cpus)");
+	for(size_t elements = 1000; elements <= max_elements; elements *= 10) {
+		// Repeat small sizes so the measured time isn't just noise
+		size_t repeat = (elements < 1000000) ? 1000000 / elements : 1;
+		double times[4] = { 0 };
+		
+		for(size_t r = 0; r < repeat; r++) {
+			for(size_t method = 0; method < 4; method++) {
+				array_p array = random_array(elements);
+				double start = now();
+				switch(method) {
+					case 0:  qsort(array->data, array->length, array->element_size, compare_uint64);  break;
+					case 1:  array_sort(array, ARRAY_UINT64, 0);                                      break;
+					case 2:  array_sort_func(array, compare_uint64, 1);                               break;
+					default: array_sort_func(array, compare_uint64, cpus);
+				}
+				times[method] += now() - start;
+				array_destroy(array);
+			}
+		}
+		
+		double total = (double)elements * repeat / 1e6;
+		printf("%-12zu %10.1f %12.1f %16.1f %16.1f\n", elements, total / times[0], total / times[1], total / times[2], total / times[3]);
+	}
+	
+	return 0;
+}
\ No newline at end of file
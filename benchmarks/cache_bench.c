@@ -0,0 +1,66 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "../cache.h"
+
+/**
+ * Measures hit ratio and operations per second of the LRU and SIEVE policies. Keys
+ * are drawn from a zipf like distribution. Each access is a cache_get_ptr() followed
+ * by a cache_put() on a miss.
+ * 
+ * Usage: cache_bench [cache-entries] [distinct-keys] [accesses]
+ */
+
+static double now(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void run_bench(const char* name, cache_policy_t policy, size_t entries, char** keys, size_t* trace, size_t accesses){
+	cache_p cache = cache_of(entries, size_t, policy);
+	
+	double start = now();
+	for(size_t i = 0; i < accesses; i++) {
+		const char* key = keys[trace[i]];
+		if (cache_get_ptr(cache, key) == NULL)
+			cache_put(cache, key, size_t, trace[i]);
+	}
+	double elapsed = now() - start;
+	
+	printf("%-6s %10.4f %14.0f %12zu\n", name, cache_hit_ratio(cache), accesses / elapsed, cache->evictions);
+	cache_destroy(cache);
+}
+
+int main(int argc, char** argv){
+	size_t entries = (argc > 1) ? strtoul(argv[1], NULL, 10) : 10000;
+	size_t key_count = (argc > 2) ? strtoul(argv[2], NULL, 10) : 100000;
+	size_t accesses = (argc > 3) ? strtoul(argv[3], NULL, 10) : 5000000;
+	
+	char** keys = malloc(key_count * sizeof(char*));
+	for(size_t i = 0; i < key_count; i++) {
+		keys[i] = malloc(24);
+		snprintf(keys[i], 24, "key-%zu", i);
+	}
+	
+	// Zipf like trace: index = key_count ^ u - 1 with u uniform in [0, 1)
+	size_t* trace = malloc(accesses * sizeof(size_t));
+	srand(42);
+	for(size_t i = 0; i < accesses; i++) {
+		double u = (double)rand() / ((double)RAND_MAX + 1);
+		trace[i] = (size_t)(pow(key_count, u)) - 1;
+	}
+	
+	printf("%-6s %10s %14s %12s\n", "policy", "hit ratio", "ops/s", "evictions");
+	run_bench("LRU", CACHE_LRU, entries, keys, trace, accesses);
+	run_bench("SIEVE", CACHE_SIEVE, entries, keys, trace, accesses);
+	
+	for(size_t i = 0; i < key_count; i++)
+		free(keys[i]);
+	free(keys);
+	free(trace);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include "../delta_array.h"
+#include "../array_search.h"
+
+/**
+ * Compares a delta_array_t of sorted IDs with random gaps against a plain int64_t
+ * array: The memory used, summing up all values (decoding block by block vs. a loop
+ * over the array), array_count() vs. delta_array_find() for a missing value and random
+ * lookups with array_lower_bound() vs. delta_array_lower_bound().
+ * 
+ * Usage: delta_array_bench [elements] [max gap]
+ */
+
+static double now(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char* name, size_t elements, double elapsed){
+	printf("%-24s %10.3f %14.1f\n", name, elapsed, elements / elapsed / 1e6);
+}
+
+int main(int argc, char** argv){
+	size_t elements = (argc > 1) ? strtoul(argv[1], NULL, 10) : 10 * 1000 * 1000;
+	uint64_t max_gap = (argc > 2) ? strtoull(argv[2], NULL, 10) : 1000;
+	
+	array_p array = array_with(elements, int64_t);
+	uint64_t random = 1;
+	int64_t value = 0;
+	for(size_t i = 0; i < elements; i++) {
+		random = random * 6364136223846793005 + 1442695040888963407;
+		value += 1 + (random >> 33) % max_gap;
+		array_elem(array, int64_t, i) = value;
+	}
+	
+	delta_array_p ids = delta_array_new();
+	double start = now();
+	delta_array_append_n(ids, array->data, elements);
+	double encode_time = now() - start;
+	
+	size_t raw_bytes = elements * sizeof(int64_t), compressed_bytes = delta_array_memory(ids);
+	printf("%zu sorted IDs with gaps of 1 to %lu\n", elements, (unsigned long)max_gap);
+	printf("raw %.1f MiB, compressed %.1f MiB (%.2f bits per value, %.1fx smaller)\n",
+		raw_bytes / (1024.0 * 1024), compressed_bytes / (1024.0 * 1024),
+		compressed_bytes * 8.0 / elements, (double)raw_bytes / compressed_bytes);
+	
+	printf("\n%-20s %10s %14s\n", "method", "seconds", "M values/s");
+	report("encode", elements, encode_time);
+	
+	start = now();
+	int64_t raw_sum = 0;
+	for(size_t i = 0; i < array->length; i++)
+		raw_sum += array_elem(array, int64_t, i);
+	report("sum array", elements, now() - start);
+	
+	start = now();
+	int64_t decoded_sum = 0, values[DELTA_ARRAY_BLOCK];
+	for(size_t b = 0; b < delta_array_block_count(ids); b++) {
+		size_t n = delta_array_decode_block(ids, b, values);
+		for(size_t i = 0; i < n; i++)
+			decoded_sum += values[i];
+	}
+	report("sum decoded blocks", elements, now() - start);
+	
+	int64_t missing = -1;
+	start = now();
+	size_t count = array_count(array, ARRAY_INT64, &missing);
+	report("array_count", elements, now() - start);
+	
+	start = now();
+	ssize_t index = delta_array_find(ids, missing);
+	report("delta_array_find", elements, now() - start);
+	
+	// Use the results so the compiler can't throw the loops away
+	if (raw_sum != decoded_sum || count != 0 || index != -1)
+		printf("results differ, that's a bug\n");
+	
+	size_t lookups = 4 * 1000 * 1000, mismatches = 0;
+	int64_t max_value = array_elem(array, int64_t, elements - 1);
+	printf("\n%zu random lookups\n", lookups);
+	printf("%-24s %10s %14s\n", "method", "seconds", "M lookups/s");
+	size_t* bounds = malloc(lookups * sizeof(size_t));
+	for(size_t method = 0; method < 2; method++) {
+		random = 1;
+		start = now();
+		for(size_t i = 0; i < lookups; i++) {
+			random = random * 6364136223846793005 + 1442695040888963407;
+			int64_t searched = (random >> 16) % max_value;
+			if (method == 0)
+				bounds[i] = array_lower_bound(array, ARRAY_INT64, &searched);
+			else
+				mismatches += delta_array_lower_bound(ids, searched) != bounds[i];
+		}
+		report((method == 0) ? "array_lower_bound" : "delta_array_lower_bound", lookups, now() - start);
+	}
+	
+	if (mismatches != 0)
+		printf("%zu lookups differ, that's a bug\n", mismatches);
+	
+	free(bounds);
+	delta_array_destroy(ids);
+	array_destroy(array);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "../pool.h"
+
+/**
+ * Scaling of the work-stealing pool with 1 up to `max_threads` threads (all CPUs by
+ * default). Prints the runtime and the speedup over 1 thread for:
+ * 
+ * - reduce: pool_parallel_reduce() summing sqrt() of `elements` doubles (20M by default)
+ * - for: pool_parallel_for() with uneven work per index, so stealing has to balance it
+ * - spawn: fib(30) with one spawned task per call, measures the task overhead
+ * 
+ * Usage: pool_bench [max_threads] [elements]
+ */
+
+static double now(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+typedef struct {
+	double* values;
+	size_t elements;
+	volatile double sink;
+} bench_t;
+
+static void sqrt_sum(void* context, size_t start, size_t end, void* result){
+	double* values = ((bench_t*)context)->values;
+	double sum = 0;
+	for(size_t i = start; i < end; i++)
+		sum += sqrt(values[i]);
+	*(double*)result += sum;
+}
+
+static void add(void* context, void* result, const void* other){
+	(void)context;
+	*(double*)result += *(const double*)other;
+}
+
+// Index i does work proportional to i, the last quarter of the range has most of it
+static void uneven(void* context, size_t start, size_t end){
+	bench_t* bench = context;
+	for(size_t i = start; i < end; i++) {
+		double x = 0;
+		for(size_t j = 0; j < i / 256; j++)
+			x += sqrt((double)j);
+		bench->values[i] = x;
+	}
+}
+
+typedef struct {
+	uint32_t n;
+	uint64_t result;
+} fib_t;
+
+static void fib(pool_p pool, void* arg){
+	fib_t* f = arg;
+	if (f->n < 2) {
+		f->result = f->n;
+		return;
+	}
+	
+	fib_t a = { f->n - 1, 0 }, b = { f->n - 2, 0 };
+	pool_group_t group = { 0 };
+	pool_task_t task = { fib, &a, NULL };
+	pool_spawn(pool, &group, &task);
+	fib(pool, &b);
+	pool_wait(pool, &group);
+	f->result = a.result + b.result;
+}
+
+static double run(bench_t* bench, size_t threads, int kind){
+	pool_p pool = pool_new(threads);
+	double start = now();
+	
+	if (kind == 0) {
+		double identity = 0, sum;
+		pool_parallel_reduce(pool, 0, bench->elements, 16 * 1024, sizeof(double), &identity, sqrt_sum, add, bench, &sum);
+		bench->sink = sum;
+	} else if (kind == 1) {
+		pool_parallel_for(pool, 0, 256 * 1024, 256, uneven, bench);
+	} else {
+		fib_t f = { 30, 0 };
+		pool_run(pool, fib, &f);
+		bench->sink = f.result;
+	}
+	
+	double time = now() - start;
+	pool_destroy(pool);
+	return time;
+}
+
+int main(int argc, char** argv){
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	size_t max_threads = (argc > 1) ? strtoul(argv[1], NULL, 10) : (size_t)cpus;
+	size_t elements = (argc > 2) ? strtoul(argv[2], NULL, 10) : 20 * 1000 * 1000;
+	
+	bench_t bench = { malloc(elements * sizeof(double)), elements, 0 };
+	for(size_t i = 0; i < elements; i++)
+		bench.values[i] = i;
+	
+	const char* names[] = { "reduce", "for", "spawn" };
+	printf("%-8s %8s %10s %8s\n", "bench", "threads", "ms", "speedup");
+	for(int kind = 0; kind < 3; kind++) {
+		double single = 0;
+		for(size_t threads = 1; threads <= max_threads; threads *= 2) {
+			double time = run(&bench, threads, kind);
+			if (threads == 1)
+				single = time;
+			printf("%-8s %8zu %10.1f %8.2f\n", names[kind], threads, time * 1000, single / time);
+		}
+	}
+	
+	free(bench.values);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,189 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "../queue.h"
+#include "../deque.h"
+
+/**
+ * Passes 32 byte records from P producer to C consumer threads and prints the
+ * throughput (million records per second) and the average latency from push to pop.
+ * Compares a deque guarded by a mutex, the SPSC queue (one record at a time and in
+ * batches of 32, only for 1 producer and 1 consumer) and the MPMC queue.
+ * 
+ * Usage: queue_bench [records-per-run] [max-threads-per-side]
+ */
+
+#define CAPACITY  1024
+#define BATCH     32
+
+typedef struct {
+	uint64_t pushed_at;
+	uint64_t seq;
+	char payload[16];
+} record_t;
+
+typedef struct {
+	pthread_mutex_t lock;
+	deque_p deque;
+} locked_deque_t;
+
+typedef struct {
+	const char* name;
+	void* queue;
+	size_t (*push)(void* queue, record_t* records, size_t n);
+	size_t (*pop)(void* queue, record_t* records, size_t n);
+	size_t records_per_producer;
+	size_t remaining;
+	uint64_t latency_sum;
+} bench_t;
+
+static uint64_t now_ns(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static size_t locked_push(void* queue, record_t* records, size_t n){
+	locked_deque_t* locked = queue;
+	pthread_mutex_lock(&locked->lock);
+	size_t pushed = 0;
+	// Bounded like the other queues, otherwise fast producers just fill the memory
+	for(; pushed < n && locked->deque->length < CAPACITY; pushed++)
+		deque_push_back(locked->deque, record_t, records[pushed]);
+	pthread_mutex_unlock(&locked->lock);
+	return pushed;
+}
+
+static size_t locked_pop(void* queue, record_t* records, size_t n){
+	locked_deque_t* locked = queue;
+	pthread_mutex_lock(&locked->lock);
+	size_t popped = 0;
+	for(; popped < n && locked->deque->length > 0; popped++)
+		records[popped] = deque_pop_front(locked->deque, record_t);
+	pthread_mutex_unlock(&locked->lock);
+	return popped;
+}
+
+static size_t spsc_push(void* queue, record_t* records, size_t n){
+	return spsc_queue_push_n(queue, records, n);
+}
+
+static size_t spsc_pop(void* queue, record_t* records, size_t n){
+	return spsc_queue_pop_n(queue, records, n);
+}
+
+static size_t mpmc_push(void* queue, record_t* records, size_t n){
+	(void)n;
+	return mpmc_queue_push(queue, records) ? 1 : 0;
+}
+
+static size_t mpmc_pop(void* queue, record_t* records, size_t n){
+	(void)n;
+	return mpmc_queue_pop(queue, records) ? 1 : 0;
+}
+
+static size_t batch_size;
+
+static void* producer(void* arg){
+	bench_t* bench = arg;
+	record_t records[BATCH] = { { 0 } };
+	
+	for(size_t seq = 0; seq < bench->records_per_producer; ) {
+		size_t n = (bench->records_per_producer - seq < batch_size) ? bench->records_per_producer - seq : batch_size;
+		uint64_t timestamp = now_ns();
+		for(size_t i = 0; i < n; i++) {
+			records[i].pushed_at = timestamp;
+			records[i].seq = seq + i;
+		}
+		
+		size_t pushed = 0;
+		while (pushed < n) {
+			size_t count = bench->push(bench->queue, records + pushed, n - pushed);
+			if (count == 0)
+				sched_yield();
+			pushed += count;
+		}
+		seq += n;
+	}
+	
+	return NULL;
+}
+
+static void* consumer(void* arg){
+	bench_t* bench = arg;
+	record_t records[BATCH];
+	uint64_t latency_sum = 0;
+	
+	while (__atomic_load_n(&bench->remaining, __ATOMIC_RELAXED) > 0) {
+		size_t n = bench->pop(bench->queue, records, batch_size);
+		if (n == 0) {
+			sched_yield();
+			continue;
+		}
+		
+		uint64_t timestamp = now_ns();
+		for(size_t i = 0; i < n; i++)
+			latency_sum += timestamp - records[i].pushed_at;
+		__atomic_sub_fetch(&bench->remaining, n, __ATOMIC_RELAXED);
+	}
+	
+	__atomic_add_fetch(&bench->latency_sum, latency_sum, __ATOMIC_RELAXED);
+	return NULL;
+}
+
+static void run(bench_t* bench, size_t producers, size_t consumers, size_t records){
+	bench->records_per_producer = records / producers;
+	bench->remaining = bench->records_per_producer * producers;
+	bench->latency_sum = 0;
+	size_t total = bench->remaining;
+	
+	pthread_t threads[producers + consumers];
+	uint64_t start = now_ns();
+	for(size_t i = 0; i < producers + consumers; i++)
+		pthread_create(&threads[i], NULL, (i < producers) ? producer : consumer, bench);
+	for(size_t i = 0; i < producers + consumers; i++)
+		pthread_join(threads[i], NULL);
+	double seconds = (now_ns() - start) / 1e9;
+	
+	printf("%-12s %4zu %4zu %10.2f %12.2f\n", bench->name, producers, consumers, total / seconds / 1e6, (double)bench->latency_sum / total / 1000);
+}
+
+int main(int argc, char** argv){
+	size_t records = (argc > 1) ? strtoul(argv[1], NULL, 10) : 2 * 1000 * 1000;
+	size_t max_threads = (argc > 2) ? strtoul(argv[2], NULL, 10) : 4;
+	
+	locked_deque_t locked = { PTHREAD_MUTEX_INITIALIZER, deque_of(record_t) };
+	spsc_queue_p spsc = spsc_queue_of(CAPACITY, record_t);
+	mpmc_queue_p mpmc = mpmc_queue_of(CAPACITY, record_t);
+	
+	printf("%-12s %4s %4s %10s %12s\n", "queue", "prod", "cons", "M rec/s", "latency us");
+	
+	bench_t spsc_bench = { "spsc", spsc, spsc_push, spsc_pop, 0, 0, 0 };
+	batch_size = 1;
+	run(&spsc_bench, 1, 1, records);
+	spsc_bench.name = "spsc batch";
+	batch_size = BATCH;
+	run(&spsc_bench, 1, 1, records);
+	
+	bench_t benches[] = {
+		{ "mutex deque", &locked, locked_push, locked_pop, 0, 0, 0 },
+		{ "mpmc", mpmc, mpmc_push, mpmc_pop, 0, 0, 0 },
+	};
+	batch_size = 1;
+	for(size_t producers = 1; producers <= max_threads; producers *= 2) {
+		for(size_t consumers = 1; consumers <= max_threads; consumers *= 2) {
+			for(size_t b = 0; b < sizeof(benches) / sizeof(benches[0]); b++)
+				run(&benches[b], producers, consumers, records);
+		}
+	}
+	
+	deque_destroy(locked.deque);
+	spsc_queue_destroy(spsc);
+	mpmc_queue_destroy(mpmc);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,142 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include "../rcu_dict.h"
+
+/**
+ * Reader scaling benchmark: N reader threads look up random keys while one writer
+ * updates a key every millisecond. Compares the RCU dict with a dict protected by a
+ * mutex.
+ * 
+ * Usage: rcu_dict_bench [max-reader-threads] [milliseconds-per-run]
+ */
+
+#define KEY_COUNT 1024
+
+char keys[KEY_COUNT][16];
+volatile size_t sink;
+
+typedef struct {
+	rcu_dict_p rcu;
+	dict_p locked;
+	pthread_mutex_t lock;
+	volatile bool stop;
+	size_t lookups;
+} bench_t;
+
+static double now(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void sleep_ms(long ms){
+	struct timespec ts = { ms / 1000, (ms % 1000) * 1000000 };
+	nanosleep(&ts, NULL);
+}
+
+static void* rcu_reader(void* arg){
+	bench_t* bench = arg;
+	rcu_dict_reader_p reader = rcu_dict_register(bench->rcu);
+	size_t lookups = 0, sum = 0;
+	unsigned int seed = (unsigned int)(size_t)&lookups;
+	
+	while( !__atomic_load_n(&bench->stop, __ATOMIC_RELAXED) ) {
+		dict_p d = rcu_dict_read_lock(bench->rcu, reader);
+		for(size_t i = 0; i < 64; i++) {
+			seed = seed * 1103515245 + 12345;
+			int* value = dict_get_ptr(d, keys[(seed >> 8) % KEY_COUNT]);
+			sum += (value != NULL) ? *value : 0;
+		}
+		rcu_dict_read_unlock(reader);
+		lookups += 64;
+	}
+	
+	rcu_dict_unregister(bench->rcu, reader);
+	sink += sum;
+	__atomic_add_fetch(&bench->lookups, lookups, __ATOMIC_RELAXED);
+	return NULL;
+}
+
+static void* mutex_reader(void* arg){
+	bench_t* bench = arg;
+	size_t lookups = 0, sum = 0;
+	unsigned int seed = (unsigned int)(size_t)&lookups;
+	
+	while( !__atomic_load_n(&bench->stop, __ATOMIC_RELAXED) ) {
+		for(size_t i = 0; i < 64; i++) {
+			seed = seed * 1103515245 + 12345;
+			pthread_mutex_lock(&bench->lock);
+			int* value = dict_get_ptr(bench->locked, keys[(seed >> 8) % KEY_COUNT]);
+			sum += (value != NULL) ? *value : 0;
+			pthread_mutex_unlock(&bench->lock);
+		}
+		lookups += 64;
+	}
+	
+	sink += sum;
+	__atomic_add_fetch(&bench->lookups, lookups, __ATOMIC_RELAXED);
+	return NULL;
+}
+
+static double run_bench(bench_t* bench, bool use_rcu, size_t threads, long ms){
+	pthread_t tids[threads];
+	bench->stop = false;
+	bench->lookups = 0;
+	
+	double start = now();
+	for(size_t i = 0; i < threads; i++)
+		pthread_create(&tids[i], NULL, use_rcu ? rcu_reader : mutex_reader, bench);
+	
+	// The writer updates one key about every millisecond
+	for(long t = 0; now() - start < ms / 1000.0; t++) {
+		int value = t;
+		if (use_rcu) {
+			rcu_dict_put(bench->rcu, keys[t % KEY_COUNT], &value);
+		} else {
+			pthread_mutex_lock(&bench->lock);
+			dict_put(bench->locked, keys[t % KEY_COUNT], int, value);
+			pthread_mutex_unlock(&bench->lock);
+		}
+		sleep_ms(1);
+	}
+	
+	bench->stop = true;
+	for(size_t i = 0; i < threads; i++)
+		pthread_join(tids[i], NULL);
+	
+	return bench->lookups / (now() - start);
+}
+
+int main(int argc, char** argv){
+	size_t max_threads = (argc > 1) ? strtoul(argv[1], NULL, 10) : 8;
+	long ms = (argc > 2) ? strtol(argv[2], NULL, 10) : 500;
+	
+	bench_t bench;
+	bench.rcu = rcu_dict_of(int);
+	bench.locked = dict_of(int);
+	pthread_mutex_init(&bench.lock, NULL);
+	
+	dict_p initial = rcu_dict_write_begin(bench.rcu);
+	for(size_t i = 0; i < KEY_COUNT; i++) {
+		snprintf(keys[i], sizeof(keys[i]), "key-%zu", i);
+		dict_put(initial, keys[i], int, i);
+		dict_put(bench.locked, keys[i], int, i);
+	}
+	rcu_dict_write_commit(bench.rcu, initial);
+	
+	printf("%8s %16s %16s\n", "readers", "rcu lookups/s", "mutex lookups/s");
+	for(size_t threads = 1; threads <= max_threads; threads *= 2) {
+		double rcu = run_bench(&bench, true, threads, ms);
+		double mutex = run_bench(&bench, false, threads, ms);
+		printf("%8zu %16.0f %16.0f\n", threads, rcu, mutex);
+	}
+	
+	pthread_mutex_destroy(&bench.lock);
+	dict_destroy(bench.locked);
+	rcu_dict_destroy(bench.rcu);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,288 @@
+#include <stdlib.h>
+#include <string.h>
+#include "cache.h"
+
+/**
+ * Each dict value starts with a cache_entry_t followed by the value_size bytes of the
+ * users value. The prev and next pointers are dict elements (slots). They stay valid
+ * because the dict is never resized while entries are linked. When the dict is rebuilt
+ * into the spare dict all links are rebuilt, too.
+ * 
+ * The list goes from head (newest) via next pointers to tail (oldest).
+ */
+
+typedef struct {
+	dict_elem_t prev, next;
+	bool visited;
+} cache_entry_t, *cache_entry_p;
+
+#define entry_of(elem)          ( (cache_entry_p)dict_value_ptr(elem) )
+#define entry_value_ptr(entry)  ( (void*)((entry) + 1) )
+
+// Load factors of the dict. Entries use at most CACHE_MAX_LOAD of the slots. When
+// entries and deleted slots together reach CACHE_REBUILD_LOAD the dict is rebuilt.
+#define CACHE_MAX_LOAD      0.7
+#define CACHE_REBUILD_LOAD  0.85
+
+static void cache_unlink(cache_p cache, dict_elem_t elem);
+static void cache_link_head(cache_p cache, dict_elem_t elem);
+static void cache_remove_elem(cache_p cache, dict_elem_t elem);
+static void cache_evict(cache_p cache);
+static void cache_rebuild(cache_p cache);
+
+
+//
+// Creation and destruction functions
+//
+
+cache_p cache_new(size_t max_length, size_t value_size, cache_policy_t policy){
+	if (max_length == 0)
+		max_length = 1;
+	
+	cache_p cache = malloc(sizeof(cache_t));
+	if (cache == NULL)
+		return NULL;
+	
+	size_t capacity = max_length / CACHE_MAX_LOAD + 2;
+	cache->dict = dict_new(capacity, sizeof(cache_entry_t) + value_size);
+	cache->spare = dict_new(capacity, sizeof(cache_entry_t) + value_size);
+	if (cache->dict == NULL || cache->spare == NULL) {
+		if (cache->dict != NULL)
+			dict_destroy(cache->dict);
+		if (cache->spare != NULL)
+			dict_destroy(cache->spare);
+		free(cache);
+		return NULL;
+	}
+	
+	cache->max_length = max_length;
+	cache->value_size = value_size;
+	cache->deleted_slots = 0;
+	cache->policy = policy;
+	cache->head = NULL;
+	cache->tail = NULL;
+	cache->hand = NULL;
+	cache->evict_func = NULL;
+	cache->evict_context = NULL;
+	cache->hits = 0;
+	cache->misses = 0;
+	cache->inserts = 0;
+	cache->evictions = 0;
+	
+	return cache;
+}
+
+/**
+ * Destroys the cache. The evict function is called for all remaining entries.
+ */
+void cache_destroy(cache_p cache){
+	if (cache->evict_func) {
+		for(dict_elem_t elem = cache->head; elem != NULL; elem = entry_of(elem)->next)
+			cache->evict_func(dict_key(elem), entry_value_ptr(entry_of(elem)), cache->evict_context);
+	}
+	
+	dict_destroy(cache->dict);
+	dict_destroy(cache->spare);
+	free(cache);
+}
+
+/**
+ * Returns the maximum number of entries a cache can hold without using more than
+ * `memory_budget` bytes. Use it as `max_length` for cache_new(). Each slot exists twice,
+ * once in the dict and once in the spare dict.
+ */
+size_t cache_length_for_budget(size_t memory_budget, size_t value_size){
+	size_t slot_size = sizeof(size_t) + sizeof(const char*) + sizeof(cache_entry_t) + value_size;
+	if (memory_budget < sizeof(cache_t) + 2 * sizeof(unified_hash_t))
+		return 0;
+	
+	return (memory_budget - sizeof(cache_t) - 2 * sizeof(unified_hash_t)) / (2 * slot_size) * CACHE_MAX_LOAD;
+}
+
+void cache_on_evict(cache_p cache, cache_evict_func_t func, void* context){
+	cache->evict_func = func;
+	cache->evict_context = context;
+}
+
+
+//
+// Get and put functions
+//
+
+void* cache_get_ptr(cache_p cache, const char* key){
+	dict_elem_t elem = dict_get_elem(cache->dict, key);
+	if (elem == NULL) {
+		cache->misses++;
+		return NULL;
+	}
+	
+	cache->hits++;
+	cache_entry_p entry = entry_of(elem);
+	if (cache->policy == CACHE_SIEVE) {
+		entry->visited = true;
+	} else if (cache->head != elem) {
+		cache_unlink(cache, elem);
+		cache_link_head(cache, elem);
+	}
+	
+	return entry_value_ptr(entry);
+}
+
+/**
+ * Returns a pointer to the value of `key`. If the key isn't in the cache yet a new entry
+ * is inserted (evicting an old one if the cache is full). The value of a new entry is
+ * undefined. Returns NULL if the dict had no free slot left, which the rebuilds should
+ * prevent.
+ */
+void* cache_put_ptr(cache_p cache, const char* key){
+	dict_elem_t elem = dict_get_elem(cache->dict, key);
+	
+	if (elem != NULL) {
+		cache_entry_p entry = entry_of(elem);
+		if (cache->policy == CACHE_SIEVE) {
+			entry->visited = true;
+		} else if (cache->head != elem) {
+			cache_unlink(cache, elem);
+			cache_link_head(cache, elem);
+		}
+		return entry_value_ptr(entry);
+	}
+	
+	if (cache->dict->length >= cache->max_length)
+		cache_evict(cache);
+	if (cache->dict->length + cache->deleted_slots + 1 > cache->dict->capacity * CACHE_REBUILD_LOAD)
+		cache_rebuild(cache);
+	
+	bool reused_deleted = false;
+	elem = dict_put_elem_tracked(cache->dict, key, &reused_deleted);
+	if (elem == NULL)
+		return NULL;
+	if (reused_deleted)
+		cache->deleted_slots--;
+	
+	entry_of(elem)->visited = false;
+	cache_link_head(cache, elem);
+	cache->inserts++;
+	
+	return entry_value_ptr(entry_of(elem));
+}
+
+bool cache_contains(cache_p cache, const char* key){
+	return dict_contains(cache->dict, key);
+}
+
+/**
+ * Removes an entry without calling the evict function.
+ */
+void cache_remove(cache_p cache, const char* key){
+	dict_elem_t elem = dict_get_elem(cache->dict, key);
+	if (elem != NULL)
+		cache_remove_elem(cache, elem);
+}
+
+double cache_hit_ratio(cache_p cache){
+	size_t accesses = cache->hits + cache->misses;
+	return (accesses > 0) ? (double)cache->hits / accesses : 0;
+}
+
+
+//
+// Recency list and eviction
+//
+
+static void cache_unlink(cache_p cache, dict_elem_t elem){
+	cache_entry_p entry = entry_of(elem);
+	
+	if (entry->prev)
+		entry_of(entry->prev)->next = entry->next;
+	else
+		cache->head = entry->next;
+	
+	if (entry->next)
+		entry_of(entry->next)->prev = entry->prev;
+	else
+		cache->tail = entry->prev;
+}
+
+static void cache_link_head(cache_p cache, dict_elem_t elem){
+	cache_entry_p entry = entry_of(elem);
+	
+	entry->prev = NULL;
+	entry->next = cache->head;
+	
+	if (cache->head)
+		entry_of(cache->head)->prev = elem;
+	else
+		cache->tail = elem;
+	
+	cache->head = elem;
+}
+
+static void cache_remove_elem(cache_p cache, dict_elem_t elem){
+	// Move the SIEVE hand to the next newer entry. NULL means it restarts at the tail.
+	if (cache->hand == elem)
+		cache->hand = entry_of(elem)->prev;
+	
+	cache_unlink(cache, elem);
+	dict_remove_elem(cache->dict, elem);
+	cache->deleted_slots++;
+}
+
+/**
+ * Evicts one entry. With LRU this is the tail. With SIEVE the hand moves from the tail
+ * towards the head, clears the visited flags it passes and evicts the first entry that
+ * wasn't visited.
+ */
+static void cache_evict(cache_p cache){
+	dict_elem_t victim = cache->tail;
+	
+	if (cache->policy == CACHE_SIEVE) {
+		victim = (cache->hand != NULL) ? cache->hand : cache->tail;
+		while(entry_of(victim)->visited) {
+			entry_of(victim)->visited = false;
+			victim = (entry_of(victim)->prev != NULL) ? entry_of(victim)->prev : cache->tail;
+		}
+		cache->hand = victim;
+	}
+	
+	if (cache->evict_func)
+		cache->evict_func(dict_key(victim), entry_value_ptr(entry_of(victim)), cache->evict_context);
+	
+	cache_remove_elem(cache, victim);
+	cache->evictions++;
+}
+
+/**
+ * Rebuilds the dict into the spare dict to get rid of deleted slots, then swaps them.
+ * Entries are inserted from the oldest to the newest so the recency order stays the
+ * same. Both have the same capacity, so this never allocates.
+ */
+static void cache_rebuild(cache_p cache){
+	dict_p new_dict = cache->spare;
+	
+	dict_elem_t new_head = NULL, new_tail = NULL, new_hand = NULL;
+	for(dict_elem_t elem = cache->tail; elem != NULL; elem = entry_of(elem)->prev) {
+		dict_elem_t new_elem = dict_put_elem(new_dict, dict_key(elem));
+		memcpy(dict_value_ptr(new_elem), dict_value_ptr(elem), new_dict->value_size);
+		
+		cache_entry_p entry = entry_of(new_elem);
+		entry->prev = NULL;
+		entry->next = new_head;
+		if (new_head)
+			entry_of(new_head)->prev = new_elem;
+		else
+			new_tail = new_elem;
+		new_head = new_elem;
+		
+		if (elem == cache->hand)
+			new_hand = new_elem;
+	}
+	
+	dict_clear(cache->dict);
+	cache->spare = cache->dict;
+	cache->dict = new_dict;
+	cache->head = new_head;
+	cache->tail = new_tail;
+	cache->hand = new_hand;
+	cache->deleted_slots = 0;
+}
\ No newline at end of file
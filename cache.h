@@ -0,0 +1,98 @@
+#pragma once
+
+/**
+
+# A bounded cache with string keys
+
+A cache is a dict with a fixed maximum number of entries. When a new key is put into
+a full cache an old entry is evicted. Two eviction policies are supported:
+
+- CACHE_LRU: Evicts the least recently used entry. Each hit moves the entry to the
+  front of the recency list.
+- CACHE_SIEVE: Evicts the oldest entry that wasn't visited since the eviction hand
+  last passed it. A hit only sets a visited flag, entries never move. Often has a
+  better hit ratio than LRU and hits are cheaper.
+
+The recency links are stored directly in the dict slots, right before the value. So
+get and put never allocate memory. The dict is created with enough capacity for the
+maximum number of entries and is never resized automatically. A second dict with the
+same capacity is allocated up front, too. When too many deleted slots accumulated the
+entries are reinserted into that spare dict and the two are swapped. This takes
+O(capacity) time on that put but doesn't allocate, so it can't fail. A cache needs
+twice the slot memory of a plain dict, cache_length_for_budget() accounts for that.
+
+
+// Creating and destroying caches
+
+cache_p cache = cache_of(1000, int, CACHE_LRU);      // at most 1000 entries
+cache_p cache = cache_new(cache_length_for_budget(64 * 1024 * 1024, sizeof(int)), sizeof(int), CACHE_SIEVE);
+cache_destroy(cache);
+
+
+// Get and put. cache_get_ptr() returns NULL on a miss, cache_put_ptr() if the key
+// couldn't be inserted.
+
+cache_put(cache, "foo", int, 7);
+int* value = cache_get_ptr(cache, "foo");
+cache_get(cache, "foo", int);      // -> 7, crashes on a miss
+cache_contains(cache, "foo");      // -> true, doesn't count as access
+cache_remove(cache, "foo");
+
+
+// Eviction callback, e.g. to free keys owned by the cache. It is called for each
+// evicted entry and for all remaining entries by cache_destroy().
+
+void on_evict(const char* key, void* value, void* context){
+	free((char*)key);
+}
+cache_on_evict(cache, on_evict, NULL);
+
+
+// Instrumentation
+
+cache->hits, cache->misses, cache->inserts, cache->evictions;
+cache_hit_ratio(cache);            // -> hits / (hits + misses)
+
+*/
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "hash.h"
+
+
+typedef enum {
+	CACHE_LRU,
+	CACHE_SIEVE
+} cache_policy_t;
+
+typedef void (*cache_evict_func_t)(const char* key, void* value, void* context);
+
+typedef struct {
+	// spare has the same capacity as dict and is empty, dict is rebuilt into it
+	dict_p dict, spare;
+	size_t max_length, value_size, deleted_slots;
+	cache_policy_t policy;
+	// Elements of the dict. head is the most recently inserted (or used with LRU) entry.
+	dict_elem_t head, tail, hand;
+	
+	cache_evict_func_t evict_func;
+	void* evict_context;
+	
+	size_t hits, misses, inserts, evictions;
+} cache_t, *cache_p;
+
+
+#define cache_of(max_length, type, policy)  cache_new(max_length, sizeof(type), policy)
+cache_p cache_new(size_t max_length, size_t value_size, cache_policy_t policy);
+void    cache_destroy(cache_p cache);
+size_t  cache_length_for_budget(size_t memory_budget, size_t value_size);
+void    cache_on_evict(cache_p cache, cache_evict_func_t func, void* context);
+
+#define cache_put(cache, key, type, value)  ( *((type*)cache_put_ptr(cache, key)) = (value) )
+#define cache_get(cache, key, type)         ( *((type*)cache_get_ptr(cache, key)) )
+void*   cache_get_ptr(cache_p cache, const char* key);
+void*   cache_put_ptr(cache_p cache, const char* key);
+bool    cache_contains(cache_p cache, const char* key);
+void    cache_remove(cache_p cache, const char* key);
+
+double  cache_hit_ratio(cache_p cache);
\ No newline at end of file
@@ -0,0 +1,382 @@
+#include <stdlib.h>
+#include <string.h>
+#include "delta_array.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define DELTA_ARRAY_SSE2
+#endif
+
+// Packed blocks consist of 4 lanes, each lane holds every 4th delta of the block
+#define DELTA_ARRAY_LANES  4
+#define DELTA_ARRAY_ROWS   (DELTA_ARRAY_BLOCK / DELTA_ARRAY_LANES)
+#define DELTA_ARRAY_WIDE   64
+
+delta_array_p delta_array_new(){
+	delta_array_p array = malloc(sizeof(delta_array_t));
+	if (array == NULL)
+		return NULL;
+	
+	array->length = 0;
+	array->pending_length = 0;
+	array->blocks = array_of(delta_array_block_t);
+	array->packed = array_of(uint8_t);
+	if (array->blocks == NULL || array->packed == NULL) {
+		if (array->blocks != NULL)
+			array_destroy(array->blocks);
+		if (array->packed != NULL)
+			array_destroy(array->packed);
+		free(array);
+		return NULL;
+	}
+	
+	return array;
+}
+
+void delta_array_destroy(delta_array_p array){
+	array_destroy(array->blocks);
+	array_destroy(array->packed);
+	free(array);
+}
+
+
+//
+// Bit-packing
+//
+
+/**
+ * Lane l of row r is delta r * 4 + l. Each lane is packed into `bits` 32 bit words
+ * on its own, the words of the 4 lanes are interleaved. So the n-th words of all lanes
+ * form one vector and unpacking works on all 4 lanes at once with the same shifts.
+ */
+static void delta_array_pack(const uint64_t* deltas, uint8_t bits, uint32_t* words){
+	for(size_t lane = 0; lane < DELTA_ARRAY_LANES; lane++) {
+		uint64_t buffer = 0;
+		size_t filled = 0, word = 0;
+		for(size_t row = 0; row < DELTA_ARRAY_ROWS; row++) {
+			buffer |= deltas[row * DELTA_ARRAY_LANES + lane] << filled;
+			filled += bits;
+			if (filled >= 32) {
+				words[word * DELTA_ARRAY_LANES + lane] = (uint32_t)buffer;
+				buffer >>= 32;
+				filled -= 32;
+				word++;
+			}
+		}
+	}
+}
+
+#ifdef DELTA_ARRAY_SSE2
+
+static void delta_array_unpack(const uint32_t* words, uint8_t bits, uint32_t* deltas){
+	const __m128i* vectors = (const __m128i*)words;
+	__m128i mask = _mm_set1_epi32((bits == 32) ? -1 : (int)((1u << bits) - 1));
+	__m128i current = _mm_loadu_si128(vectors);
+	size_t word = 0, shift = 0;
+	
+	for(size_t row = 0; row < DELTA_ARRAY_ROWS; row++) {
+		__m128i value = _mm_srl_epi32(current, _mm_cvtsi32_si128(shift));
+		// The delta continues in the next word
+		if (shift + bits > 32) {
+			__m128i next = _mm_loadu_si128(vectors + word + 1);
+			value = _mm_or_si128(value, _mm_sll_epi32(next, _mm_cvtsi32_si128(32 - shift)));
+		}
+		_mm_storeu_si128((__m128i*)(deltas + row * DELTA_ARRAY_LANES), _mm_and_si128(value, mask));
+		
+		shift += bits;
+		if (shift >= 32) {
+			shift -= 32;
+			word++;
+			if (word < bits)
+				current = _mm_loadu_si128(vectors + word);
+		}
+	}
+}
+
+#else
+
+static void delta_array_unpack(const uint32_t* words, uint8_t bits, uint32_t* deltas){
+	uint32_t mask = (bits == 32) ? UINT32_MAX : (1u << bits) - 1;
+	for(size_t lane = 0; lane < DELTA_ARRAY_LANES; lane++) {
+		size_t word = 0, shift = 0;
+		for(size_t row = 0; row < DELTA_ARRAY_ROWS; row++) {
+			uint32_t value = words[word * DELTA_ARRAY_LANES + lane] >> shift;
+			if (shift + bits > 32)
+				value |= words[(word + 1) * DELTA_ARRAY_LANES + lane] << (32 - shift);
+			deltas[row * DELTA_ARRAY_LANES + lane] = value & mask;
+			
+			shift += bits;
+			if (shift >= 32) {
+				shift -= 32;
+				word++;
+			}
+		}
+	}
+}
+
+#endif
+
+
+//
+// Appending
+//
+
+/**
+ * The smallest delta is picked as signed number, so unsorted blocks with small ups and
+ * downs still get small packed deltas. All math is modulo 2^64, so any choice decodes
+ * correctly.
+ */
+static bool delta_array_encode_block(delta_array_p array, const int64_t* values){
+	uint64_t deltas[DELTA_ARRAY_BLOCK];
+	uint64_t min_delta = (uint64_t)values[1] - (uint64_t)values[0];
+	for(size_t i = 1; i < DELTA_ARRAY_BLOCK; i++) {
+		deltas[i] = (uint64_t)values[i] - (uint64_t)values[i - 1];
+		if ((int64_t)deltas[i] < (int64_t)min_delta)
+			min_delta = deltas[i];
+	}
+	
+	// The first value is the base, its packed delta is always 0
+	deltas[0] = min_delta;
+	uint64_t used_bits = 0;
+	for(size_t i = 0; i < DELTA_ARRAY_BLOCK; i++) {
+		deltas[i] -= min_delta;
+		used_bits |= deltas[i];
+	}
+	
+	delta_array_block_t block = { (uint64_t)values[0], min_delta, array->packed->length, 0 };
+	block.bits = (used_bits == 0) ? 0 : 64 - __builtin_clzll(used_bits);
+	bool appended = true;
+	if (block.bits > 32) {
+		block.bits = DELTA_ARRAY_WIDE;
+		appended = array_append_n(array->packed, deltas, sizeof(deltas)) != NULL;
+	} else if (block.bits > 0) {
+		uint32_t words[DELTA_ARRAY_LANES * 32];
+		delta_array_pack(deltas, block.bits, words);
+		appended = array_append_n(array->packed, words, DELTA_ARRAY_LANES * block.bits * sizeof(uint32_t)) != NULL;
+	}
+	
+	if ( !appended || array_append_n(array->blocks, &block, 1) == NULL ) {
+		array->packed->length = block.offset;
+		return false;
+	}
+	return true;
+}
+
+bool delta_array_append(delta_array_p array, int64_t value){
+	return delta_array_append_n(array, &value, 1);
+}
+
+bool delta_array_append_n(delta_array_p array, const int64_t* values, size_t n){
+	while (n > 0) {
+		size_t space = DELTA_ARRAY_BLOCK - array->pending_length;
+		size_t count = (n < space) ? n : space;
+		
+		// Full blocks from the input are encoded directly
+		if (array->pending_length == 0 && count == DELTA_ARRAY_BLOCK) {
+			if ( !delta_array_encode_block(array, values) )
+				return false;
+		} else {
+			memcpy(array->pending + array->pending_length, values, count * sizeof(int64_t));
+			array->pending_length += count;
+			if (array->pending_length == DELTA_ARRAY_BLOCK) {
+				if ( !delta_array_encode_block(array, array->pending) ) {
+					array->pending_length -= count;
+					return false;
+				}
+				array->pending_length = 0;
+			}
+		}
+		
+		array->length += count;
+		values += count;
+		n -= count;
+	}
+	
+	return true;
+}
+
+
+//
+// Decoding and searching
+//
+
+/**
+ * Unpacks the deltas of a full block. Packed deltas are written to `narrow` and NULL is
+ * returned, for unpacked blocks the deltas are returned directly.
+ */
+static const uint64_t* delta_array_unpack_block(delta_array_p array, delta_array_block_t* block, uint32_t* narrow){
+	const uint8_t* data = (const uint8_t*)array->packed->data + block->offset;
+	if (block->bits == DELTA_ARRAY_WIDE)
+		return (const uint64_t*)data;
+	
+	if (block->bits == 0)
+		memset(narrow, 0, DELTA_ARRAY_BLOCK * sizeof(uint32_t));
+	else
+		delta_array_unpack((const uint32_t*)data, block->bits, narrow);
+	return NULL;
+}
+
+#define DELTA_ARRAY_DELTA(narrow, wide, i)  ((wide) ? (wide)[i] : (narrow)[i])
+
+#ifdef DELTA_ARRAY_SSE2
+
+/**
+ * Prefix sum over the deltas of a full block. A plain loop adds one delta after the
+ * other and each add waits for the previous one. Here each row of 4 deltas is summed
+ * up within two vectors first (shift and add), only adding the total of the previous
+ * rows is serial. That's 2 dependent instructions per row instead of 4 adds.
+ */
+static void delta_array_sum_block(delta_array_block_t* header, const uint32_t* narrow, const uint64_t* wide, int64_t* values){
+	__m128i min_delta = _mm_set1_epi64x((int64_t)header->min_delta);
+	// The first packed delta is 0, so the first value becomes the base
+	__m128i total = _mm_set1_epi64x((int64_t)(header->base - header->min_delta));
+	__m128i zero = _mm_setzero_si128();
+	
+	for(size_t row = 0; row < DELTA_ARRAY_ROWS; row++) {
+		__m128i low, high;
+		if (wide) {
+			low = _mm_loadu_si128((const __m128i*)(wide + row * DELTA_ARRAY_LANES));
+			high = _mm_loadu_si128((const __m128i*)(wide + row * DELTA_ARRAY_LANES + 2));
+		} else {
+			__m128i deltas = _mm_loadu_si128((const __m128i*)(narrow + row * DELTA_ARRAY_LANES));
+			low = _mm_unpacklo_epi32(deltas, zero);
+			high = _mm_unpackhi_epi32(deltas, zero);
+		}
+		low = _mm_add_epi64(low, min_delta);
+		high = _mm_add_epi64(high, min_delta);
+		
+		// [d0, d0+d1] and [d2, d2+d3], then add d0+d1 to the high half
+		low = _mm_add_epi64(low, _mm_slli_si128(low, 8));
+		high = _mm_add_epi64(high, _mm_slli_si128(high, 8));
+		high = _mm_add_epi64(high, _mm_unpackhi_epi64(low, low));
+		
+		low = _mm_add_epi64(low, total);
+		high = _mm_add_epi64(high, total);
+		total = _mm_unpackhi_epi64(high, high);
+		
+		_mm_storeu_si128((__m128i*)(values + row * DELTA_ARRAY_LANES), low);
+		_mm_storeu_si128((__m128i*)(values + row * DELTA_ARRAY_LANES + 2), high);
+	}
+}
+
+#else
+
+static void delta_array_sum_block(delta_array_block_t* header, const uint32_t* narrow, const uint64_t* wide, int64_t* values){
+	uint64_t value = header->base;
+	values[0] = (int64_t)value;
+	for(size_t i = 1; i < DELTA_ARRAY_BLOCK; i++) {
+		value += header->min_delta + DELTA_ARRAY_DELTA(narrow, wide, i);
+		values[i] = (int64_t)value;
+	}
+}
+
+#endif
+
+/**
+ * Decodes a full block into `values`.
+ */
+static void delta_array_decode_full_block(delta_array_p array, delta_array_block_t* header, int64_t* values){
+	uint32_t narrow[DELTA_ARRAY_BLOCK];
+	const uint64_t* wide = delta_array_unpack_block(array, header, narrow);
+	delta_array_sum_block(header, narrow, wide, values);
+}
+
+size_t delta_array_block_count(delta_array_p array){
+	return array->blocks->length + (array->pending_length > 0);
+}
+
+size_t delta_array_decode_block(delta_array_p array, size_t block, int64_t* values){
+	if (block == array->blocks->length) {
+		memcpy(values, array->pending, array->pending_length * sizeof(int64_t));
+		return array->pending_length;
+	}
+	
+	delta_array_decode_full_block(array, array_elem_ptr(array->blocks, block), values);
+	return DELTA_ARRAY_BLOCK;
+}
+
+int64_t delta_array_get(delta_array_p array, size_t index){
+	size_t block = index / DELTA_ARRAY_BLOCK, offset = index % DELTA_ARRAY_BLOCK;
+	if (block == array->blocks->length)
+		return array->pending[offset];
+	
+	delta_array_block_t* header = array_elem_ptr(array->blocks, block);
+	uint32_t narrow[DELTA_ARRAY_BLOCK];
+	const uint64_t* wide = delta_array_unpack_block(array, header, narrow);
+	
+	uint64_t value = header->base + offset * header->min_delta;
+	for(size_t i = 1; i <= offset; i++)
+		value += DELTA_ARRAY_DELTA(narrow, wide, i);
+	return (int64_t)value;
+}
+
+/**
+ * Works on unsorted values as well, so every block is decoded and scanned.
+ */
+ssize_t delta_array_find(delta_array_p array, int64_t value){
+	int64_t values[DELTA_ARRAY_BLOCK];
+	
+	for(size_t b = 0; b < array->blocks->length; b++) {
+		delta_array_decode_full_block(array, array_elem_ptr(array->blocks, b), values);
+		
+		// Without an early exit the compiler can vectorize the comparisons
+		bool found = false;
+		for(size_t i = 0; i < DELTA_ARRAY_BLOCK; i++)
+			found |= (values[i] == value);
+		if (!found)
+			continue;
+		
+		for(size_t i = 0; i < DELTA_ARRAY_BLOCK; i++) {
+			if (values[i] == value)
+				return b * DELTA_ARRAY_BLOCK + i;
+		}
+	}
+	
+	for(size_t i = 0; i < array->pending_length; i++) {
+		if (array->pending[i] == value)
+			return array->blocks->length * DELTA_ARRAY_BLOCK + i;
+	}
+	return -1;
+}
+
+/**
+ * The first values of the blocks are in the headers, so a binary search over them finds
+ * the only block that can contain the lower bound without decoding anything. Only that
+ * block is decoded.
+ */
+size_t delta_array_lower_bound(delta_array_p array, int64_t value){
+	delta_array_block_t* headers = array->blocks->data;
+	size_t blocks = array->blocks->length;
+	
+	// First block that starts at or after the value
+	size_t low = 0, high = blocks;
+	while (low < high) {
+		size_t middle = low + (high - low) / 2;
+		if ((int64_t)headers[middle].base < value)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	
+	if (low > 0) {
+		// The lower bound is in the previous block or is the first value of this one
+		int64_t values[DELTA_ARRAY_BLOCK];
+		delta_array_decode_full_block(array, &headers[low - 1], values);
+		for(size_t i = 1; i < DELTA_ARRAY_BLOCK; i++) {
+			if (values[i] >= value)
+				return (low - 1) * DELTA_ARRAY_BLOCK + i;
+		}
+	}
+	
+	if (low < blocks)
+		return low * DELTA_ARRAY_BLOCK;
+	
+	size_t i = 0;
+	while (i < array->pending_length && array->pending[i] < value)
+		i++;
+	return blocks * DELTA_ARRAY_BLOCK + i;
+}
+
+size_t delta_array_memory(delta_array_p array){
+	return sizeof(delta_array_t) + array->blocks->length * sizeof(delta_array_block_t) + array->packed->length;
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+
+/**
+
+# Compressed arrays of 64 bit integers
+
+Stores int64_t values in blocks of 128. Each block keeps its first value and the
+differences between neighbours (deltas). The smallest delta of the block is subtracted
+from all of them (frame of reference) and the rest is bit-packed with just as many bits
+as the largest one needs. Sorted IDs with small gaps take a few bits per value instead
+of 64, a dense range of IDs (all deltas equal) takes none at all. Unsorted values work
+as well but compress worse, blocks with deltas that need more than 32 bits are stored
+unpacked.
+
+The deltas of a block are packed in the layout of SIMD-BP128 (4 interleaved 32 bit
+lanes), so whole vectors are unpacked at once with SSE2. Each block has a header with
+its first value and the offset of its packed deltas. Random access only decodes one
+block. delta_array_lower_bound() finds the only block that can contain the value with
+a binary search over the first values and decodes just that one. delta_array_find()
+also works on unsorted values, so it decodes every block. The deltas are summed up
+row by row with SSE2 as well.
+
+Values are appended. The last, not yet full block is kept unpacked until it is full.
+
+delta_array_p ids = delta_array_new();
+delta_array_append(ids, 17);
+delta_array_append_n(ids, values, count);
+
+int64_t value = delta_array_get(ids, 1);
+ssize_t index = delta_array_find(ids, 42);           // first index of 42, -1 if not found
+size_t  i     = delta_array_lower_bound(ids, 42);    // sorted arrays only, like array_lower_bound()
+
+// Decoding everything, block by block
+int64_t values[DELTA_ARRAY_BLOCK];
+for(size_t b = 0; b < delta_array_block_count(ids); b++) {
+	size_t n = delta_array_decode_block(ids, b, values);
+	…
+}
+
+delta_array_memory(ids);   // bytes used by the compressed values
+delta_array_destroy(ids);
+
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include "array.h"
+
+
+#define DELTA_ARRAY_BLOCK  128
+
+typedef struct {
+	uint64_t base;       // First value of the block
+	uint64_t min_delta;  // Subtracted from all deltas before packing
+	uint64_t offset;     // Of the packed deltas in the packed data
+	uint8_t bits;        // Per packed delta, 0 to 32 or 64 for unpacked deltas
+} delta_array_block_t;
+
+typedef struct {
+	size_t length;
+	array_p blocks;  // delta_array_block_t of all full blocks
+	array_p packed;  // uint8_t
+	
+	size_t pending_length;
+	int64_t pending[DELTA_ARRAY_BLOCK];  // Values of the last block until it's full
+} delta_array_t, *delta_array_p;
+
+delta_array_p delta_array_new();
+void          delta_array_destroy(delta_array_p array);
+
+// Return false if the memory for a new block couldn't be allocated
+bool          delta_array_append(delta_array_p array, int64_t value);
+bool          delta_array_append_n(delta_array_p array, const int64_t* values, size_t n);
+
+int64_t       delta_array_get(delta_array_p array, size_t index);
+ssize_t       delta_array_find(delta_array_p array, int64_t value);
+size_t        delta_array_lower_bound(delta_array_p array, int64_t value);
+
+// Including the last, partial block
+size_t        delta_array_block_count(delta_array_p array);
+// Writes the values of a block to `values`, returns their number
+size_t        delta_array_decode_block(delta_array_p array, size_t block, int64_t* values);
+size_t        delta_array_memory(delta_array_p array);
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include <stdlib.h>
+#include <string.h>
+#include "deque.h"
+
+deque_p deque_new(size_t element_size){
+	deque_p deque = malloc(sizeof(deque_t));
+	if (deque == NULL)
+		return NULL;
+	
+	deque->buffer = array_new(0, element_size);
+	if (deque->buffer == NULL) {
+		free(deque);
+		return NULL;
+	}
+	
+	deque->head = 0;
+	deque->length = 0;
+	return deque;
+}
+
+void deque_destroy(deque_p deque){
+	array_destroy(deque->buffer);
+	free(deque);
+}
+
+/**
+ * After the buffer grew the elements that wrapped around the end of the old capacity
+ * have to be moved. The new capacity is at least twice the old one, so either part fits
+ * behind the other without overlap and we move the smaller one.
+ */
+bool deque_reserve(deque_p deque, size_t capacity){
+	array_p buffer = deque->buffer;
+	size_t old_capacity = buffer->capacity;
+	if (capacity <= old_capacity)
+		return true;
+	
+	size_t new_capacity = DEQUE_MIN_CAPACITY;
+	while (new_capacity < capacity)
+		new_capacity *= 2;
+	
+	if ( !array_reserve(buffer, new_capacity) )
+		return false;
+	buffer->length = buffer->capacity;
+	
+	if (deque->head + deque->length > old_capacity) {
+		size_t element_size = buffer->element_size;
+		size_t head_part = old_capacity - deque->head;
+		size_t wrapped_part = deque->length - head_part;
+		
+		if (wrapped_part <= head_part) {
+			memcpy((char*)buffer->data + old_capacity * element_size, buffer->data, wrapped_part * element_size);
+		} else {
+			size_t new_head = new_capacity - head_part;
+			memcpy((char*)buffer->data + new_head * element_size, (char*)buffer->data + deque->head * element_size, head_part * element_size);
+			deque->head = new_head;
+		}
+	}
+	
+	return true;
+}
+
+static bool deque_grow_if_full(deque_p deque){
+	size_t capacity = deque->buffer->capacity;
+	if (deque->length < capacity)
+		return true;
+	
+	size_t grown_capacity = capacity * deque->buffer->growth_factor;
+	return deque_reserve(deque, (grown_capacity > capacity) ? grown_capacity : capacity + 1);
+}
+
+void* deque_elem_ptr(deque_p deque, size_t index){
+	size_t mask = deque->buffer->capacity - 1;
+	return (char*)deque->buffer->data + ((deque->head + index) & mask) * deque->buffer->element_size;
+}
+
+void* deque_push_back_ptr(deque_p deque){
+	if ( !deque_grow_if_full(deque) )
+		return NULL;
+	
+	deque->length++;
+	return deque_elem_ptr(deque, deque->length - 1);
+}
+
+void* deque_push_front_ptr(deque_p deque){
+	if ( !deque_grow_if_full(deque) )
+		return NULL;
+	
+	deque->head = (deque->head - 1) & (deque->buffer->capacity - 1);
+	deque->length++;
+	return deque_elem_ptr(deque, 0);
+}
+
+void* deque_pop_back_ptr(deque_p deque){
+	if (deque->length == 0)
+		return NULL;
+	
+	deque->length--;
+	return deque_elem_ptr(deque, deque->length);
+}
+
+void* deque_pop_front_ptr(deque_p deque){
+	if (deque->length == 0)
+		return NULL;
+	
+	void* elem = deque_elem_ptr(deque, 0);
+	deque->head = (deque->head + 1) & (deque->buffer->capacity - 1);
+	deque->length--;
+	return elem;
+}
+
+void deque_pop_front_n(deque_p deque, size_t n){
+	if (n > deque->length)
+		n = deque->length;
+	
+	if (n > 0) {
+		deque->head = (deque->head + n) & (deque->buffer->capacity - 1);
+		deque->length -= n;
+	}
+}
+
+void deque_pop_back_n(deque_p deque, size_t n){
+	deque->length -= (n < deque->length) ? n : deque->length;
+}
+
+size_t deque_views(deque_p deque, array_view_t* first, array_view_t* second){
+	size_t first_length = deque->buffer->capacity - deque->head;
+	if (first_length > deque->length)
+		first_length = deque->length;
+	
+	*first = array_slice(deque->buffer, deque->head, first_length);
+	*second = array_slice(deque->buffer, 0, deque->length - first_length);
+	// A length of 0 means "until the end" for array_slice()
+	first->length = first->capacity = first_length;
+	second->length = second->capacity = deque->length - first_length;
+	
+	return deque->length;
+}
\ No newline at end of file
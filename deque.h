@@ -0,0 +1,77 @@
+#pragma once
+
+/**
+
+# Double ended queues
+
+A ring buffer on top of an array_t. Pushing and popping at both ends is O(1), nothing
+is moved except when the buffer grows. The capacity is always a power of two, so the
+index math is just a mask. Using an array as FIFO by appending and removing index 0
+moves all elements on every pop, use a deque instead.
+
+The elements are stored in the `buffer` array (its length is always its capacity). Its
+growth policy is used, see array_set_policy(): When a full deque grows the capacity is
+multiplied by the growth factor and rounded up to the next power of two. The buffer
+never shrinks automatically.
+
+deque_p d = deque_of(int);
+deque_push_back(d, int, 1);
+deque_push_front(d, int, 0);
+deque_elem(d, int, 1);           // -> 1
+deque_pop_front(d, int);         // -> 0, crashes if the deque is empty
+int* last = deque_pop_back_ptr(d);  // NULL if the deque is empty, valid until the next push
+
+// Batch consumption: the elements in order as up to two contiguous views (the second
+// one is empty if the elements don't wrap around the end of the buffer).
+array_view_t first, second;
+deque_views(d, &first, &second);
+process(array_data(&first, int), first.length);
+process(array_data(&second, int), second.length);
+deque_pop_front_n(d, first.length + second.length);
+
+deque_destroy(d);
+
+*/
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "array.h"
+
+
+#define DEQUE_MIN_CAPACITY  8
+
+typedef struct {
+	array_p buffer;
+	size_t head;    // Index of the first element in the buffer
+	size_t length;
+} deque_t, *deque_p;
+
+#define deque_of(type)  deque_new(sizeof(type))
+
+#define deque_elem(deque, type, index)         (*(type*)deque_elem_ptr(deque, index))
+#define deque_push_back(deque, type, value)    (*(type*)deque_push_back_ptr(deque) = (value))
+#define deque_push_front(deque, type, value)   (*(type*)deque_push_front_ptr(deque) = (value))
+#define deque_pop_back(deque, type)            (*(type*)deque_pop_back_ptr(deque))
+#define deque_pop_front(deque, type)           (*(type*)deque_pop_front_ptr(deque))
+
+deque_p deque_new(size_t element_size);
+void    deque_destroy(deque_p deque);
+
+// Makes sure the capacity is at least `capacity` elements (rounded up to a power of two)
+bool    deque_reserve(deque_p deque, size_t capacity);
+
+void*   deque_elem_ptr(deque_p deque, size_t index);
+// Return a pointer to the new element or NULL if the buffer couldn't grow
+void*   deque_push_back_ptr(deque_p deque);
+void*   deque_push_front_ptr(deque_p deque);
+// Return a pointer to the removed element (valid until the next push) or NULL if the
+// deque is empty
+void*   deque_pop_back_ptr(deque_p deque);
+void*   deque_pop_front_ptr(deque_p deque);
+
+// Removes `n` elements (at most all) from the front or back
+void    deque_pop_front_n(deque_p deque, size_t n);
+void    deque_pop_back_n(deque_p deque, size_t n);
+
+// Sets `first` and `second` to views of the elements in order, returns the length
+size_t  deque_views(deque_p deque, array_view_t* first, array_view_t* second);
\ No newline at end of file
@@ -1,8 +1,14 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <string.h>
 #include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <pthread.h>
 #include "hash.h"
 
 /**
@@ -67,10 +73,14 @@
 // Internal implementation functions that work for hash and dict (thus "unified hash")
 static unified_hash_p unified_hash_new(size_t capacity, size_t value_size, uint8_t key_type);
 static void           unified_hash_destroy(unified_hash_p hash);
+static void           unified_hash_clear(unified_hash_p hash);
 static ssize_t        unified_hash_search(unified_hash_p hashmap, int64_t int_key, const char* string_key, uint64_t hash);
 
 static void*          unified_hash_get_ptr(unified_hash_p hashmap, int64_t int_key, const char* string_key);
 static void*          unified_hash_put_ptr(unified_hash_p hashmap, int64_t int_key, const char* string_key);
+static void*          unified_hash_get_elem(unified_hash_p hashmap, int64_t int_key, const char* string_key);
+static void*          unified_hash_put_elem(unified_hash_p hashmap, int64_t int_key, const char* string_key, bool* reused_deleted);
+static void*          unified_hash_put_hashed(unified_hash_p hashmap, int64_t int_key, const char* string_key, unified_hash_hash_t hash, bool* reused_deleted);
 static void           unified_hash_remove(hash_p hashmap, int64_t int_key, const char* string_key);
 static void           unified_hash_remove_elem(hash_p hashmap, void* element);
 static bool           unified_hash_contains(hash_p hashmap, int64_t int_key, const char* string_key);
@@ -78,8 +88,34 @@ static bool           unified_hash_contains(hash_p hashmap, int64_t int_key, con
 static void*          unified_hash_start(unified_hash_p hashmap);
 static void*          unified_hash_next(unified_hash_p hashmap, void* element);
 static void*          unified_hash_element_at_or_after_slot(unified_hash_p hash, void* slot);
+static void*          unified_hash_element_in_range(unified_hash_p hash, void* slot, void* end);
+static void*          unified_hash_range_slot(unified_hash_p hash, size_t range, size_t ranges);
+static void*          unified_hash_range_start(unified_hash_p hash, size_t range, size_t ranges);
+static void*          unified_hash_range_next(unified_hash_p hash, void* element, size_t range, size_t ranges);
+static void           unified_hash_parallel_for(unified_hash_p hash, hash_parallel_func_t func, void* context, size_t threads);
 
 static void           unified_hash_resize(unified_hash_p hash, size_t new_capacity);
+static unified_hash_p unified_hash_copy(unified_hash_p hash, size_t new_capacity);
+static void           unified_hash_copy_elements(unified_hash_p dest, unified_hash_p src);
+
+static void           unified_hash_merge(unified_hash_p dest, unified_hash_p src, hash_combine_func_t combine);
+static void           unified_hash_intersect(unified_hash_p dest, unified_hash_p other, hash_combine_func_t combine);
+static void           unified_hash_difference(unified_hash_p dest, unified_hash_p other);
+static void           unified_hash_reserve(unified_hash_p hash, size_t length);
+
+static bool           unified_hash_save(unified_hash_p hash, const char* path);
+static pid_t          unified_hash_snapshot_async(unified_hash_p hash, const char* path);
+static bool           unified_hash_write_snapshot(unified_hash_p hash, const char* temp_path, const char* path);
+static unified_hash_p unified_hash_load(const char* path, uint8_t key_type, char** key_storage);
+
+// Multimap implementation functions, also shared by hash and dict
+static unified_multi_hash_t* unified_multi_new(size_t capacity, size_t value_size, uint8_t key_type);
+static void           unified_multi_destroy(unified_multi_hash_t* multi);
+static void*          unified_multi_put_ptr(unified_multi_hash_t* multi, int64_t int_key, const char* string_key);
+static void*          unified_multi_get(unified_multi_hash_t* multi, int64_t int_key, const char* string_key, size_t* count);
+static void           unified_multi_remove_one(unified_multi_hash_t* multi, int64_t int_key, const char* string_key, size_t index);
+static void           unified_multi_remove_all(unified_multi_hash_t* multi, int64_t int_key, const char* string_key);
+static void*          unified_multi_values(void* element, size_t* count);
 
 // Prime functions
        size_t         snap_to_prime(size_t x);
@@ -92,34 +128,88 @@ static bool           is_prime(size_t x);
 
 hash_p  hash_new(size_t capacity, size_t value_size) { return unified_hash_new(capacity, value_size, UNIFIED_HASH_NUMERIC_KEYS); }
 void    hash_destroy(hash_p hash)                    { unified_hash_destroy(hash); }
+void    hash_clear(hash_p hash)                      { unified_hash_clear(hash); }
 void    hash_resize(hash_p hash, size_t capacity)    { unified_hash_resize(hash, capacity); }
+hash_p  hash_copy(hash_p hash)                       { return unified_hash_copy(hash, hash->capacity); }
+
+void    hash_merge(hash_p dest, hash_p src, hash_combine_func_t combine)        { unified_hash_merge(dest, src, combine); }
+void    hash_intersect(hash_p dest, hash_p other, hash_combine_func_t combine)  { unified_hash_intersect(dest, other, combine); }
+void    hash_difference(hash_p dest, hash_p other)                              { unified_hash_difference(dest, other); }
+
+bool    hash_save(hash_p hash, const char* path)            { return unified_hash_save(hash, path); }
+pid_t   hash_snapshot_async(hash_p hash, const char* path)  { return unified_hash_snapshot_async(hash, path); }
+hash_p  hash_load(const char* path)                         { return unified_hash_load(path, UNIFIED_HASH_NUMERIC_KEYS, NULL); }
 
 void*   hash_get_ptr(hash_p hash, hash_key_t key)    { return unified_hash_get_ptr(hash, key, NULL); }
 void*   hash_put_ptr(hash_p hash, hash_key_t key)    { return unified_hash_put_ptr(hash, key, NULL); }
 void    hash_remove(hash_p hash, hash_key_t key)     { unified_hash_remove(hash, key, NULL); }
 bool    hash_contains(hash_p hash, hash_key_t key)   { return unified_hash_contains(hash, key, NULL); }
 
+hash_elem_t hash_get_elem(hash_p hash, hash_key_t key)         { return unified_hash_get_elem(hash, key, NULL); }
+hash_elem_t hash_put_elem(hash_p hash, hash_key_t key)         { return unified_hash_put_elem(hash, key, NULL, NULL); }
+hash_elem_t hash_put_elem_tracked(hash_p hash, hash_key_t key, bool* reused_deleted)  { return unified_hash_put_elem(hash, key, NULL, reused_deleted); }
 hash_elem_t hash_start(hash_p hash)                            { return unified_hash_start(hash); }
 hash_elem_t hash_next(hash_p hash, hash_elem_t element)        { return unified_hash_next(hash, element); }
 hash_key_t  hash_key(hash_elem_t element)                      { return *slot_key_ptr(element, hash_key_t); }
 void*       hash_value_ptr(hash_elem_t element)                { return slot_value_ptr(element); }
 void        hash_remove_elem(hash_p hash, hash_elem_t element) { unified_hash_remove_elem(hash, element); }
+hash_elem_t hash_range_start(hash_p hash, size_t range, size_t ranges)                       { return unified_hash_range_start(hash, range, ranges); }
+hash_elem_t hash_range_next(hash_p hash, hash_elem_t element, size_t range, size_t ranges)   { return unified_hash_range_next(hash, element, range, ranges); }
+void        hash_parallel_for(hash_p hash, hash_parallel_func_t func, void* context, size_t threads)  { unified_hash_parallel_for(hash, func, context, threads); }
+size_t      hash_key_hash(hash_key_t key)                      { return int_hash(key); }
 
 
 dict_p  dict_new(size_t capacity, size_t value_size) { return unified_hash_new(capacity, value_size, UNIFIED_HASH_STRING_KEYS); }
 void    dict_destroy(dict_p dict)                    { unified_hash_destroy(dict); }
+void    dict_clear(dict_p dict)                      { unified_hash_clear(dict); }
 void    dict_resize(dict_p dict, size_t capacity)    { unified_hash_resize(dict, capacity); }
+dict_p  dict_copy(dict_p dict)                       { return unified_hash_copy(dict, dict->capacity); }
+
+void    dict_merge(dict_p dest, dict_p src, hash_combine_func_t combine)        { unified_hash_merge(dest, src, combine); }
+void    dict_intersect(dict_p dest, dict_p other, hash_combine_func_t combine)  { unified_hash_intersect(dest, other, combine); }
+void    dict_difference(dict_p dest, dict_p other)                              { unified_hash_difference(dest, other); }
+
+bool    dict_save(dict_p dict, const char* path)                 { return unified_hash_save(dict, path); }
+pid_t   dict_snapshot_async(dict_p dict, const char* path)       { return unified_hash_snapshot_async(dict, path); }
+dict_p  dict_load(const char* path, char** key_storage)          { return unified_hash_load(path, UNIFIED_HASH_STRING_KEYS, key_storage); }
 
 void*   dict_get_ptr(dict_p dict, const char* key)    { return unified_hash_get_ptr(dict, 0, key); }
 void*   dict_put_ptr(dict_p dict, const char* key)    { return unified_hash_put_ptr(dict, 0, key); }
 void    dict_remove(dict_p dict, const char* key)     { unified_hash_remove(dict, 0, key); }
 bool    dict_contains(dict_p dict, const char* key)   { return unified_hash_contains(dict, 0, key); }
 
+dict_elem_t dict_get_elem(dict_p dict, const char* key)        { return unified_hash_get_elem(dict, 0, key); }
+dict_elem_t dict_put_elem(dict_p dict, const char* key)        { return unified_hash_put_elem(dict, 0, key, NULL); }
+dict_elem_t dict_put_elem_tracked(dict_p dict, const char* key, bool* reused_deleted)  { return unified_hash_put_elem(dict, 0, key, reused_deleted); }
 dict_elem_t dict_start(dict_p dict)                            { return unified_hash_start(dict); }
 dict_elem_t dict_next(dict_p dict, dict_elem_t element)        { return unified_hash_next(dict, element); }
 const char* dict_key(dict_elem_t element)                      { return *slot_key_ptr(element, const char*); }
 void*       dict_value_ptr(dict_elem_t element)                { return slot_value_ptr(element); }
 void        dict_remove_elem(dict_p dict, dict_elem_t element) { unified_hash_remove_elem(dict, element); }
+dict_elem_t dict_range_start(dict_p dict, size_t range, size_t ranges)                       { return unified_hash_range_start(dict, range, ranges); }
+dict_elem_t dict_range_next(dict_p dict, dict_elem_t element, size_t range, size_t ranges)   { return unified_hash_range_next(dict, element, range, ranges); }
+void        dict_parallel_for(dict_p dict, hash_parallel_func_t func, void* context, size_t threads)  { unified_hash_parallel_for(dict, func, context, threads); }
+size_t      dict_key_hash(const char* key)                     { return string_hash(key); }
+
+
+multi_hash_p hash_multi_new(size_t capacity, size_t value_size)                { return unified_multi_new(capacity, value_size, UNIFIED_HASH_NUMERIC_KEYS); }
+void         hash_multi_destroy(multi_hash_p hash)                             { unified_multi_destroy(hash); }
+void*        hash_multi_put_ptr(multi_hash_p hash, hash_key_t key)             { return unified_multi_put_ptr(hash, key, NULL); }
+void*        hash_multi_get(multi_hash_p hash, hash_key_t key, size_t* count)  { return unified_multi_get(hash, key, NULL, count); }
+size_t       hash_multi_count(multi_hash_p hash, hash_key_t key)               { size_t count = 0; unified_multi_get(hash, key, NULL, &count); return count; }
+void         hash_multi_remove_one(multi_hash_p hash, hash_key_t key, size_t i) { unified_multi_remove_one(hash, key, NULL, i); }
+void         hash_multi_remove_all(multi_hash_p hash, hash_key_t key)          { unified_multi_remove_all(hash, key, NULL); }
+void*        hash_multi_values(hash_elem_t element, size_t* count)             { return unified_multi_values(element, count); }
+
+
+multi_dict_p dict_multi_new(size_t capacity, size_t value_size)                   { return unified_multi_new(capacity, value_size, UNIFIED_HASH_STRING_KEYS); }
+void         dict_multi_destroy(multi_dict_p dict)                                { unified_multi_destroy(dict); }
+void*        dict_multi_put_ptr(multi_dict_p dict, const char* key)               { return unified_multi_put_ptr(dict, 0, key); }
+void*        dict_multi_get(multi_dict_p dict, const char* key, size_t* count)    { return unified_multi_get(dict, 0, key, count); }
+size_t       dict_multi_count(multi_dict_p dict, const char* key)                 { size_t count = 0; unified_multi_get(dict, 0, key, &count); return count; }
+void         dict_multi_remove_one(multi_dict_p dict, const char* key, size_t i)  { unified_multi_remove_one(dict, 0, key, i); }
+void         dict_multi_remove_all(multi_dict_p dict, const char* key)            { unified_multi_remove_all(dict, 0, key); }
+void*        dict_multi_values(dict_elem_t element, size_t* count)                { return unified_multi_values(element, count); }
 
 
 //
@@ -152,6 +242,15 @@ static void unified_hash_destroy(unified_hash_p hash){
 	free(hash);
 }
 
+/**
+ * Removes all elements but keeps the slots allocated. Free slots are all zero, so this
+ * also clears the slots marked as deleted.
+ */
+static void unified_hash_clear(unified_hash_p hash){
+	memset(hash->slots, 0, hash->capacity * slot_size(hash));
+	hash->length = 0;
+}
+
 
 //
 // Lookup, get and put functions
@@ -205,26 +304,58 @@ static ssize_t unified_hash_search(unified_hash_p hashmap, hash_key_t int_key, c
 }
 
 static void* unified_hash_get_ptr(unified_hash_p hashmap, hash_key_t int_key, const char* string_key){
+	void* slot = unified_hash_get_elem(hashmap, int_key, string_key);
+	if (slot == NULL)
+		return NULL;
+	return slot_value_ptr(slot);
+}
+
+static void* unified_hash_put_ptr(unified_hash_p hashmap, hash_key_t int_key, const char* string_key){
+	return slot_value_ptr(unified_hash_put_elem(hashmap, int_key, string_key, NULL));
+}
+
+/**
+ * Same as the get and put functions but return the element (slot) instead of a
+ * pointer to the value. Elements stay valid until the hashmap is resized.
+ * 
+ * If `reused_deleted` isn't NULL the put function sets it to whether a new key went
+ * into a slot marked as deleted. Callers that track the deleted slots of a hashmap
+ * (e.g. to rebuild it) need that to keep their count right.
+ */
+static void* unified_hash_get_elem(unified_hash_p hashmap, hash_key_t int_key, const char* string_key){
 	unified_hash_hash_t hash = (hashmap->key_type == UNIFIED_HASH_NUMERIC_KEYS) ? int_hash(int_key) : string_hash(string_key);
 	ssize_t index = unified_hash_search(hashmap, int_key, string_key, hash);
 	if (index < 0)
 		return NULL;
-	return slot_value_ptr(slot_ptr(hashmap, index));
+	return slot_ptr(hashmap, index);
 }
 
-static void* unified_hash_put_ptr(unified_hash_p hashmap, hash_key_t int_key, const char* string_key){
+static void* unified_hash_put_elem(unified_hash_p hashmap, hash_key_t int_key, const char* string_key, bool* reused_deleted){
 	if (hashmap->length + 1 > hashmap->capacity * 0.75)
 		unified_hash_resize(hashmap, snap_to_prime(hashmap->capacity * 2));
 	
 	unified_hash_hash_t hash = (hashmap->key_type == UNIFIED_HASH_NUMERIC_KEYS) ? int_hash(int_key) : string_hash(string_key);
+	return unified_hash_put_hashed(hashmap, int_key, string_key, hash, reused_deleted);
+}
+
+/**
+ * Puts the key with an already calculated hash. Used to move elements between hashmaps
+ * without hashing their keys again. The caller has to make sure the hashmap has enough
+ * free slots.
+ */
+static void* unified_hash_put_hashed(unified_hash_p hashmap, hash_key_t int_key, const char* string_key, unified_hash_hash_t hash, bool* reused_deleted){
 	ssize_t index = unified_hash_search(hashmap, int_key, string_key, hash);
 	void* slot = NULL;
+	if (reused_deleted)
+		*reused_deleted = false;
 	
 	if (index < 0) {
 		// Key wasn't found. The return value is -(next_free_index + 1).
 		index = -index - 1;
 		slot = slot_ptr(hashmap, index);
 		
+		if (reused_deleted)
+			*reused_deleted = (*slot_hash_ptr(slot) == UNIFIED_HASH_SLOT_DELETED);
 		*slot_hash_ptr(slot) = hash;
 		if (hashmap->key_type == UNIFIED_HASH_NUMERIC_KEYS)
 			*slot_key_ptr(slot, hash_key_t) = int_key;
@@ -235,7 +366,7 @@ static void* unified_hash_put_ptr(unified_hash_p hashmap, hash_key_t int_key, co
 		slot = slot_ptr(hashmap, index);
 	}
 	
-	return slot_value_ptr(slot);
+	return slot;
 }
 
 void unified_hash_remove(hash_p hashmap, hash_key_t int_key, const char* string_key){
@@ -282,7 +413,14 @@ void* unified_hash_next(unified_hash_p hashmap, void* element){
  * Returns NULL if there is no element at or after `slot`.
  */
 static void* unified_hash_element_at_or_after_slot(unified_hash_p hash, void* slot){
-	for(char* ptr = slot; ptr < (char*)hash->slots + slot_size(hash) * hash->capacity; ptr += slot_size(hash)) {
+	return unified_hash_element_in_range(hash, slot, (char*)hash->slots + slot_size(hash) * hash->capacity);
+}
+
+/**
+ * Same as unified_hash_element_at_or_after_slot() but stops scanning at `end`.
+ */
+static void* unified_hash_element_in_range(unified_hash_p hash, void* slot, void* end){
+	for(char* ptr = slot; ptr < (char*)end; ptr += slot_size(hash)) {
 		uint64_t slot_hash = *slot_hash_ptr(ptr);
 		if ( slot_hash != UNIFIED_HASH_SLOT_FREE && slot_hash != UNIFIED_HASH_SLOT_DELETED )
 			return ptr;
@@ -292,6 +430,100 @@ static void* unified_hash_element_at_or_after_slot(unified_hash_p hash, void* sl
 }
 
 
+//
+// Partitioned iteration
+// 
+// The slot array is split into `ranges` parts of (almost) the same number of slots.
+// With a decent hash function the elements are spread evenly over the slots, so the
+// ranges contain about the same number of elements. Ranges don't overlap and together
+// cover all slots, so every element is visited by exactly one range.
+//
+
+/**
+ * Returns the first slot of `range`. With range == ranges it returns the end of the
+ * slot array. The first `capacity % ranges` ranges get one slot more than the others.
+ * 0 ranges are treated as one range covering all slots.
+ */
+static void* unified_hash_range_slot(unified_hash_p hash, size_t range, size_t ranges){
+	if (ranges == 0)
+		ranges = 1;
+	size_t remainder = hash->capacity % ranges;
+	size_t index = hash->capacity / ranges * range + (range < remainder ? range : remainder);
+	return slot_ptr(hash, index);
+}
+
+static void* unified_hash_range_start(unified_hash_p hash, size_t range, size_t ranges){
+	return unified_hash_element_in_range(hash, unified_hash_range_slot(hash, range, ranges), unified_hash_range_slot(hash, range + 1, ranges));
+}
+
+static void* unified_hash_range_next(unified_hash_p hash, void* element, size_t range, size_t ranges){
+	return unified_hash_element_in_range(hash, (char*)element + slot_size(hash), unified_hash_range_slot(hash, range + 1, ranges));
+}
+
+typedef struct {
+	unified_hash_p hash;
+	size_t range, ranges;
+	hash_parallel_func_t func;
+	void* context;
+	pthread_t thread;
+	bool started;
+} unified_hash_parallel_task_t;
+
+static void* unified_hash_parallel_worker(void* arg){
+	unified_hash_parallel_task_t* task = arg;
+	void* end = unified_hash_range_slot(task->hash, task->range + 1, task->ranges);
+	
+	for(void* elem = unified_hash_range_start(task->hash, task->range, task->ranges); elem != NULL; elem = unified_hash_element_in_range(task->hash, (char*)elem + slot_size(task->hash), end))
+		task->func(elem, task->range, task->context);
+	
+	return NULL;
+}
+
+/**
+ * Calls `func(element, range, context)` for each element, with `threads` ranges processed
+ * in parallel. The calling thread processes range 0 and `threads - 1` additional threads
+ * the others. `range` tells the function which range (and therefore thread) it runs in,
+ * e.g. to sum into one counter per range without any locking. The hashmap must not be
+ * modified while the threads run.
+ * 
+ * If a thread can't be started its range is processed by the calling thread afterwards.
+ */
+static void unified_hash_parallel_for(unified_hash_p hash, hash_parallel_func_t func, void* context, size_t threads){
+	if (threads == 0)
+		threads = 1;
+	
+	unified_hash_parallel_task_t* tasks = malloc(threads * sizeof(unified_hash_parallel_task_t));
+	if (tasks == NULL) {
+		for(size_t range = 0; range < threads; range++) {
+			unified_hash_parallel_task_t task = { hash, range, threads, func, context, pthread_self(), false };
+			unified_hash_parallel_worker(&task);
+		}
+		return;
+	}
+	
+	for(size_t range = 0; range < threads; range++) {
+		unified_hash_parallel_task_t* task = &tasks[range];
+		task->hash = hash;
+		task->range = range;
+		task->ranges = threads;
+		task->func = func;
+		task->context = context;
+		task->started = (range > 0) && pthread_create(&task->thread, NULL, unified_hash_parallel_worker, task) == 0;
+	}
+	
+	unified_hash_parallel_worker(&tasks[0]);
+	
+	for(size_t range = 1; range < threads; range++) {
+		if (tasks[range].started)
+			pthread_join(tasks[range].thread, NULL);
+		else
+			unified_hash_parallel_worker(&tasks[range]);
+	}
+	
+	free(tasks);
+}
+
+
 
 static void unified_hash_resize(unified_hash_p hash, size_t new_capacity){
 	// Just in case: avoid to make the hashmap smaller than it can be
@@ -310,16 +542,479 @@ static void unified_hash_resize(unified_hash_p hash, size_t new_capacity){
 	if (new_hash.slots == NULL)
 		return;
 	
-	for(void* elem = unified_hash_start(hash); elem != NULL; elem = unified_hash_next(hash, elem)){
-		void* old_value_ptr = slot_value_ptr(elem);
-		void* new_value_ptr = unified_hash_put_ptr(&new_hash, *slot_key_ptr(elem, int64_t), *slot_key_ptr(elem, const char *));
-		memcpy(new_value_ptr, old_value_ptr, hash->value_size);
-	}
+	unified_hash_copy_elements(&new_hash, hash);
 	
 	free(hash->slots);
 	*hash = new_hash;
 }
 
+/**
+ * Creates a new hashmap with `new_capacity` slots that contains all elements of `hash`.
+ * The original is left untouched. Deleted slots are not copied so the copy starts without
+ * any tombstones.
+ * 
+ * Returns NULL if the memory for the copy could not be allocated.
+ */
+static unified_hash_p unified_hash_copy(unified_hash_p hash, size_t new_capacity){
+	if (new_capacity < hash->length)
+		new_capacity = hash->length;
+	
+	unified_hash_p copy = unified_hash_new(new_capacity, hash->value_size, hash->key_type);
+	if (copy == NULL)
+		return NULL;
+	
+	unified_hash_copy_elements(copy, hash);
+	return copy;
+}
+
+/**
+ * Puts all elements of `src` into `dest`. `dest` has to use the same key type and value
+ * size as `src`. The hashes stored in the slots of `src` are reused, so keys (especially
+ * strings) are not hashed again.
+ */
+static void unified_hash_copy_elements(unified_hash_p dest, unified_hash_p src){
+	for(void* elem = unified_hash_start(src); elem != NULL; elem = unified_hash_next(src, elem)){
+		if (dest->length + 1 > dest->capacity * 0.75)
+			unified_hash_resize(dest, snap_to_prime(dest->capacity * 2));
+		
+		void* old_value_ptr = slot_value_ptr(elem);
+		void* new_slot = unified_hash_put_hashed(dest, *slot_key_ptr(elem, hash_key_t), *slot_key_ptr(elem, const char *), *slot_hash_ptr(elem), NULL);
+		memcpy(slot_value_ptr(new_slot), old_value_ptr, src->value_size);
+	}
+}
+
+/**
+ * Grows the hashmap so `length` elements fit in without exceeding the load factor.
+ */
+static void unified_hash_reserve(unified_hash_p hash, size_t length){
+	if (length + 1 > hash->capacity * 0.75)
+		unified_hash_resize(hash, snap_to_prime(length / 0.75 + 1));
+}
+
+
+//
+// Set algebra functions
+// 
+// All of them work directly with the hashes stored in the slots of the source hashmap
+// instead of hashing each key again. Both hashmaps have to use the same key type and
+// the same value size.
+//
+
+/**
+ * Puts all elements of `src` into `dest`. `dest` is grown once up front to fit both. If
+ * a key is in both hashmaps `combine(dest_value, src_value)` is called. Without a
+ * combine function the value of `src` overwrites the one of `dest`.
+ */
+static void unified_hash_merge(unified_hash_p dest, unified_hash_p src, hash_combine_func_t combine){
+	unified_hash_reserve(dest, dest->length + src->length);
+	
+	for(void* elem = unified_hash_start(src); elem != NULL; elem = unified_hash_next(src, elem)){
+		size_t length_before = dest->length;
+		void* dest_slot = unified_hash_put_hashed(dest, *slot_key_ptr(elem, hash_key_t), *slot_key_ptr(elem, const char *), *slot_hash_ptr(elem), NULL);
+		
+		if (combine != NULL && dest->length == length_before)
+			combine(slot_value_ptr(dest_slot), slot_value_ptr(elem));
+		else
+			memcpy(slot_value_ptr(dest_slot), slot_value_ptr(elem), src->value_size);
+	}
+}
+
+/**
+ * Removes all elements from `dest` whose keys are not in `other`. For the remaining
+ * elements `combine(dest_value, other_value)` is called if a combine function is given.
+ */
+static void unified_hash_intersect(unified_hash_p dest, unified_hash_p other, hash_combine_func_t combine){
+	for(void* elem = unified_hash_start(dest); elem != NULL; elem = unified_hash_next(dest, elem)){
+		ssize_t index = unified_hash_search(other, *slot_key_ptr(elem, hash_key_t), *slot_key_ptr(elem, const char *), *slot_hash_ptr(elem));
+		if (index < 0)
+			unified_hash_remove_elem(dest, elem);
+		else if (combine != NULL)
+			combine(slot_value_ptr(elem), slot_value_ptr(slot_ptr(other, index)));
+	}
+	
+	if (dest->length < dest->capacity * 0.2)
+		unified_hash_resize(dest, snap_to_prime(dest->length / 0.75 + 1));
+}
+
+/**
+ * Removes all elements from `dest` whose keys are in `other`.
+ */
+static void unified_hash_difference(unified_hash_p dest, unified_hash_p other){
+	// Iterate over the smaller hashmap
+	if (other->length < dest->length) {
+		for(void* elem = unified_hash_start(other); elem != NULL; elem = unified_hash_next(other, elem)){
+			ssize_t index = unified_hash_search(dest, *slot_key_ptr(elem, hash_key_t), *slot_key_ptr(elem, const char *), *slot_hash_ptr(elem));
+			if (index >= 0)
+				unified_hash_remove_elem(dest, slot_ptr(dest, index));
+		}
+	} else {
+		for(void* elem = unified_hash_start(dest); elem != NULL; elem = unified_hash_next(dest, elem)){
+			if ( unified_hash_search(other, *slot_key_ptr(elem, hash_key_t), *slot_key_ptr(elem, const char *), *slot_hash_ptr(elem)) >= 0 )
+				unified_hash_remove_elem(dest, elem);
+		}
+	}
+	
+	if (dest->length < dest->capacity * 0.2)
+		unified_hash_resize(dest, snap_to_prime(dest->length / 0.75 + 1));
+}
+
+
+//
+// Snapshot functions
+// 
+// A snapshot file starts with a unified_hash_snapshot_header_t followed by one record
+// per element. A record is the raw slot (hash, key and value). For dicts the key field
+// of the slot is meaningless and followed by the size of the key (including the zero
+// terminator) as uint64_t and the key itself. The slot layout depends on the platform
+// so snapshots can only be loaded on the platform they were written on.
+//
+
+#define UNIFIED_HASH_SNAPSHOT_MAGIC        UINT64_C(0x31504e5348434353)  // "SCCHSNP1" in little endian
+#define UNIFIED_HASH_SNAPSHOT_BUFFER_SIZE  (64 * 1024)
+
+typedef struct {
+	uint64_t magic;
+	uint32_t key_type, value_size;
+	uint64_t slot_size, length, key_bytes;
+} unified_hash_snapshot_header_t;
+
+typedef struct {
+	int fd;
+	size_t used;
+	char buffer[UNIFIED_HASH_SNAPSHOT_BUFFER_SIZE];
+} unified_hash_snapshot_writer_t;
+
+static char* unified_hash_snapshot_temp_path(const char* path){
+	size_t size = strlen(path) + sizeof(".tmp");
+	char* temp_path = malloc(size);
+	if (temp_path != NULL)
+		snprintf(temp_path, size, "%s.tmp", path);
+	return temp_path;
+}
+
+/**
+ * Writes a snapshot of the hashmap to `path`. The snapshot is first written to
+ * "<path>.tmp" and then renamed so `path` always contains a complete snapshot.
+ */
+static bool unified_hash_save(unified_hash_p hash, const char* path){
+	char* temp_path = unified_hash_snapshot_temp_path(path);
+	if (temp_path == NULL)
+		return false;
+	
+	bool success = unified_hash_write_snapshot(hash, temp_path, path);
+	free(temp_path);
+	return success;
+}
+
+/**
+ * Forks a child process that writes the snapshot while the parent continues to work
+ * with the hashmap. The child sees the hashmap as it was at the time of the fork. The
+ * kernel only copies the pages the parent modifies afterwards (copy-on-write), so the
+ * parent just pays for the pages it touches while the snapshot is written.
+ * 
+ * Returns the pid of the child or -1 if the fork failed. The child exits with status 0
+ * if the snapshot was written successfully.
+ */
+static pid_t unified_hash_snapshot_async(unified_hash_p hash, const char* path){
+	char* temp_path = unified_hash_snapshot_temp_path(path);
+	if (temp_path == NULL)
+		return -1;
+	
+	pid_t pid = fork();
+	if (pid == 0) {
+		// _exit() instead of exit() so the child doesn't flush the stdio buffers it
+		// inherited from the parent or runs its atexit() handlers
+		bool success = unified_hash_write_snapshot(hash, temp_path, path);
+		_exit(success ? 0 : 1);
+	}
+	
+	free(temp_path);
+	return pid;
+}
+
+/**
+ * Waits for the child process of an asynchronous snapshot. Returns true if the snapshot
+ * was written successfully.
+ */
+bool hash_snapshot_wait(pid_t pid){
+	int status = 0;
+	while( waitpid(pid, &status, 0) == -1 ) {
+		if (errno != EINTR)
+			return false;
+	}
+	
+	return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static bool unified_hash_snapshot_flush(unified_hash_snapshot_writer_t* writer){
+	size_t written = 0;
+	while(written < writer->used) {
+		ssize_t result = write(writer->fd, writer->buffer + written, writer->used - written);
+		if (result == -1 && errno == EINTR)
+			continue;
+		if (result <= 0)
+			return false;
+		written += result;
+	}
+	
+	writer->used = 0;
+	return true;
+}
+
+static bool unified_hash_snapshot_write(unified_hash_snapshot_writer_t* writer, const void* data, size_t size){
+	while(size > 0) {
+		if (writer->used == UNIFIED_HASH_SNAPSHOT_BUFFER_SIZE && !unified_hash_snapshot_flush(writer))
+			return false;
+		
+		size_t chunk = UNIFIED_HASH_SNAPSHOT_BUFFER_SIZE - writer->used;
+		if (chunk > size)
+			chunk = size;
+		
+		memcpy(writer->buffer + writer->used, data, chunk);
+		writer->used += chunk;
+		data = (const char*)data + chunk;
+		size -= chunk;
+	}
+	
+	return true;
+}
+
+/**
+ * Streams all elements into `temp_path` and renames it to `path` once everything is on
+ * disk. Only uses a buffer on the stack and plain system calls, no malloc() or stdio.
+ * This keeps it safe to run in the forked child of a multithreaded process where other
+ * threads might have held locks at the time of the fork.
+ */
+static bool unified_hash_write_snapshot(unified_hash_p hash, const char* temp_path, const char* path){
+	unified_hash_snapshot_writer_t writer;
+	writer.fd = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	writer.used = 0;
+	if (writer.fd == -1)
+		return false;
+	
+	unified_hash_snapshot_header_t header = { UNIFIED_HASH_SNAPSHOT_MAGIC, hash->key_type, hash->value_size, slot_size(hash), hash->length, 0 };
+	bool success = unified_hash_snapshot_write(&writer, &header, sizeof(header));
+	
+	for(void* elem = unified_hash_start(hash); success && elem != NULL; elem = unified_hash_next(hash, elem)){
+		success = unified_hash_snapshot_write(&writer, elem, slot_size(hash));
+		
+		if (success && hash->key_type == UNIFIED_HASH_STRING_KEYS) {
+			const char* key = *slot_key_ptr(elem, const char *);
+			uint64_t key_size = strlen(key) + 1;
+			header.key_bytes += key_size;
+			success = unified_hash_snapshot_write(&writer, &key_size, sizeof(key_size)) && unified_hash_snapshot_write(&writer, key, key_size);
+		}
+	}
+	
+	// The total size of all keys is only known now, so write the header again
+	success = success && unified_hash_snapshot_flush(&writer)
+		&& pwrite(writer.fd, &header, sizeof(header), 0) == sizeof(header)
+		&& fsync(writer.fd) == 0;
+	success = (close(writer.fd) == 0) && success;
+	
+	if (success)
+		success = (rename(temp_path, path) == 0);
+	if (!success)
+		unlink(temp_path);
+	
+	return success;
+}
+
+/**
+ * Loads a snapshot written by unified_hash_save() or unified_hash_snapshot_async(). The
+ * hashmap is created large enough for all elements so it's never resized while loading.
+ * The stored hashes are reused, keys are not hashed again.
+ * 
+ * The keys of a dict are loaded into one memory block that is returned via
+ * `key_storage`. It has to stay alive as long as the dict uses the keys. Dicts need a
+ * `key_storage`, otherwise nothing could free the keys.
+ * 
+ * Returns NULL if the file could not be read, isn't a snapshot of the same key type or
+ * is truncated.
+ */
+static unified_hash_p unified_hash_load(const char* path, uint8_t key_type, char** key_storage){
+	if (key_type == UNIFIED_HASH_STRING_KEYS && key_storage == NULL)
+		return NULL;
+	
+	FILE* file = fopen(path, "rb");
+	if (file == NULL)
+		return NULL;
+	
+	unified_hash_snapshot_header_t header;
+	if (
+		fread(&header, sizeof(header), 1, file) != 1 || header.magic != UNIFIED_HASH_SNAPSHOT_MAGIC ||
+		header.key_type != key_type || header.slot_size != slot_hash_size() + slot_key_size() + header.value_size
+	) {
+		fclose(file);
+		return NULL;
+	}
+	
+	unified_hash_p hash = unified_hash_new(snap_to_prime(header.length / 0.75 + 1), header.value_size, key_type);
+	void* record = malloc(header.slot_size);
+	char* keys = (key_type == UNIFIED_HASH_STRING_KEYS) ? malloc(header.key_bytes + 1) : NULL;
+	bool success = (hash != NULL && record != NULL && (key_type != UNIFIED_HASH_STRING_KEYS || keys != NULL));
+	
+	char* next_key = keys;
+	for(uint64_t i = 0; success && i < header.length; i++){
+		success = (fread(record, header.slot_size, 1, file) == 1);
+		unified_hash_hash_t slot_hash = *slot_hash_ptr(record);
+		success = success && slot_hash != UNIFIED_HASH_SLOT_FREE && slot_hash != UNIFIED_HASH_SLOT_DELETED;
+		
+		const char* string_key = NULL;
+		if (success && key_type == UNIFIED_HASH_STRING_KEYS) {
+			uint64_t key_size = 0;
+			success = fread(&key_size, sizeof(key_size), 1, file) == 1
+				&& key_size > 0 && key_size <= (uint64_t)(keys + header.key_bytes - next_key)
+				&& fread(next_key, key_size, 1, file) == 1
+				&& next_key[key_size - 1] == '\0';
+			string_key = next_key;
+			next_key += key_size;
+		}
+		
+		if (success) {
+			void* slot = unified_hash_put_hashed(hash, *slot_key_ptr(record, hash_key_t), string_key, slot_hash, NULL);
+			memcpy(slot_value_ptr(slot), slot_value_ptr(record), header.value_size);
+		}
+	}
+	
+	fclose(file);
+	free(record);
+	
+	if (!success) {
+		if (hash)
+			unified_hash_destroy(hash);
+		free(keys);
+		return NULL;
+	}
+	
+	if (key_storage)
+		*key_storage = keys;
+	return hash;
+}
+
+
+//
+// Multimap functions
+// 
+// The value of each key in the `keys` hashmap is a unified_multi_values_t. It points
+// to a separately allocated array with the values of that key.
+//
+
+typedef struct {
+	size_t count, capacity;
+	void* values;
+} unified_multi_values_t;
+
+static unified_multi_hash_t* unified_multi_new(size_t capacity, size_t value_size, uint8_t key_type){
+	unified_multi_hash_t* multi = malloc(sizeof(unified_multi_hash_t));
+	if (multi == NULL)
+		return NULL;
+	
+	multi->keys = unified_hash_new(capacity, sizeof(unified_multi_values_t), key_type);
+	if (multi->keys == NULL) {
+		free(multi);
+		return NULL;
+	}
+	
+	multi->value_size = value_size;
+	multi->length = 0;
+	return multi;
+}
+
+static void unified_multi_destroy(unified_multi_hash_t* multi){
+	for(void* elem = unified_hash_start(multi->keys); elem != NULL; elem = unified_hash_next(multi->keys, elem))
+		free( ((unified_multi_values_t*)slot_value_ptr(elem))->values );
+	
+	unified_hash_destroy(multi->keys);
+	free(multi);
+}
+
+/**
+ * Appends a new value to the values of the key and returns a pointer to it. The key
+ * is added if it's not in the multimap yet. Returns NULL if the value array could not
+ * be grown.
+ */
+static void* unified_multi_put_ptr(unified_multi_hash_t* multi, hash_key_t int_key, const char* string_key){
+	unified_multi_values_t* entry = unified_hash_get_ptr(multi->keys, int_key, string_key);
+	
+	if (entry == NULL) {
+		entry = unified_hash_put_ptr(multi->keys, int_key, string_key);
+		entry->count = 0;
+		entry->capacity = 0;
+		entry->values = NULL;
+	}
+	
+	if (entry->count == entry->capacity) {
+		size_t new_capacity = (entry->capacity == 0) ? 1 : entry->capacity * 2;
+		void* new_values = realloc(entry->values, new_capacity * multi->value_size);
+		if (new_values == NULL) {
+			// Don't leave a key without values behind
+			if (entry->count == 0)
+				unified_hash_remove(multi->keys, int_key, string_key);
+			return NULL;
+		}
+		
+		entry->values = new_values;
+		entry->capacity = new_capacity;
+	}
+	
+	multi->length++;
+	return (char*)entry->values + multi->value_size * entry->count++;
+}
+
+/**
+ * Returns a pointer to the first value of the key and stores the number of values in
+ * `count`. All values follow each other in memory. Returns NULL and a count of 0 if the
+ * key isn't in the multimap.
+ */
+static void* unified_multi_get(unified_multi_hash_t* multi, hash_key_t int_key, const char* string_key, size_t* count){
+	unified_multi_values_t* entry = unified_hash_get_ptr(multi->keys, int_key, string_key);
+	
+	if (entry == NULL) {
+		*count = 0;
+		return NULL;
+	}
+	
+	*count = entry->count;
+	return entry->values;
+}
+
+/**
+ * Removes the value at `index` of the keys values. The following values are moved
+ * forward so their order stays the same. The key is removed with its last value.
+ */
+static void unified_multi_remove_one(unified_multi_hash_t* multi, hash_key_t int_key, const char* string_key, size_t index){
+	unified_multi_values_t* entry = unified_hash_get_ptr(multi->keys, int_key, string_key);
+	if (entry == NULL || index >= entry->count)
+		return;
+	
+	if (entry->count == 1) {
+		unified_multi_remove_all(multi, int_key, string_key);
+		return;
+	}
+	
+	char* value_ptr = (char*)entry->values + multi->value_size * index;
+	memmove(value_ptr, value_ptr + multi->value_size, (entry->count - index - 1) * multi->value_size);
+	entry->count--;
+	multi->length--;
+}
+
+static void unified_multi_remove_all(unified_multi_hash_t* multi, hash_key_t int_key, const char* string_key){
+	unified_multi_values_t* entry = unified_hash_get_ptr(multi->keys, int_key, string_key);
+	if (entry == NULL)
+		return;
+	
+	multi->length -= entry->count;
+	free(entry->values);
+	unified_hash_remove(multi->keys, int_key, string_key);
+}
+
+static void* unified_multi_values(void* element, size_t* count){
+	unified_multi_values_t* entry = slot_value_ptr(element);
+	*count = entry->count;
+	return entry->values;
+}
+
 
 //
 // Hashing functions
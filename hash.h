@@ -1,6 +1,7 @@
 #pragma once
 
 #include <unistd.h>
+#include <sys/types.h>
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -24,6 +25,8 @@ typedef struct {
 	void* slots;
 } unified_hash_t, *unified_hash_p, *hash_p, *dict_p;
 typedef void *hash_elem_t, *dict_elem_t;
+typedef void (*hash_combine_func_t)(void* dest_value, const void* src_value);
+typedef void (*hash_parallel_func_t)(hash_elem_t element, size_t range, void* context);
 
 #if defined(__x86_64__) || defined(__ppc64__) || defined(_WIN64)
 	typedef int64_t hash_key_t;
@@ -36,7 +39,22 @@ typedef void *hash_elem_t, *dict_elem_t;
 #define hash_with(capacity, type)  hash_new(capacity, sizeof(type))
 hash_p  hash_new(size_t capacity, size_t value_size);
 void    hash_destroy(hash_p hash);
+// Removes all elements, the slots stay allocated
+void    hash_clear(hash_p hash);
 void    hash_resize(hash_p hash, size_t capacity);
+hash_p  hash_copy(hash_p hash);
+
+// Set algebra, both hashmaps need the same value size. See hash.c for details.
+void    hash_merge(hash_p dest, hash_p src, hash_combine_func_t combine);
+void    hash_intersect(hash_p dest, hash_p other, hash_combine_func_t combine);
+void    hash_difference(hash_p dest, hash_p other);
+
+// Snapshots to disk. hash_snapshot_async() writes from a forked child, wait for it with
+// hash_snapshot_wait() (or waitpid()). See hash.c for details.
+bool    hash_save(hash_p hash, const char* path);
+pid_t   hash_snapshot_async(hash_p hash, const char* path);
+bool    hash_snapshot_wait(pid_t pid);
+hash_p  hash_load(const char* path);
 
 #define hash_put(hash, key, type, value)  ( *((type*)hash_put_ptr(hash, key)) = (value) )
 #define hash_get(hash, key, type)         ( *((type*)hash_get_ptr(hash, key)) )
@@ -45,19 +63,44 @@ void*   hash_put_ptr(hash_p hash, hash_key_t key);
 void    hash_remove(hash_p hash, hash_key_t key);
 bool    hash_contains(hash_p hash, hash_key_t key);
 
+hash_elem_t hash_get_elem(hash_p hash, hash_key_t key);
+hash_elem_t hash_put_elem(hash_p hash, hash_key_t key);
+// Like hash_put_elem() but tells if a new key went into a slot marked as deleted
+hash_elem_t hash_put_elem_tracked(hash_p hash, hash_key_t key, bool* reused_deleted);
 hash_elem_t hash_start(hash_p hash);
 hash_elem_t hash_next(hash_p hash, hash_elem_t element);
 hash_key_t  hash_key(hash_elem_t element);
 #define     hash_value(element, type)     ( *((type*)hash_value_ptr(element)) )
 void*       hash_value_ptr(hash_elem_t element);
 void        hash_remove_elem(hash_p hash, hash_elem_t element);
+// Iterate over range `range` of `ranges` equally sized parts of the slots, e.g. one per
+// thread. 0 ranges are treated as 1. hash_parallel_for() does this with `threads`
+// threads. See hash.c for details.
+hash_elem_t hash_range_start(hash_p hash, size_t range, size_t ranges);
+hash_elem_t hash_range_next(hash_p hash, hash_elem_t element, size_t range, size_t ranges);
+void        hash_parallel_for(hash_p hash, hash_parallel_func_t func, void* context, size_t threads);
+// The hash functions used for keys, never return 0 or SIZE_MAX
+size_t      hash_key_hash(hash_key_t key);
 
 
 #define dict_of(type)              dict_new(5, sizeof(type))
 #define dict_with(capacity, type)  dict_new(capacity, sizeof(type))
 dict_p  dict_new(size_t capacity, size_t value_size);
 void    dict_destroy(dict_p dict);
+void    dict_clear(dict_p dict);
 void    dict_resize(dict_p dict, size_t capacity);
+dict_p  dict_copy(dict_p dict);
+
+void    dict_merge(dict_p dest, dict_p src, hash_combine_func_t combine);
+void    dict_intersect(dict_p dest, dict_p other, hash_combine_func_t combine);
+void    dict_difference(dict_p dest, dict_p other);
+
+// Loaded keys are stored in one block returned via `key_storage` (required), free it
+// after the dict
+bool    dict_save(dict_p dict, const char* path);
+pid_t   dict_snapshot_async(dict_p dict, const char* path);
+#define dict_snapshot_wait(pid)  hash_snapshot_wait(pid)
+dict_p  dict_load(const char* path, char** key_storage);
 
 #define dict_put(dict, key, type, value)  ( *((type*)dict_put_ptr(dict, key)) = (value) )
 #define dict_get(dict, key, type)         ( *((type*)dict_get_ptr(dict, key)) )
@@ -66,9 +109,72 @@ void*   dict_put_ptr(dict_p dict, const char* key);
 void    dict_remove(dict_p dict, const char* key);
 bool    dict_contains(dict_p dict, const char* key);
 
+dict_elem_t dict_get_elem(dict_p dict, const char* key);
+dict_elem_t dict_put_elem(dict_p dict, const char* key);
+dict_elem_t dict_put_elem_tracked(dict_p dict, const char* key, bool* reused_deleted);
 dict_elem_t dict_start(dict_p dict);
 dict_elem_t dict_next(dict_p dict, dict_elem_t element);
 const char* dict_key(dict_elem_t element);
 #define     dict_value(element, type)     ( *((type*)dict_value_ptr(element)) )
 void*       dict_value_ptr(dict_elem_t element);
-void        dict_remove_elem(dict_p dict, dict_elem_t element);
\ No newline at end of file
+void        dict_remove_elem(dict_p dict, dict_elem_t element);
+dict_elem_t dict_range_start(dict_p dict, size_t range, size_t ranges);
+dict_elem_t dict_range_next(dict_p dict, dict_elem_t element, size_t range, size_t ranges);
+void        dict_parallel_for(dict_p dict, hash_parallel_func_t func, void* context, size_t threads);
+size_t      dict_key_hash(const char* key);
+
+
+/**
+
+Multimaps map one key to many values. All values of a key are stored in one
+contiguous array so they can be iterated as a plain C array. The arrays grow by
+doubling, so there is one allocation per key and not per value.
+
+multi_hash_p m = hash_multi_of(int);
+hash_multi_put(m, 7, int, 1);
+hash_multi_put(m, 7, int, 2);
+
+size_t count = 0;
+int* values = hash_multi_get(m, 7, &count);  // -> [1, 2], count = 2
+hash_multi_count(m, 7);                      // -> 2
+hash_multi_remove_one(m, 7, 0);              // removes the 1, keeps the order of the others
+hash_multi_remove_all(m, 7);
+
+// Iterating over all keys, m->keys is a normal hash (or dict)
+for(hash_elem_t e = hash_start(m->keys); e != NULL; e = hash_next(m->keys, e)) {
+	int* values = hash_multi_values(e, &count);
+	…
+}
+
+*/
+
+typedef struct {
+	unified_hash_p keys;
+	size_t value_size, length;
+} unified_multi_hash_t, *multi_hash_p, *multi_dict_p;
+
+
+#define      hash_multi_of(type)                     hash_multi_new(5, sizeof(type))
+multi_hash_p hash_multi_new(size_t capacity, size_t value_size);
+void         hash_multi_destroy(multi_hash_p hash);
+
+#define      hash_multi_put(hash, key, type, value)  ( *((type*)hash_multi_put_ptr(hash, key)) = (value) )
+void*        hash_multi_put_ptr(multi_hash_p hash, hash_key_t key);
+void*        hash_multi_get(multi_hash_p hash, hash_key_t key, size_t* count);
+size_t       hash_multi_count(multi_hash_p hash, hash_key_t key);
+void         hash_multi_remove_one(multi_hash_p hash, hash_key_t key, size_t index);
+void         hash_multi_remove_all(multi_hash_p hash, hash_key_t key);
+void*        hash_multi_values(hash_elem_t element, size_t* count);
+
+
+#define      dict_multi_of(type)                     dict_multi_new(5, sizeof(type))
+multi_dict_p dict_multi_new(size_t capacity, size_t value_size);
+void         dict_multi_destroy(multi_dict_p dict);
+
+#define      dict_multi_put(dict, key, type, value)  ( *((type*)dict_multi_put_ptr(dict, key)) = (value) )
+void*        dict_multi_put_ptr(multi_dict_p dict, const char* key);
+void*        dict_multi_get(multi_dict_p dict, const char* key, size_t* count);
+size_t       dict_multi_count(multi_dict_p dict, const char* key);
+void         dict_multi_remove_one(multi_dict_p dict, const char* key, size_t index);
+void         dict_multi_remove_all(multi_dict_p dict, const char* key);
+void*        dict_multi_values(dict_elem_t element, size_t* count);
\ No newline at end of file
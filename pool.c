@@ -0,0 +1,332 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include "pool.h"
+
+// Failed rounds of steal attempts before an idle thread goes to sleep
+#define POOL_IDLE_ROUNDS  64
+#define POOL_SLEEP_NS     1000000
+
+#define POOL_DEQUE_MASK  (POOL_DEQUE_CAPACITY - 1)
+
+
+//
+// Chase-Lev deque, with the memory orders of "Correct and Efficient Work-Stealing for
+// Weak Memory Models" (Lê, Pop, Cohen, Zappa Nardelli, 2013). The capacity is fixed.
+//
+
+bool pool_deque_push(pool_deque_t* deque, pool_task_t* task){
+	int64_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED);
+	int64_t top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+	if (bottom - top >= POOL_DEQUE_CAPACITY)
+		return false;
+	
+	__atomic_store_n(&deque->tasks[bottom & POOL_DEQUE_MASK], task, __ATOMIC_RELAXED);
+	// The paper uses a release fence and a relaxed store, a release store is the same here
+	__atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+/**
+ * Reserves the bottom task by decrementing bottom first. Only when it's the last task
+ * a thief might want it as well, then top decides who gets it.
+ */
+pool_task_t* pool_deque_take(pool_deque_t* deque){
+	int64_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) - 1;
+	__atomic_store_n(&deque->bottom, bottom, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	int64_t top = __atomic_load_n(&deque->top, __ATOMIC_RELAXED);
+	
+	if (top > bottom) {
+		// Was empty
+		__atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+		return NULL;
+	}
+	
+	pool_task_t* task = __atomic_load_n(&deque->tasks[bottom & POOL_DEQUE_MASK], __ATOMIC_RELAXED);
+	if (top == bottom) {
+		if ( !__atomic_compare_exchange_n(&deque->top, &top, top + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED) )
+			task = NULL;
+		__atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+	}
+	
+	return task;
+}
+
+pool_task_t* pool_deque_steal(pool_deque_t* deque){
+	int64_t top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	int64_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_ACQUIRE);
+	if (top >= bottom)
+		return NULL;
+	
+	pool_task_t* task = __atomic_load_n(&deque->tasks[top & POOL_DEQUE_MASK], __ATOMIC_RELAXED);
+	if ( !__atomic_compare_exchange_n(&deque->top, &top, top + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED) )
+		return NULL;
+	return task;
+}
+
+
+//
+// Scheduling
+//
+
+/**
+ * The group is read before the task runs, the task struct might be gone as soon as the
+ * waiting thread sees its group finished.
+ */
+static void pool_execute(pool_p pool, pool_task_t* task){
+	pool_group_t* group = task->group;
+	task->func(pool, task->arg);
+	__atomic_sub_fetch(&group->pending, 1, __ATOMIC_RELEASE);
+}
+
+// Takes a task from the own deque or steals one, starting at a different victim each time
+static pool_task_t* pool_find_task(pool_p pool, pool_deque_t* own, size_t* victim){
+	pool_task_t* task = pool_deque_take(own);
+	for(size_t i = 0; task == NULL && i < pool->threads; i++) {
+		pool_deque_t* deque = &pool->deques[(*victim)++ % pool->threads];
+		if (deque != own)
+			task = pool_deque_steal(deque);
+	}
+	return task;
+}
+
+static void pool_sleep(pool_p pool){
+	struct timespec deadline;
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_nsec += POOL_SLEEP_NS;
+	if (deadline.tv_nsec >= 1000000000) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000;
+	}
+	
+	pthread_mutex_lock(&pool->sleep_lock);
+	if ( !pool->shutdown ) {
+		__atomic_add_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+		// A spawn between the last steal attempt and here isn't noticed until the timeout
+		pthread_cond_timedwait(&pool->wakeup, &pool->sleep_lock, &deadline);
+		__atomic_sub_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+	}
+	pthread_mutex_unlock(&pool->sleep_lock);
+}
+
+static void* pool_worker(void* arg){
+	pool_p pool = arg;
+	size_t index = __atomic_fetch_add(&pool->started_workers, 1, __ATOMIC_RELAXED);
+	pool_deque_t* own = &pool->deques[index];
+	pthread_setspecific(pool->deque_key, own);
+	
+	size_t victim = index + 1, idle_rounds = 0;
+	while ( !__atomic_load_n(&pool->shutdown, __ATOMIC_ACQUIRE) ) {
+		pool_task_t* task = pool_find_task(pool, own, &victim);
+		if (task != NULL) {
+			pool_execute(pool, task);
+			idle_rounds = 0;
+		} else if (++idle_rounds < POOL_IDLE_ROUNDS) {
+			sched_yield();
+		} else {
+			pool_sleep(pool);
+		}
+	}
+	
+	return NULL;
+}
+
+pool_p pool_new(size_t threads){
+	if (threads == 0) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = (cpus > 0) ? cpus : 1;
+	}
+	
+	pool_p pool = calloc(1, sizeof(pool_t));
+	if (pool == NULL)
+		return NULL;
+	pool->threads = threads;
+	
+	void* deques = NULL;
+	if ( posix_memalign(&deques, POOL_CACHE_LINE, threads * sizeof(pool_deque_t)) != 0 ) {
+		free(pool);
+		return NULL;
+	}
+	memset(deques, 0, threads * sizeof(pool_deque_t));
+	pool->deques = deques;
+	
+	pool->workers = (threads > 1) ? malloc((threads - 1) * sizeof(pthread_t)) : NULL;
+	if ((threads > 1 && pool->workers == NULL) || pthread_key_create(&pool->deque_key, NULL) != 0) {
+		free(pool->workers);
+		free(pool->deques);
+		free(pool);
+		return NULL;
+	}
+	pthread_mutex_init(&pool->caller_lock, NULL);
+	pthread_mutex_init(&pool->sleep_lock, NULL);
+	pthread_cond_init(&pool->wakeup, NULL);
+	
+	// If a thread can't be created the pool just has fewer workers, the caller's deque
+	// stays the last one
+	for(size_t i = 0; i < threads - 1; i++) {
+		if ( pthread_create(&pool->workers[pool->worker_count], NULL, pool_worker, pool) == 0 )
+			pool->worker_count++;
+	}
+	
+	return pool;
+}
+
+void pool_destroy(pool_p pool){
+	pthread_mutex_lock(&pool->sleep_lock);
+	__atomic_store_n(&pool->shutdown, true, __ATOMIC_RELEASE);
+	pthread_cond_broadcast(&pool->wakeup);
+	pthread_mutex_unlock(&pool->sleep_lock);
+	
+	for(size_t i = 0; i < pool->worker_count; i++)
+		pthread_join(pool->workers[i], NULL);
+	
+	pthread_cond_destroy(&pool->wakeup);
+	pthread_mutex_destroy(&pool->sleep_lock);
+	pthread_mutex_destroy(&pool->caller_lock);
+	pthread_key_delete(pool->deque_key);
+	free(pool->workers);
+	free(pool->deques);
+	free(pool);
+}
+
+void pool_run(pool_p pool, pool_task_func_t func, void* arg){
+	if ( pthread_getspecific(pool->deque_key) != NULL ) {
+		func(pool, arg);
+		return;
+	}
+	
+	pthread_mutex_lock(&pool->caller_lock);
+	pthread_setspecific(pool->deque_key, &pool->deques[pool->threads - 1]);
+	func(pool, arg);
+	pthread_setspecific(pool->deque_key, NULL);
+	pthread_mutex_unlock(&pool->caller_lock);
+}
+
+// Outside of tasks (or when the deque is full) the task is run right away
+void pool_spawn(pool_p pool, pool_group_t* group, pool_task_t* task){
+	task->group = group;
+	__atomic_add_fetch(&group->pending, 1, __ATOMIC_RELAXED);
+	
+	pool_deque_t* own = pthread_getspecific(pool->deque_key);
+	if ( own == NULL || !pool_deque_push(own, task) ) {
+		pool_execute(pool, task);
+		return;
+	}
+	
+	if ( __atomic_load_n(&pool->sleepers, __ATOMIC_SEQ_CST) > 0 ) {
+		pthread_mutex_lock(&pool->sleep_lock);
+		pthread_cond_signal(&pool->wakeup);
+		pthread_mutex_unlock(&pool->sleep_lock);
+	}
+}
+
+// Runs other tasks while waiting, usually the ones just spawned
+void pool_wait(pool_p pool, pool_group_t* group){
+	pool_deque_t* own = pthread_getspecific(pool->deque_key);
+	size_t victim = (own != NULL) ? (size_t)(own - pool->deques) + 1 : 0;
+	
+	while ( __atomic_load_n(&group->pending, __ATOMIC_ACQUIRE) > 0 ) {
+		pool_task_t* task = (own != NULL) ? pool_find_task(pool, own, &victim) : NULL;
+		if (task != NULL)
+			pool_execute(pool, task);
+		else
+			sched_yield();
+	}
+}
+
+
+//
+// Parallel loops
+//
+
+typedef struct {
+	size_t start, end, grain;
+	pool_for_func_t func;
+	void* context;
+} pool_for_part_t;
+
+// Splits off the upper half as a task and continues with the lower half
+static void pool_for_task(pool_p pool, void* arg){
+	pool_for_part_t* part = arg;
+	if (part->end - part->start <= part->grain) {
+		part->func(part->context, part->start, part->end);
+		return;
+	}
+	
+	size_t middle = part->start + (part->end - part->start) / 2;
+	pool_for_part_t lower = *part, upper = *part;
+	lower.end = middle;
+	upper.start = middle;
+	
+	pool_group_t group = { 0 };
+	pool_task_t task = { pool_for_task, &upper, NULL };
+	pool_spawn(pool, &group, &task);
+	pool_for_task(pool, &lower);
+	pool_wait(pool, &group);
+}
+
+void pool_parallel_for(pool_p pool, size_t start, size_t end, size_t grain, pool_for_func_t func, void* context){
+	if (start >= end)
+		return;
+	
+	pool_for_part_t part = { start, end, (grain > 0) ? grain : 1, func, context };
+	pool_run(pool, pool_for_task, &part);
+}
+
+typedef struct {
+	size_t start, end, grain;
+	size_t result_size;
+	const void* identity;
+	pool_reduce_func_t reduce;
+	pool_combine_func_t combine;
+	void* context;
+	void* result;
+} pool_reduce_part_t;
+
+// Storage for the result of the upper half, aligned for any result type
+typedef union {
+	long double ld;
+	uint64_t u64;
+	void* ptr;
+} pool_align_t;
+
+static void pool_reduce_task(pool_p pool, void* arg){
+	pool_reduce_part_t* part = arg;
+	if (part->end - part->start <= part->grain) {
+		memcpy(part->result, part->identity, part->result_size);
+		part->reduce(part->context, part->start, part->end, part->result);
+		return;
+	}
+	
+	pool_align_t upper_result[part->result_size / sizeof(pool_align_t) + 1];
+	size_t middle = part->start + (part->end - part->start) / 2;
+	pool_reduce_part_t lower = *part, upper = *part;
+	lower.end = middle;
+	upper.start = middle;
+	upper.result = upper_result;
+	
+	pool_group_t group = { 0 };
+	pool_task_t task = { pool_reduce_task, &upper, NULL };
+	pool_spawn(pool, &group, &task);
+	pool_reduce_task(pool, &lower);
+	pool_wait(pool, &group);
+	
+	part->combine(part->context, part->result, upper_result);
+}
+
+void pool_parallel_reduce(pool_p pool, size_t start, size_t end, size_t grain, size_t result_size, const void* identity,
+	pool_reduce_func_t reduce, pool_combine_func_t combine, void* context, void* result){
+	if (start >= end) {
+		memcpy(result, identity, result_size);
+		return;
+	}
+	
+	pool_reduce_part_t part = { start, end, (grain > 0) ? grain : 1, result_size, identity, reduce, combine, context, result };
+	pool_run(pool, pool_reduce_task, &part);
+}
\ No newline at end of file
@@ -0,0 +1,141 @@
+#pragma once
+
+/**
+
+# A work-stealing thread pool
+
+A pool runs tasks on a fixed number of threads. Each thread has its own Chase-Lev
+deque: It pushes and takes its tasks at the bottom (LIFO, good for the cache) while
+idle threads steal from the top of other deques (FIFO, usually the larger chunks of
+work). Tasks can spawn further tasks and wait for them, so work can be split
+recursively (fork-join). pool_parallel_for() and pool_parallel_reduce() are built on
+that.
+
+`threads` includes the calling thread (like hash_parallel_for()), a pool with 1 thread
+just runs everything in the caller. 0 uses one thread per online CPU.
+
+
+// Loops over a range, split in parts of at least `grain` indices
+
+static void square(void* context, size_t start, size_t end){
+	double* values = context;
+	for(size_t i = start; i < end; i++)
+		values[i] *= values[i];
+}
+
+pool_p pool = pool_new(0);
+pool_parallel_for(pool, 0, length, 4096, square, values);
+
+
+// Reduce: Each part is accumulated into its own result (initialized with `identity`),
+// the results of parts are then combined.
+
+static void sum_range(void* context, size_t start, size_t end, void* result){
+	for(size_t i = start; i < end; i++)
+		*(double*)result += ((double*)context)[i];
+}
+static void add(void* context, void* result, const void* other){
+	*(double*)result += *(const double*)other;
+}
+
+double identity = 0, sum;
+pool_parallel_reduce(pool, 0, length, 4096, sizeof(double), &identity, sum_range, add, values, &sum);
+
+
+// Spawning tasks. The task structs are owned by the caller and have to stay valid until
+// pool_wait() for their group returns, so they can usually live on the stack. Spawn and
+// wait only work inside of tasks, pool_run() runs the first one on the calling thread.
+
+static void sort_part(pool_p pool, void* arg){
+	part_t* part = arg;
+	…
+	pool_group_t group = { 0 };
+	pool_task_t left = { sort_part, &left_part }, right = { sort_part, &right_part };
+	pool_spawn(pool, &group, &left);
+	pool_spawn(pool, &group, &right);
+	pool_wait(pool, &group);
+	…
+}
+
+pool_run(pool, sort_part, &whole_array);
+pool_destroy(pool);
+
+
+# Implementation notes
+
+The deques have a fixed capacity. When a deque is full pool_spawn() runs the task
+right away, for recursive splitting that only happens at an absurd depth. Idle threads
+yield the CPU between steal attempts and sleep after a while. A spawn wakes one
+sleeping thread.
+
+Only one thread outside of the pool can use it at a time, pool_run() (and the parallel
+functions) serialize callers that aren't pool threads.
+
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+
+#define POOL_DEQUE_CAPACITY  1024
+#define POOL_CACHE_LINE      64
+
+typedef struct pool_s pool_t, *pool_p;
+
+typedef void (*pool_task_func_t)(pool_p pool, void* arg);
+typedef void (*pool_for_func_t)(void* context, size_t start, size_t end);
+typedef void (*pool_reduce_func_t)(void* context, size_t start, size_t end, void* result);
+typedef void (*pool_combine_func_t)(void* context, void* result, const void* other);
+
+// Counts the spawned but not yet finished tasks of a group
+typedef struct {
+	size_t pending;
+} pool_group_t;
+
+typedef struct {
+	pool_task_func_t func;
+	void* arg;
+	pool_group_t* group;  // Set by pool_spawn()
+} pool_task_t;
+
+typedef struct {
+	int64_t top;
+	char top_padding[POOL_CACHE_LINE - sizeof(int64_t)];
+	int64_t bottom;
+	char bottom_padding[POOL_CACHE_LINE - sizeof(int64_t)];
+	pool_task_t* tasks[POOL_DEQUE_CAPACITY];
+} pool_deque_t;
+
+struct pool_s {
+	size_t threads;
+	pthread_t* workers;        // Up to threads - 1 worker threads
+	size_t worker_count, started_workers;
+	pool_deque_t* deques;      // One per worker, the last one for the outside caller
+	pthread_key_t deque_key;   // The deque of the current thread
+	pthread_mutex_t caller_lock;
+	
+	pthread_mutex_t sleep_lock;
+	pthread_cond_t wakeup;
+	size_t sleepers;
+	bool shutdown;
+};
+
+pool_p pool_new(size_t threads);
+void   pool_destroy(pool_p pool);
+
+void   pool_run(pool_p pool, pool_task_func_t func, void* arg);
+void   pool_spawn(pool_p pool, pool_group_t* group, pool_task_t* task);
+void   pool_wait(pool_p pool, pool_group_t* group);
+
+void   pool_parallel_for(pool_p pool, size_t start, size_t end, size_t grain, pool_for_func_t func, void* context);
+void   pool_parallel_reduce(pool_p pool, size_t start, size_t end, size_t grain, size_t result_size, const void* identity,
+	pool_reduce_func_t reduce, pool_combine_func_t combine, void* context, void* result);
+
+// The deque functions used by the pool. Push and take only by the owning thread, steal
+// by any thread. Push returns false if the deque is full, take and steal return NULL if
+// there was nothing to get (steal also if it lost a race for the last task).
+bool         pool_deque_push(pool_deque_t* deque, pool_task_t* task);
+pool_task_t* pool_deque_take(pool_deque_t* deque);
+pool_task_t* pool_deque_steal(pool_deque_t* deque);
\ No newline at end of file
@@ -0,0 +1,222 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "queue.h"
+
+static size_t queue_round_capacity(size_t capacity){
+	size_t rounded = 1;
+	while (rounded < capacity)
+		rounded *= 2;
+	return rounded;
+}
+
+/**
+ * Queues are allocated at a cache line boundary, otherwise the padding wouldn't keep
+ * the producer and consumer fields on separate lines.
+ */
+static void* queue_alloc(size_t size){
+	void* memory = NULL;
+	if ( posix_memalign(&memory, QUEUE_CACHE_LINE, size) != 0 )
+		return NULL;
+	memset(memory, 0, size);
+	return memory;
+}
+
+
+//
+// Single producer, single consumer
+//
+
+spsc_queue_p spsc_queue_new(size_t capacity, size_t element_size){
+	spsc_queue_p queue = queue_alloc(sizeof(spsc_queue_t));
+	if (queue == NULL)
+		return NULL;
+	
+	queue->capacity = queue_round_capacity(capacity);
+	queue->element_size = element_size;
+	queue->data = malloc(queue->capacity * element_size);
+	if (queue->data == NULL) {
+		free(queue);
+		return NULL;
+	}
+	
+	return queue;
+}
+
+void spsc_queue_destroy(spsc_queue_p queue){
+	free(queue->data);
+	free(queue);
+}
+
+/**
+ * Returns how many records can be pushed, at most `wanted`. The head of the consumer
+ * is only loaded when the cached one doesn't leave enough space.
+ */
+static size_t spsc_queue_free(spsc_queue_p queue, size_t tail, size_t wanted){
+	size_t free_space = queue->capacity - (tail - queue->cached_head);
+	if (free_space < wanted) {
+		queue->cached_head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+		free_space = queue->capacity - (tail - queue->cached_head);
+	}
+	return (free_space < wanted) ? free_space : wanted;
+}
+
+static size_t spsc_queue_available(spsc_queue_p queue, size_t head, size_t wanted){
+	size_t available = queue->cached_tail - head;
+	if (available < wanted) {
+		queue->cached_tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+		available = queue->cached_tail - head;
+	}
+	return (available < wanted) ? available : wanted;
+}
+
+bool spsc_queue_push(spsc_queue_p queue, const void* elem){
+	return spsc_queue_push_n(queue, elem, 1) == 1;
+}
+
+size_t spsc_queue_push_n(spsc_queue_p queue, const void* elems, size_t n){
+	size_t tail = queue->tail;
+	n = spsc_queue_free(queue, tail, n);
+	if (n == 0)
+		return 0;
+	
+	// Copy up to the end of the ring and the rest to its start
+	size_t index = tail & (queue->capacity - 1);
+	size_t first_part = (queue->capacity - index < n) ? queue->capacity - index : n;
+	memcpy(queue->data + index * queue->element_size, elems, first_part * queue->element_size);
+	memcpy(queue->data, (const char*)elems + first_part * queue->element_size, (n - first_part) * queue->element_size);
+	
+	__atomic_store_n(&queue->tail, tail + n, __ATOMIC_RELEASE);
+	return n;
+}
+
+void* spsc_queue_reserve(spsc_queue_p queue, size_t* n){
+	size_t index = queue->tail & (queue->capacity - 1);
+	size_t contiguous = queue->capacity - index;
+	*n = spsc_queue_free(queue, queue->tail, (*n < contiguous) ? *n : contiguous);
+	return queue->data + index * queue->element_size;
+}
+
+void spsc_queue_publish(spsc_queue_p queue, size_t n){
+	__atomic_store_n(&queue->tail, queue->tail + n, __ATOMIC_RELEASE);
+}
+
+bool spsc_queue_pop(spsc_queue_p queue, void* elem){
+	return spsc_queue_pop_n(queue, elem, 1) == 1;
+}
+
+size_t spsc_queue_pop_n(spsc_queue_p queue, void* elems, size_t n){
+	size_t head = queue->head;
+	n = spsc_queue_available(queue, head, n);
+	if (n == 0)
+		return 0;
+	
+	size_t index = head & (queue->capacity - 1);
+	size_t first_part = (queue->capacity - index < n) ? queue->capacity - index : n;
+	memcpy(elems, queue->data + index * queue->element_size, first_part * queue->element_size);
+	memcpy((char*)elems + first_part * queue->element_size, queue->data, (n - first_part) * queue->element_size);
+	
+	__atomic_store_n(&queue->head, head + n, __ATOMIC_RELEASE);
+	return n;
+}
+
+void* spsc_queue_peek(spsc_queue_p queue, size_t* n){
+	size_t index = queue->head & (queue->capacity - 1);
+	size_t contiguous = queue->capacity - index;
+	*n = spsc_queue_available(queue, queue->head, (*n < contiguous) ? *n : contiguous);
+	return queue->data + index * queue->element_size;
+}
+
+void spsc_queue_consume(spsc_queue_p queue, size_t n){
+	__atomic_store_n(&queue->head, queue->head + n, __ATOMIC_RELEASE);
+}
+
+
+//
+// Multiple producers and consumers
+//
+
+mpmc_queue_p mpmc_queue_new(size_t capacity, size_t element_size){
+	mpmc_queue_p queue = queue_alloc(sizeof(mpmc_queue_t));
+	if (queue == NULL)
+		return NULL;
+	
+	// With 1 slot the sequence number after a push (pos + 1) would already mark it free
+	// for the next producer, so at least 2 slots are needed
+	queue->capacity = queue_round_capacity((capacity < 2) ? 2 : capacity);
+	queue->element_size = element_size;
+	queue->slot_size = (1 + (element_size + sizeof(size_t) - 1) / sizeof(size_t)) * sizeof(size_t);
+	queue->slots = malloc(queue->capacity * queue->slot_size);
+	if (queue->slots == NULL) {
+		free(queue);
+		return NULL;
+	}
+	
+	// Slot i is ready to be written when enqueue_pos reaches i
+	for(size_t i = 0; i < queue->capacity; i++)
+		*(size_t*)(queue->slots + i * queue->slot_size) = i;
+	
+	return queue;
+}
+
+void mpmc_queue_destroy(mpmc_queue_p queue){
+	free(queue->slots);
+	free(queue);
+}
+
+/**
+ * A slot with sequence number == pos is free for the producer at pos. After writing the
+ * producer sets it to pos + 1, which marks it as ready for the consumer at pos. The
+ * consumer sets it to pos + capacity, ready for the producer of the next round.
+ */
+bool mpmc_queue_push(mpmc_queue_p queue, const void* elem){
+	size_t pos = __atomic_load_n(&queue->enqueue_pos, __ATOMIC_RELAXED);
+	char* slot;
+	
+	while (true) {
+		slot = queue->slots + (pos & (queue->capacity - 1)) * queue->slot_size;
+		size_t sequence = __atomic_load_n((size_t*)slot, __ATOMIC_ACQUIRE);
+		intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+		
+		if (diff == 0) {
+			if ( __atomic_compare_exchange_n(&queue->enqueue_pos, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED) )
+				break;
+		} else if (diff < 0) {
+			// The consumer of the previous round hasn't freed the slot yet
+			return false;
+		} else {
+			pos = __atomic_load_n(&queue->enqueue_pos, __ATOMIC_RELAXED);
+		}
+	}
+	
+	memcpy(slot + sizeof(size_t), elem, queue->element_size);
+	__atomic_store_n((size_t*)slot, pos + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+bool mpmc_queue_pop(mpmc_queue_p queue, void* elem){
+	size_t pos = __atomic_load_n(&queue->dequeue_pos, __ATOMIC_RELAXED);
+	char* slot;
+	
+	while (true) {
+		slot = queue->slots + (pos & (queue->capacity - 1)) * queue->slot_size;
+		size_t sequence = __atomic_load_n((size_t*)slot, __ATOMIC_ACQUIRE);
+		intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+		
+		if (diff == 0) {
+			if ( __atomic_compare_exchange_n(&queue->dequeue_pos, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED) )
+				break;
+		} else if (diff < 0) {
+			// Nothing was pushed at this position yet
+			return false;
+		} else {
+			pos = __atomic_load_n(&queue->dequeue_pos, __ATOMIC_RELAXED);
+		}
+	}
+	
+	memcpy(elem, slot + sizeof(size_t), queue->element_size);
+	__atomic_store_n((size_t*)slot, pos + queue->capacity, __ATOMIC_RELEASE);
+	return true;
+}
\ No newline at end of file
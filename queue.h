@@ -0,0 +1,113 @@
+#pragma once
+
+/**
+
+# Lock-free queues for fixed size records
+
+Bounded queues to pass records of `element_size` bytes between threads without
+locks. The capacity is rounded up to a power of two (at least 2 for mpmc_queue_t).
+Records are copied in and out.
+
+- spsc_queue_t: One producer and one consumer thread. The producer and consumer
+  counters are on separate cache lines and each side caches the counter of the other
+  side, so it only touches the other cache line when the queue looks full (or empty).
+  Batches are published and consumed with one atomic store.
+- mpmc_queue_t: Any number of producers and consumers. Each slot has a sequence
+  number that tells whether it's ready to be written or read in the current round
+  (Dmitry Vyukov's bounded MPMC queue). A push or pop is one CAS on the shared
+  position when uncontended.
+
+All functions return immediately. When the queue is full (or empty) they return false
+(or 0) and it's up to the caller to retry, yield or sleep.
+
+
+// Single producer, single consumer
+
+spsc_queue_p q = spsc_queue_of(1024, record_t);
+spsc_queue_push(q, &record);           // producer, false if full
+spsc_queue_pop(q, &record);            // consumer, false if empty
+
+// Batches, return the number of records actually copied
+size_t pushed = spsc_queue_push_n(q, records, 64);
+size_t popped = spsc_queue_pop_n(q, records, 64);
+
+// Batches without copying: get contiguous space (or records), then publish
+// (or consume) them all at once. `n` is the most that's wanted and set to the
+// available number, which may be less because of the end of the ring.
+size_t n = 64;
+record_t* space = spsc_queue_reserve(q, &n);
+… write up to n records …
+spsc_queue_publish(q, n);
+
+n = 64;
+record_t* records = spsc_queue_peek(q, &n);
+… read n records …
+spsc_queue_consume(q, n);
+
+spsc_queue_destroy(q);
+
+
+// Multiple producers and consumers
+
+mpmc_queue_p q = mpmc_queue_of(1024, record_t);
+mpmc_queue_push(q, &record);           // false if full
+mpmc_queue_pop(q, &record);            // false if empty
+mpmc_queue_destroy(q);
+
+*/
+
+#include <stddef.h>
+#include <stdbool.h>
+
+
+#define QUEUE_CACHE_LINE  64
+
+typedef struct {
+	// Written by the producer
+	size_t tail;
+	size_t cached_head;
+	char producer_padding[QUEUE_CACHE_LINE - 2 * sizeof(size_t)];
+	
+	// Written by the consumer
+	size_t head;
+	size_t cached_tail;
+	char consumer_padding[QUEUE_CACHE_LINE - 2 * sizeof(size_t)];
+	
+	size_t capacity, element_size;
+	char* data;
+} spsc_queue_t, *spsc_queue_p;
+
+typedef struct {
+	size_t capacity, element_size;
+	size_t slot_size;  // Sequence number + element, rounded up to whole size_t
+	char* slots;
+	char padding[QUEUE_CACHE_LINE - 4 * sizeof(size_t)];
+	
+	size_t enqueue_pos;
+	char enqueue_padding[QUEUE_CACHE_LINE - sizeof(size_t)];
+	size_t dequeue_pos;
+	char dequeue_padding[QUEUE_CACHE_LINE - sizeof(size_t)];
+} mpmc_queue_t, *mpmc_queue_p;
+
+#define spsc_queue_of(capacity, type)  spsc_queue_new(capacity, sizeof(type))
+#define mpmc_queue_of(capacity, type)  mpmc_queue_new(capacity, sizeof(type))
+
+spsc_queue_p spsc_queue_new(size_t capacity, size_t element_size);
+void         spsc_queue_destroy(spsc_queue_p queue);
+
+// Producer side
+bool         spsc_queue_push(spsc_queue_p queue, const void* elem);
+size_t       spsc_queue_push_n(spsc_queue_p queue, const void* elems, size_t n);
+void*        spsc_queue_reserve(spsc_queue_p queue, size_t* n);
+void         spsc_queue_publish(spsc_queue_p queue, size_t n);
+
+// Consumer side
+bool         spsc_queue_pop(spsc_queue_p queue, void* elem);
+size_t       spsc_queue_pop_n(spsc_queue_p queue, void* elems, size_t n);
+void*        spsc_queue_peek(spsc_queue_p queue, size_t* n);
+void         spsc_queue_consume(spsc_queue_p queue, size_t n);
+
+mpmc_queue_p mpmc_queue_new(size_t capacity, size_t element_size);
+void         mpmc_queue_destroy(mpmc_queue_p queue);
+bool         mpmc_queue_push(mpmc_queue_p queue, const void* elem);
+bool         mpmc_queue_pop(mpmc_queue_p queue, void* elem);
\ No newline at end of file
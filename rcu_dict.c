@@ -0,0 +1,181 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include "rcu_dict.h"
+
+/**
+ * The dict and the reader records are allocated at a cache line boundary, otherwise the
+ * padding wouldn't keep their hot fields on separate lines.
+ */
+static void* rcu_dict_alloc(size_t size){
+	void* memory = NULL;
+	if ( posix_memalign(&memory, RCU_DICT_CACHE_LINE, size) != 0 )
+		return NULL;
+	return memory;
+}
+
+
+//
+// Creation and destruction functions
+//
+
+rcu_dict_p rcu_dict_new(size_t capacity, size_t value_size){
+	rcu_dict_p dict = rcu_dict_alloc(sizeof(rcu_dict_t));
+	if (dict == NULL)
+		return NULL;
+	
+	dict->current = dict_new(capacity, value_size);
+	if (dict->current == NULL){
+		free(dict);
+		return NULL;
+	}
+	
+	dict->epoch = 1;
+	dict->readers = NULL;
+	pthread_mutex_init(&dict->write_lock, NULL);
+	
+	return dict;
+}
+
+/**
+ * Destroys the dict and all reader records that are still registered. No thread must
+ * use the dict or one of its readers any more.
+ */
+void rcu_dict_destroy(rcu_dict_p dict){
+	for(rcu_dict_reader_p reader = dict->readers, next = NULL; reader != NULL; reader = next){
+		next = reader->next;
+		free(reader);
+	}
+	
+	pthread_mutex_destroy(&dict->write_lock);
+	dict_destroy(dict->current);
+	free(dict);
+}
+
+
+//
+// Reader registration
+//
+
+rcu_dict_reader_p rcu_dict_register(rcu_dict_p dict){
+	rcu_dict_reader_p reader = rcu_dict_alloc(sizeof(rcu_dict_reader_t));
+	if (reader == NULL)
+		return NULL;
+	
+	reader->epoch = 0;
+	
+	pthread_mutex_lock(&dict->write_lock);
+	reader->next = dict->readers;
+	dict->readers = reader;
+	pthread_mutex_unlock(&dict->write_lock);
+	
+	return reader;
+}
+
+void rcu_dict_unregister(rcu_dict_p dict, rcu_dict_reader_p reader){
+	pthread_mutex_lock(&dict->write_lock);
+	for(rcu_dict_reader_p* link = &dict->readers; *link != NULL; link = &(*link)->next){
+		if (*link == reader) {
+			*link = reader->next;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&dict->write_lock);
+	
+	free(reader);
+}
+
+
+//
+// Read side. Both functions are wait-free: a few atomic loads and stores.
+//
+
+/**
+ * Announces the current epoch and then loads the published dict. Both operations
+ * are sequentially consistent. A writer that published a new dict after we loaded
+ * the old one therefore sees our epoch when it scans the readers.
+ */
+dict_p rcu_dict_read_lock(rcu_dict_p dict, rcu_dict_reader_p reader){
+	uint64_t epoch = __atomic_load_n(&dict->epoch, __ATOMIC_SEQ_CST);
+	__atomic_store_n(&reader->epoch, epoch, __ATOMIC_SEQ_CST);
+	return __atomic_load_n(&dict->current, __ATOMIC_SEQ_CST);
+}
+
+void rcu_dict_read_unlock(rcu_dict_reader_p reader){
+	__atomic_store_n(&reader->epoch, 0, __ATOMIC_RELEASE);
+}
+
+
+//
+// Write side
+//
+
+/**
+ * Locks the dict for writing and returns a private copy of the current dict. Modify
+ * the copy with the normal dict functions and publish it with rcu_dict_write_commit().
+ * 
+ * Returns NULL (and leaves the dict unlocked) if the copy could not be allocated.
+ */
+dict_p rcu_dict_write_begin(rcu_dict_p dict){
+	pthread_mutex_lock(&dict->write_lock);
+	
+	dict_p copy = dict_copy(dict->current);
+	if (copy == NULL)
+		pthread_mutex_unlock(&dict->write_lock);
+	
+	return copy;
+}
+
+/**
+ * Publishes `copy` as the new current dict, waits until no reader can use the old
+ * dict any more, frees it and unlocks the dict for other writers.
+ */
+void rcu_dict_write_commit(rcu_dict_p dict, dict_p copy){
+	dict_p old = __atomic_exchange_n(&dict->current, copy, __ATOMIC_SEQ_CST);
+	uint64_t new_epoch = __atomic_add_fetch(&dict->epoch, 1, __ATOMIC_SEQ_CST);
+	
+	// Wait for the grace period: every reader has to be outside of a read section or
+	// has to have entered it in the new epoch (and thus seen the new dict).
+	for(rcu_dict_reader_p reader = dict->readers; reader != NULL; reader = reader->next){
+		while(true) {
+			uint64_t reader_epoch = __atomic_load_n(&reader->epoch, __ATOMIC_SEQ_CST);
+			if (reader_epoch == 0 || reader_epoch >= new_epoch)
+				break;
+			sched_yield();
+		}
+	}
+	
+	dict_destroy(old);
+	pthread_mutex_unlock(&dict->write_lock);
+}
+
+void rcu_dict_write_abort(rcu_dict_p dict, dict_p copy){
+	dict_destroy(copy);
+	pthread_mutex_unlock(&dict->write_lock);
+}
+
+/**
+ * Convenience functions that modify a single element. Both return false if the copy
+ * of the current dict could not be allocated.
+ */
+bool rcu_dict_put(rcu_dict_p dict, const char* key, const void* value){
+	dict_p copy = rcu_dict_write_begin(dict);
+	if (copy == NULL)
+		return false;
+	
+	memcpy(dict_put_ptr(copy, key), value, copy->value_size);
+	rcu_dict_write_commit(dict, copy);
+	return true;
+}
+
+bool rcu_dict_remove(rcu_dict_p dict, const char* key){
+	dict_p copy = rcu_dict_write_begin(dict);
+	if (copy == NULL)
+		return false;
+	
+	dict_remove(copy, key);
+	rcu_dict_write_commit(dict, copy);
+	return true;
+}
\ No newline at end of file
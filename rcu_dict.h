@@ -0,0 +1,112 @@
+#pragma once
+
+/**
+
+# A read-mostly dict for concurrent readers
+
+An RCU dict wraps a normal dict. Readers never take a lock and never wait. They
+enter a read section, get the currently published dict and use the normal dict
+read functions (dict_get_ptr(), dict_contains(), dict_start(), …) on it.
+
+Writers are serialized by a mutex. Each write works on a private copy of the
+current dict (created with dict_copy()) and publishes it atomically when done.
+The old dict is freed as soon as no reader that might still use it is inside a
+read section anymore (epoch based reclamation). This makes writes expensive
+(O(capacity) per write) so only use it for dicts that are read a lot more often
+than they are written.
+
+
+// Creating and destroying
+
+rcu_dict_p dict = rcu_dict_of(int);
+rcu_dict_destroy(dict);
+
+
+// Each reading thread registers itself once
+
+rcu_dict_reader_p reader = rcu_dict_register(dict);
+…
+rcu_dict_unregister(dict, reader);
+
+
+// Reading. The returned dict is valid until rcu_dict_read_unlock(). Don't modify it!
+
+dict_p snapshot = rcu_dict_read_lock(dict, reader);
+int* value = dict_get_ptr(snapshot, "foo");
+…
+rcu_dict_read_unlock(reader);
+
+
+// Writing single values (value points to dict->value_size bytes)
+
+int x = 7;
+rcu_dict_put(dict, "foo", &x);
+rcu_dict_remove(dict, "foo");
+
+
+// Writing many values at once. Blocks other writers until commit or abort.
+
+dict_p copy = rcu_dict_write_begin(dict);
+dict_put(copy, "foo", int, 1);
+dict_put(copy, "bar", int, 2);
+rcu_dict_write_commit(dict, copy);  // or rcu_dict_write_abort(dict, copy)
+
+
+# Implementation notes
+
+The dict has a global epoch counter that starts at 1. When a reader enters a read
+section it stores the current global epoch in its own record, when it leaves it
+stores 0 there. A writer publishes the new dict, increments the global epoch and
+then waits until every reader is either outside of a read section or in a read
+section of the new epoch. Only readers of older epochs can have seen the old dict.
+
+Keys are not copied, just like with a normal dict. They have to stay valid as long
+as they are in any published or not yet reclaimed dict.
+
+*/
+
+#include <stdint.h>
+#include <pthread.h>
+#include "hash.h"
+
+
+#define RCU_DICT_CACHE_LINE  64
+
+// Each reader record fills a whole cache line. Otherwise readers would write their
+// epochs into the same line and slow each other down.
+typedef struct rcu_dict_reader_s rcu_dict_reader_t, *rcu_dict_reader_p;
+struct rcu_dict_reader_s {
+	uint64_t epoch;
+	rcu_dict_reader_p next;
+	char padding[RCU_DICT_CACHE_LINE - sizeof(uint64_t) - sizeof(rcu_dict_reader_p)];
+};
+
+typedef struct {
+	// Loaded by every read_lock(), only written by a commit
+	dict_p current;
+	uint64_t epoch;
+	char padding[RCU_DICT_CACHE_LINE - sizeof(dict_p) - sizeof(uint64_t)];
+	
+	// Only used by writers and while (un)registering readers
+	rcu_dict_reader_p readers;
+	pthread_mutex_t write_lock;
+} rcu_dict_t, *rcu_dict_p;
+
+
+#define rcu_dict_of(type)              rcu_dict_new(5, sizeof(type))
+#define rcu_dict_with(capacity, type)  rcu_dict_new(capacity, sizeof(type))
+rcu_dict_p        rcu_dict_new(size_t capacity, size_t value_size);
+void              rcu_dict_destroy(rcu_dict_p dict);
+
+rcu_dict_reader_p rcu_dict_register(rcu_dict_p dict);
+void              rcu_dict_unregister(rcu_dict_p dict, rcu_dict_reader_p reader);
+
+dict_p            rcu_dict_read_lock(rcu_dict_p dict, rcu_dict_reader_p reader);
+void              rcu_dict_read_unlock(rcu_dict_reader_p reader);
+
+dict_p            rcu_dict_write_begin(rcu_dict_p dict);
+void              rcu_dict_write_commit(rcu_dict_p dict, dict_p copy);
+void              rcu_dict_write_abort(rcu_dict_p dict, dict_p copy);
+
+bool              rcu_dict_put(rcu_dict_p dict, const char* key, const void* value);
+bool              rcu_dict_remove(rcu_dict_p dict, const char* key);
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include <stdlib.h>
+#include "seg_array.h"
+
+/**
+ * Chunk k has space for 2^(first_chunk_bits + k) elements. Adding the first chunk
+ * capacity to an index makes the position of its highest set bit the chunk number
+ * (plus first_chunk_bits) and the remaining bits the offset within the chunk.
+ */
+static size_t seg_array_chunk_of(seg_array_p array, size_t index, size_t* offset){
+	size_t shifted = index + ((size_t)1 << array->first_chunk_bits);
+	size_t high_bit = 63 - __builtin_clzll(shifted);
+	*offset = shifted - ((size_t)1 << high_bit);
+	return high_bit - array->first_chunk_bits;
+}
+
+static size_t seg_array_chunk_capacity(seg_array_p array, size_t chunk){
+	return (size_t)1 << (array->first_chunk_bits + chunk);
+}
+
+seg_array_p seg_array_new(size_t first_chunk_capacity, size_t element_size){
+	seg_array_p array = malloc(sizeof(seg_array_t));
+	if (array == NULL)
+		return NULL;
+	
+	if (first_chunk_capacity == 0)
+		first_chunk_capacity = SEG_ARRAY_DEFAULT_FIRST_CHUNK_CAPACITY;
+	
+	array->length = 0;
+	array->capacity = 0;
+	array->element_size = element_size;
+	array->first_chunk_bits = 0;
+	while (((size_t)1 << array->first_chunk_bits) < first_chunk_capacity)
+		array->first_chunk_bits++;
+	array->chunk_count = 0;
+	
+	return array;
+}
+
+void seg_array_destroy(seg_array_p array){
+	for(size_t i = 0; i < array->chunk_count; i++)
+		free(array->chunks[i]);
+	free(array);
+}
+
+void* seg_array_elem_ptr(seg_array_p array, size_t index){
+	size_t offset;
+	size_t chunk = seg_array_chunk_of(array, index, &offset);
+	return (char*)array->chunks[chunk] + offset * array->element_size;
+}
+
+bool seg_array_reserve(seg_array_p array, size_t capacity){
+	while (array->capacity < capacity) {
+		size_t chunk_capacity = seg_array_chunk_capacity(array, array->chunk_count);
+		void* chunk = malloc(chunk_capacity * array->element_size);
+		if (chunk == NULL)
+			return false;
+		
+		array->chunks[array->chunk_count++] = chunk;
+		array->capacity += chunk_capacity;
+	}
+	
+	return true;
+}
+
+bool seg_array_resize(seg_array_p array, size_t new_length){
+	if ( !seg_array_reserve(array, new_length) )
+		return false;
+	
+	array->length = new_length;
+	return true;
+}
+
+void* seg_array_append_ptr(seg_array_p array){
+	if ( !seg_array_resize(array, array->length + 1) )
+		return NULL;
+	return seg_array_elem_ptr(array, array->length - 1);
+}
+
+void seg_array_shrink_to_fit(seg_array_p array){
+	size_t used_chunks = 0;
+	if (array->length > 0) {
+		size_t offset;
+		used_chunks = seg_array_chunk_of(array, array->length - 1, &offset) + 1;
+	}
+	
+	while (array->chunk_count > used_chunks) {
+		array->chunk_count--;
+		free(array->chunks[array->chunk_count]);
+		array->capacity -= seg_array_chunk_capacity(array, array->chunk_count);
+	}
+}
+
+void* seg_array_chunk(seg_array_p array, size_t chunk, size_t* length){
+	// All chunks before this one are full
+	size_t chunk_start = ((size_t)1 << (array->first_chunk_bits + chunk)) - ((size_t)1 << array->first_chunk_bits);
+	size_t chunk_capacity = seg_array_chunk_capacity(array, chunk);
+	
+	if (chunk >= array->chunk_count || chunk_start >= array->length)
+		*length = 0;
+	else
+		*length = (array->length - chunk_start < chunk_capacity) ? array->length - chunk_start : chunk_capacity;
+	
+	return (chunk < array->chunk_count) ? array->chunks[chunk] : NULL;
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+
+/**
+
+# Segmented arrays
+
+Like an array but the elements are stored in chunks that are never moved. The first
+chunk has space for `first_chunk_capacity` elements (rounded up to a power of two), each
+following chunk is twice as large as the previous one. Growing just allocates the next
+chunk. So pointers to elements stay valid as long as the element exists and nothing is
+ever copied. The chunk and offset of an index are calculated with a few bit operations.
+
+seg_array_p a = seg_array_of(int);
+seg_array_append(a, int, 7);
+int* ptr = seg_array_append_ptr(a);   // stays valid, no matter how many elements follow
+seg_array_elem(a, int, 0);            // -> 7
+
+// Iterate chunk by chunk, the elements within a chunk are contiguous
+for(size_t c = 0; c < a->chunk_count; c++) {
+	size_t n;
+	int* elements = seg_array_chunk(a, c, &n);
+	for(size_t i = 0; i < n; i++)
+		elements[i];
+}
+
+seg_array_destroy(a);
+
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+
+// The directory is large enough for every possible size_t index
+#define SEG_ARRAY_MAX_CHUNKS  64
+#define SEG_ARRAY_DEFAULT_FIRST_CHUNK_CAPACITY  16
+
+typedef struct {
+	size_t length, capacity;
+	size_t element_size;
+	uint8_t first_chunk_bits;  // log2 of the first chunk capacity
+	size_t chunk_count;        // Number of allocated chunks
+	void* chunks[SEG_ARRAY_MAX_CHUNKS];
+} seg_array_t, *seg_array_p;
+
+#define seg_array_of(type)  seg_array_new(0, sizeof(type))
+
+#define seg_array_elem(array, type, index)    (*(type*)seg_array_elem_ptr(array, index))
+#define seg_array_append(array, type, value)  (*(type*)seg_array_append_ptr(array) = (value))
+
+// A first chunk capacity of 0 uses SEG_ARRAY_DEFAULT_FIRST_CHUNK_CAPACITY
+seg_array_p seg_array_new(size_t first_chunk_capacity, size_t element_size);
+void        seg_array_destroy(seg_array_p array);
+
+void*       seg_array_elem_ptr(seg_array_p array, size_t index);
+// Returns NULL if the next chunk couldn't be allocated
+void*       seg_array_append_ptr(seg_array_p array);
+
+// Growing allocates chunks as needed, shrinking keeps them (and pointers to the
+// remaining elements valid). Returns false if a chunk couldn't be allocated.
+bool        seg_array_resize(seg_array_p array, size_t new_length);
+bool        seg_array_reserve(seg_array_p array, size_t capacity);
+// Frees the chunks after the one with the last element
+void        seg_array_shrink_to_fit(seg_array_p array);
+
+// Returns the elements of chunk `chunk` and their number in `length` (0 for chunks after
+// the last element)
+void*       seg_array_chunk(seg_array_p array, size_t chunk, size_t* length);
\ No newline at end of file
@@ -0,0 +1,290 @@
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "shm_hash.h"
+
+/**
+ * Layout of the shared memory region:
+ * 
+ *   | shm_hash_header_t               |  Sizes, offsets and the process shared lock
+ *   | capacity * slot_size bytes      |  Slots, starting at header->slots_offset
+ *   | heap_size bytes                 |  Copies of string keys, starting at header->heap_offset
+ * 
+ * Each slot contains the 64 bit hash of its key (0 == free, UINT64_MAX == deleted),
+ * the 64 bit key (the integer key or the heap offset of the string key) and the
+ * value rounded up to a multiple of 8 bytes. All offsets are relative to the start
+ * of the region so it works no matter where it is mapped.
+ */
+
+#define SHM_HASH_MAGIC         UINT64_C(0x68736168636373)  // "scchash"
+#define SHM_HASH_NUMERIC_KEYS  0
+#define SHM_HASH_STRING_KEYS   1
+
+#define SHM_HASH_SLOT_FREE     0
+#define SHM_HASH_SLOT_DELETED  UINT64_MAX
+
+#define slot_ptr(hash, index)  ( (hash)->slots + (hash)->slot_size * (index) )
+#define slot_hash_ptr(slot)    ( (uint64_t*)(slot) )
+#define slot_key_ptr(slot)     ( (uint64_t*)(slot) + 1 )
+#define slot_value_ptr(slot)   ( (void*)((uint64_t*)(slot) + 2) )
+
+static shm_hash_p shm_hash_map(int fd, size_t region_size);
+static shm_hash_p shm_unified_create(const char* name, size_t capacity, size_t value_size, size_t heap_size, uint64_t key_type);
+static ssize_t    shm_unified_search(shm_hash_p hash, uint64_t int_key, const char* string_key, uint64_t key_hash);
+static void*      shm_unified_get_ptr(shm_hash_p hash, uint64_t int_key, const char* string_key, uint64_t key_hash);
+static void*      shm_unified_put_ptr(shm_hash_p hash, uint64_t int_key, const char* string_key, uint64_t key_hash);
+static void       shm_unified_remove(shm_hash_p hash, uint64_t int_key, const char* string_key, uint64_t key_hash);
+
+
+//
+// Mapping from the hash or dict specific functions to the unified functions
+//
+
+shm_hash_p shm_hash_create(const char* name, size_t capacity, size_t value_size, size_t heap_size) { return shm_unified_create(name, capacity, value_size, heap_size, SHM_HASH_NUMERIC_KEYS); }
+void*      shm_hash_get_ptr(shm_hash_p hash, hash_key_t key)   { return shm_unified_get_ptr(hash, key, NULL, hash_key_hash(key)); }
+void*      shm_hash_put_ptr(shm_hash_p hash, hash_key_t key)   { return shm_unified_put_ptr(hash, key, NULL, hash_key_hash(key)); }
+bool       shm_hash_contains(shm_hash_p hash, hash_key_t key)  { return shm_unified_get_ptr(hash, key, NULL, hash_key_hash(key)) != NULL; }
+void       shm_hash_remove(shm_hash_p hash, hash_key_t key)    { shm_unified_remove(hash, key, NULL, hash_key_hash(key)); }
+
+shm_dict_p shm_dict_create(const char* name, size_t capacity, size_t value_size, size_t heap_size) { return shm_unified_create(name, capacity, value_size, heap_size, SHM_HASH_STRING_KEYS); }
+void*      shm_dict_get_ptr(shm_dict_p dict, const char* key)   { return shm_unified_get_ptr(dict, 0, key, dict_key_hash(key)); }
+void*      shm_dict_put_ptr(shm_dict_p dict, const char* key)   { return shm_unified_put_ptr(dict, 0, key, dict_key_hash(key)); }
+bool       shm_dict_contains(shm_dict_p dict, const char* key)  { return shm_unified_get_ptr(dict, 0, key, dict_key_hash(key)) != NULL; }
+void       shm_dict_remove(shm_dict_p dict, const char* key)    { shm_unified_remove(dict, 0, key, dict_key_hash(key)); }
+
+
+//
+// Creating, opening and closing regions
+//
+
+/**
+ * Creates a new region with an empty table. With a `name` the region is a named POSIX
+ * shared memory object that other processes can open with shm_hash_open(). Without a
+ * name (NULL) an anonymous shared mapping is used. It is shared with all processes
+ * forked after the creation.
+ * 
+ * Returns NULL if the region could not be created (e.g. the name already exists).
+ */
+static shm_hash_p shm_unified_create(const char* name, size_t capacity, size_t value_size, size_t heap_size, uint64_t key_type){
+	if (capacity == 0)
+		capacity = 1;
+	
+	size_t slot_size = 2 * sizeof(uint64_t) + (value_size + 7) / 8 * 8;
+	size_t slots_offset = (sizeof(shm_hash_header_t) + 63) / 64 * 64;
+	size_t heap_offset = slots_offset + capacity * slot_size;
+	size_t region_size = heap_offset + heap_size;
+	
+	int fd = -1;
+	if (name != NULL) {
+		fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+		if (fd == -1)
+			return NULL;
+		
+		if (ftruncate(fd, region_size) == -1) {
+			close(fd);
+			shm_unlink(name);
+			return NULL;
+		}
+	}
+	
+	shm_hash_p hash = shm_hash_map(fd, region_size);
+	if (fd != -1)
+		close(fd);
+	if (hash == NULL) {
+		if (name != NULL)
+			shm_unlink(name);
+		return NULL;
+	}
+	
+	// New regions are zero filled, so all slots are already free
+	shm_hash_header_t* header = hash->header;
+	header->region_size = region_size;
+	header->capacity = capacity;
+	header->length = 0;
+	header->value_size = value_size;
+	header->key_type = key_type;
+	header->slots_offset = slots_offset;
+	header->heap_offset = heap_offset;
+	header->heap_size = heap_size;
+	header->heap_used = 0;
+	
+	pthread_rwlockattr_t attr;
+	pthread_rwlockattr_init(&attr);
+	pthread_rwlockattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+	pthread_rwlock_init(&header->lock, &attr);
+	pthread_rwlockattr_destroy(&attr);
+	
+	// Write the magic number last, shm_hash_open() rejects regions without it
+	__atomic_store_n(&header->magic, SHM_HASH_MAGIC, __ATOMIC_RELEASE);
+	
+	hash->slots = (char*)header + slots_offset;
+	hash->heap = (char*)header + heap_offset;
+	hash->slot_size = slot_size;
+	return hash;
+}
+
+/**
+ * Maps an existing named region. Returns NULL if it doesn't exist or doesn't contain a
+ * hash table.
+ */
+shm_hash_p shm_hash_open(const char* name){
+	int fd = shm_open(name, O_RDWR, 0);
+	if (fd == -1)
+		return NULL;
+	
+	struct stat info;
+	if (fstat(fd, &info) == -1 || (size_t)info.st_size < sizeof(shm_hash_header_t)) {
+		close(fd);
+		return NULL;
+	}
+	
+	shm_hash_p hash = shm_hash_map(fd, info.st_size);
+	close(fd);
+	if (hash == NULL)
+		return NULL;
+	
+	shm_hash_header_t* header = hash->header;
+	if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != SHM_HASH_MAGIC || header->region_size != (uint64_t)info.st_size) {
+		munmap(header, info.st_size);
+		free(hash);
+		return NULL;
+	}
+	
+	hash->slots = (char*)header + header->slots_offset;
+	hash->heap = (char*)header + header->heap_offset;
+	hash->slot_size = 2 * sizeof(uint64_t) + (header->value_size + 7) / 8 * 8;
+	return hash;
+}
+
+/**
+ * Unmaps the region. The region itself stays alive as long as it's mapped by other
+ * processes or, for named regions, until it's unlinked.
+ */
+void shm_hash_close(shm_hash_p hash){
+	munmap(hash->header, hash->header->region_size);
+	free(hash);
+}
+
+bool shm_hash_unlink(const char* name){
+	return shm_unlink(name) == 0;
+}
+
+static shm_hash_p shm_hash_map(int fd, size_t region_size){
+	shm_hash_p hash = malloc(sizeof(shm_hash_t));
+	if (hash == NULL)
+		return NULL;
+	
+	int flags = (fd == -1) ? MAP_SHARED | MAP_ANONYMOUS : MAP_SHARED;
+	void* region = mmap(NULL, region_size, PROT_READ | PROT_WRITE, flags, fd, 0);
+	if (region == MAP_FAILED) {
+		free(hash);
+		return NULL;
+	}
+	
+	hash->header = region;
+	return hash;
+}
+
+
+//
+// Locking
+//
+
+void shm_hash_read_lock(shm_hash_p hash)  { pthread_rwlock_rdlock(&hash->header->lock); }
+void shm_hash_write_lock(shm_hash_p hash) { pthread_rwlock_wrlock(&hash->header->lock); }
+void shm_hash_unlock(shm_hash_p hash)     { pthread_rwlock_unlock(&hash->header->lock); }
+
+
+//
+// Lookup, get and put functions. Same probing scheme as the unified hash in hash.c.
+//
+
+/**
+ * Return value >= 0: The key has been found and it's index is returned.
+ * Return value <= -1: The key was not found. The index of a free slot -1 is returned
+ *   as a negative number (first deleted slot or first free slot of the probe sequence).
+ */
+static ssize_t shm_unified_search(shm_hash_p hash, uint64_t int_key, const char* string_key, uint64_t key_hash){
+	shm_hash_header_t* header = hash->header;
+	size_t index = key_hash % header->capacity;
+	ssize_t first_deleted_index = -1;
+	
+	for(size_t probe_offset = 0; probe_offset < header->capacity; probe_offset++) {
+		char* slot = slot_ptr(hash, index);
+		uint64_t slot_hash = *slot_hash_ptr(slot);
+		
+		if (slot_hash == SHM_HASH_SLOT_FREE) {
+			return (first_deleted_index != -1) ? -(first_deleted_index + 1) : -(ssize_t)(index + 1);
+		} else if (slot_hash == SHM_HASH_SLOT_DELETED) {
+			if (first_deleted_index == -1)
+				first_deleted_index = index;
+		} else if (slot_hash == key_hash) {
+			if (header->key_type == SHM_HASH_NUMERIC_KEYS) {
+				if (*slot_key_ptr(slot) == int_key)
+					return index;
+			} else {
+				if (strcmp(hash->heap + *slot_key_ptr(slot), string_key) == 0)
+					return index;
+			}
+		}
+		
+		index = (index + 1) % header->capacity;
+	}
+	
+	return (first_deleted_index != -1) ? -(first_deleted_index + 1) : -(ssize_t)header->capacity - 1;
+}
+
+static void* shm_unified_get_ptr(shm_hash_p hash, uint64_t int_key, const char* string_key, uint64_t key_hash){
+	ssize_t index = shm_unified_search(hash, int_key, string_key, key_hash);
+	if (index < 0)
+		return NULL;
+	return slot_value_ptr(slot_ptr(hash, index));
+}
+
+/**
+ * Returns the value of the key and inserts it if necessary. Returns NULL if the table is
+ * already 75% full or there is not enough heap space left for a string key.
+ */
+static void* shm_unified_put_ptr(shm_hash_p hash, uint64_t int_key, const char* string_key, uint64_t key_hash){
+	shm_hash_header_t* header = hash->header;
+	ssize_t index = shm_unified_search(hash, int_key, string_key, key_hash);
+	if (index >= 0)
+		return slot_value_ptr(slot_ptr(hash, index));
+	
+	if (header->length + 1 > header->capacity * 0.75 || -index - 1 >= (ssize_t)header->capacity)
+		return NULL;
+	
+	if (header->key_type == SHM_HASH_STRING_KEYS) {
+		size_t key_size = strlen(string_key) + 1;
+		if (header->heap_used + key_size > header->heap_size)
+			return NULL;
+		
+		memcpy(hash->heap + header->heap_used, string_key, key_size);
+		int_key = header->heap_used;
+		header->heap_used += key_size;
+	}
+	
+	char* slot = slot_ptr(hash, -index - 1);
+	*slot_key_ptr(slot) = int_key;
+	*slot_hash_ptr(slot) = key_hash;
+	header->length++;
+	
+	return slot_value_ptr(slot);
+}
+
+/**
+ * Marks the slot as deleted. The heap space of a string key is not reclaimed.
+ */
+static void shm_unified_remove(shm_hash_p hash, uint64_t int_key, const char* string_key, uint64_t key_hash){
+	ssize_t index = shm_unified_search(hash, int_key, string_key, key_hash);
+	if (index < 0)
+		return;
+	
+	*slot_hash_ptr(slot_ptr(hash, index)) = SHM_HASH_SLOT_DELETED;
+	hash->header->length--;
+}
\ No newline at end of file
@@ -0,0 +1,109 @@
+#pragma once
+
+/**
+
+# Hash tables in shared memory
+
+A shm hash (integer keys) or shm dict (string keys) lives entirely in one shared
+memory region. Processes that map the same region see the same table, so e.g.
+pre-forked workers can share one physical copy instead of building their own.
+
+Since the region can be mapped at different addresses in different processes it
+contains no pointers. String keys are copied into a heap at the end of the region
+and slots store the offset of the string. The table has a fixed capacity and heap
+size, it is never resized. Puts return NULL once the table or heap is full.
+
+
+// Anonymous region, shared with all child processes forked afterwards
+
+shm_hash_p hash = shm_hash_create(NULL, 1000, sizeof(int), 0);
+shm_dict_p dict = shm_dict_create(NULL, 1000, sizeof(int), 64 * 1024);  // with 64 KiB for keys
+
+
+// Named region (see shm_open()), other processes can open it by name
+
+shm_hash_p hash = shm_hash_create("/routes", 1000, sizeof(int), 0);
+shm_hash_p other = shm_hash_open("/routes");
+shm_hash_close(other);
+shm_hash_close(hash);
+shm_hash_unlink("/routes");
+
+
+// Get and put, the same for shm_dict_* with string keys
+
+shm_hash_put(hash, 7, int, 42);
+int* value = shm_hash_get_ptr(hash, 7);
+shm_hash_get(hash, 7, int);   // -> 42
+shm_hash_contains(hash, 7);   // -> true
+shm_hash_remove(hash, 7);
+
+
+// Locking. The get and put functions don't lock. Either build the table before
+// forking and only read it afterwards or use the process shared read-write lock.
+
+shm_hash_read_lock(hash);
+…
+shm_hash_unlock(hash);
+
+shm_hash_write_lock(hash);
+…
+shm_hash_unlock(hash);
+
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "hash.h"
+
+
+typedef struct {
+	uint64_t magic;
+	uint64_t region_size;
+	uint64_t capacity, length;
+	uint64_t value_size, key_type;
+	uint64_t slots_offset, heap_offset, heap_size, heap_used;
+	pthread_rwlock_t lock;
+} shm_hash_header_t;
+
+typedef struct {
+	shm_hash_header_t* header;
+	char* slots;
+	char* heap;
+	size_t slot_size;
+} shm_hash_t, *shm_hash_p, *shm_dict_p;
+
+
+shm_hash_p shm_hash_create(const char* name, size_t capacity, size_t value_size, size_t heap_size);
+shm_hash_p shm_hash_open(const char* name);
+void       shm_hash_close(shm_hash_p hash);
+bool       shm_hash_unlink(const char* name);
+
+#define    shm_hash_put(hash, key, type, value)  ( *((type*)shm_hash_put_ptr(hash, key)) = (value) )
+#define    shm_hash_get(hash, key, type)         ( *((type*)shm_hash_get_ptr(hash, key)) )
+void*      shm_hash_get_ptr(shm_hash_p hash, hash_key_t key);
+void*      shm_hash_put_ptr(shm_hash_p hash, hash_key_t key);
+bool       shm_hash_contains(shm_hash_p hash, hash_key_t key);
+void       shm_hash_remove(shm_hash_p hash, hash_key_t key);
+
+void       shm_hash_read_lock(shm_hash_p hash);
+void       shm_hash_write_lock(shm_hash_p hash);
+void       shm_hash_unlock(shm_hash_p hash);
+
+
+shm_dict_p shm_dict_create(const char* name, size_t capacity, size_t value_size, size_t heap_size);
+#define    shm_dict_open(name)                   shm_hash_open(name)
+#define    shm_dict_close(dict)                  shm_hash_close(dict)
+#define    shm_dict_unlink(name)                 shm_hash_unlink(name)
+
+#define    shm_dict_put(dict, key, type, value)  ( *((type*)shm_dict_put_ptr(dict, key)) = (value) )
+#define    shm_dict_get(dict, key, type)         ( *((type*)shm_dict_get_ptr(dict, key)) )
+void*      shm_dict_get_ptr(shm_dict_p dict, const char* key);
+void*      shm_dict_put_ptr(shm_dict_p dict, const char* key);
+bool       shm_dict_contains(shm_dict_p dict, const char* key);
+void       shm_dict_remove(shm_dict_p dict, const char* key);
+
+#define    shm_dict_read_lock(dict)              shm_hash_read_lock(dict)
+#define    shm_dict_write_lock(dict)             shm_hash_write_lock(dict)
+#define    shm_dict_unlock(dict)                 shm_hash_unlock(dict)
\ No newline at end of file
@@ -0,0 +1,395 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "sketch.h"
+
+/**
+ * All sketches start with the dict hash of the key. It's run through the 64 bit
+ * finalizer of MurmurHash3 so all bits depend on the whole key (the dict string hash
+ * is optimized for speed, not for well mixed bits).
+ * 
+ * The count-min sketch needs one index per row. They are derived from two mixed hashes
+ * with double hashing (h1 + row * h2), see "Less Hashing, Same Performance" by Kirsch
+ * and Mitzenmacher.
+ */
+
+static uint64_t sketch_mix(uint64_t h);
+static size_t   count_min_index(count_min_p cm, uint64_t h1, uint64_t h2, size_t row);
+static void     top_k_add_with_error(top_k_p top, const char* key, uint64_t count, uint64_t error);
+static void     top_k_swap(top_k_p top, size_t a, size_t b);
+static void     top_k_sift_up(top_k_p top, size_t index);
+static void     top_k_sift_down(top_k_p top, size_t index);
+
+// Rebuild the candidate dict of top-k when this fraction of its slots was deleted
+#define TOP_K_REBUILD_LOAD  0.1
+
+
+//
+// Count-min sketch
+//
+
+count_min_p count_min_new(size_t width, size_t depth){
+	if (width == 0 || depth == 0)
+		return NULL;
+	
+	count_min_p cm = malloc(sizeof(count_min_t));
+	if (cm == NULL)
+		return NULL;
+	
+	cm->counters = calloc(width * depth, sizeof(uint64_t));
+	if (cm->counters == NULL) {
+		free(cm);
+		return NULL;
+	}
+	
+	cm->width = width;
+	cm->depth = depth;
+	cm->total = 0;
+	return cm;
+}
+
+/**
+ * Creates a sketch that overestimates by at most `epsilon * total` with a probability
+ * of `1 - delta`. The width is e / epsilon and the depth ln(1 / delta).
+ */
+count_min_p count_min_for_error(double epsilon, double delta){
+	if (epsilon <= 0 || delta <= 0 || delta >= 1)
+		return NULL;
+	
+	size_t width = (size_t)(2.718281828459045 / epsilon) + 1;
+	size_t depth = (size_t)ceil(log(1 / delta));
+	return count_min_new(width, depth > 0 ? depth : 1);
+}
+
+void count_min_destroy(count_min_p cm){
+	free(cm->counters);
+	free(cm);
+}
+
+/**
+ * Adds `count` to the key and returns the new estimate. Uses conservative update: only
+ * counters below the new estimate are raised (to the new estimate). This keeps the
+ * estimate an overestimate but reduces the error considerably.
+ */
+uint64_t count_min_add(count_min_p cm, const char* key, uint64_t count){
+	uint64_t h = sketch_mix(dict_key_hash(key));
+	uint64_t h1 = h, h2 = sketch_mix(h) | 1;
+	
+	uint64_t estimate = UINT64_MAX;
+	for(size_t row = 0; row < cm->depth; row++) {
+		uint64_t counter = cm->counters[count_min_index(cm, h1, h2, row)];
+		if (counter < estimate)
+			estimate = counter;
+	}
+	
+	estimate = (estimate > UINT64_MAX - count) ? UINT64_MAX : estimate + count;
+	for(size_t row = 0; row < cm->depth; row++) {
+		uint64_t* counter = &cm->counters[count_min_index(cm, h1, h2, row)];
+		if (*counter < estimate)
+			*counter = estimate;
+	}
+	
+	cm->total += count;
+	return estimate;
+}
+
+uint64_t count_min_estimate(count_min_p cm, const char* key){
+	uint64_t h = sketch_mix(dict_key_hash(key));
+	uint64_t h1 = h, h2 = sketch_mix(h) | 1;
+	
+	uint64_t estimate = UINT64_MAX;
+	for(size_t row = 0; row < cm->depth; row++) {
+		uint64_t counter = cm->counters[count_min_index(cm, h1, h2, row)];
+		if (counter < estimate)
+			estimate = counter;
+	}
+	
+	return estimate;
+}
+
+/**
+ * Adds all counters of `src` to `dest`. Both need the same width and depth, otherwise
+ * nothing is merged and false is returned. The merged sketch still never
+ * underestimates, but conservative update only reduced the error within each sketch.
+ */
+bool count_min_merge(count_min_p dest, count_min_p src){
+	if (dest->width != src->width || dest->depth != src->depth)
+		return false;
+	
+	for(size_t i = 0; i < dest->width * dest->depth; i++) {
+		uint64_t sum = dest->counters[i] + src->counters[i];
+		dest->counters[i] = (sum < dest->counters[i]) ? UINT64_MAX : sum;
+	}
+	
+	dest->total += src->total;
+	return true;
+}
+
+static size_t count_min_index(count_min_p cm, uint64_t h1, uint64_t h2, size_t row){
+	return row * cm->width + (h1 + row * h2) % cm->width;
+}
+
+
+//
+// HyperLogLog
+//
+// The first `precision` bits of the hash select a register. Each register stores the
+// largest number of leading zeros + 1 seen in the remaining bits. Uses the linear
+// counting correction for small cardinalities from the original paper. With 64 bit
+// hashes no correction for large cardinalities is necessary.
+//
+
+/**
+ * Creates a HyperLogLog sketch with 2^precision registers. `precision` has to be
+ * between 4 and 18, otherwise NULL is returned.
+ */
+hyperloglog_p hyperloglog_new(uint8_t precision){
+	if (precision < 4 || precision > 18)
+		return NULL;
+	
+	hyperloglog_p hll = malloc(sizeof(hyperloglog_t));
+	if (hll == NULL)
+		return NULL;
+	
+	hll->precision = precision;
+	hll->register_count = (size_t)1 << precision;
+	hll->registers = calloc(hll->register_count, sizeof(uint8_t));
+	if (hll->registers == NULL) {
+		free(hll);
+		return NULL;
+	}
+	
+	return hll;
+}
+
+void hyperloglog_destroy(hyperloglog_p hll){
+	free(hll->registers);
+	free(hll);
+}
+
+void hyperloglog_add(hyperloglog_p hll, const char* key){
+	uint64_t h = sketch_mix(dict_key_hash(key));
+	size_t index = h >> (64 - hll->precision);
+	uint64_t rest = h << hll->precision;
+	uint8_t rank = (rest == 0) ? 64 - hll->precision + 1 : __builtin_clzll(rest) + 1;
+	
+	if (rank > hll->registers[index])
+		hll->registers[index] = rank;
+}
+
+uint64_t hyperloglog_count(hyperloglog_p hll){
+	double m = hll->register_count;
+	double alpha;
+	switch(hll->register_count) {
+		case 16:  alpha = 0.673; break;
+		case 32:  alpha = 0.697; break;
+		case 64:  alpha = 0.709; break;
+		default:  alpha = 0.7213 / (1 + 1.079 / m); break;
+	}
+	
+	double sum = 0;
+	size_t zero_registers = 0;
+	for(size_t i = 0; i < hll->register_count; i++) {
+		sum += ldexp(1.0, -hll->registers[i]);
+		if (hll->registers[i] == 0)
+			zero_registers++;
+	}
+	
+	double estimate = alpha * m * m / sum;
+	if (estimate <= 2.5 * m && zero_registers > 0)
+		estimate = m * log(m / zero_registers);
+	
+	return (uint64_t)(estimate + 0.5);
+}
+
+/**
+ * Merges `src` into `dest` so `dest` counts the keys of both. Both need the same
+ * precision, otherwise false is returned.
+ */
+bool hyperloglog_merge(hyperloglog_p dest, hyperloglog_p src){
+	if (dest->precision != src->precision)
+		return false;
+	
+	for(size_t i = 0; i < dest->register_count; i++) {
+		if (src->registers[i] > dest->registers[i])
+			dest->registers[i] = src->registers[i];
+	}
+	
+	return true;
+}
+
+
+//
+// Space-saving top-k
+//
+// The k candidates are kept in a min-heap ordered by count. The candidates dict maps
+// each key to its index in the heap. When a new key arrives and all k places are taken
+// it replaces the candidate with the smallest count. It inherits that count as its
+// error (it might have appeared that often before).
+//
+
+/**
+ * Creates a top-k tracker for the `k` most frequent keys. Returns NULL if k is 0 or the
+ * memory could not be allocated.
+ */
+top_k_p top_k_new(size_t k){
+	if (k == 0)
+		return NULL;
+	
+	top_k_p top = malloc(sizeof(top_k_t));
+	if (top == NULL)
+		return NULL;
+	
+	top->candidates = dict_new(k / 0.75 + 2, sizeof(size_t));
+	top->heap = malloc(k * sizeof(top_k_item_t));
+	if (top->candidates == NULL || top->heap == NULL) {
+		if (top->candidates)
+			dict_destroy(top->candidates);
+		free(top->heap);
+		free(top);
+		return NULL;
+	}
+	
+	top->k = k;
+	top->length = 0;
+	top->deleted_slots = 0;
+	return top;
+}
+
+void top_k_destroy(top_k_p top){
+	for(size_t i = 0; i < top->length; i++)
+		free((char*)top->heap[i].key);
+	
+	dict_destroy(top->candidates);
+	free(top->heap);
+	free(top);
+}
+
+void top_k_add(top_k_p top, const char* key, uint64_t count){
+	top_k_add_with_error(top, key, count, 0);
+}
+
+static int top_k_compare_desc(const void* a, const void* b){
+	uint64_t count_a = ((const top_k_item_t*)a)->count, count_b = ((const top_k_item_t*)b)->count;
+	return (count_a < count_b) - (count_a > count_b);
+}
+
+/**
+ * Copies up to `n` candidates into `items`, most frequent first. Returns the number of
+ * copied items. The keys are owned by the tracker and only valid until the next add or
+ * merge.
+ */
+size_t top_k_list(top_k_p top, top_k_item_t* items, size_t n){
+	top_k_item_t* sorted = malloc(top->length * sizeof(top_k_item_t) + 1);
+	if (sorted == NULL)
+		return 0;
+	
+	memcpy(sorted, top->heap, top->length * sizeof(top_k_item_t));
+	qsort(sorted, top->length, sizeof(top_k_item_t), top_k_compare_desc);
+	
+	if (n > top->length)
+		n = top->length;
+	memcpy(items, sorted, n * sizeof(top_k_item_t));
+	
+	free(sorted);
+	return n;
+}
+
+/**
+ * Adds all candidates of `src` to `dest` including their counts and errors. The counts
+ * stay overestimates. `dest` and `src` can have a different k.
+ */
+void top_k_merge(top_k_p dest, top_k_p src){
+	for(size_t i = 0; i < src->length; i++)
+		top_k_add_with_error(dest, src->heap[i].key, src->heap[i].count, src->heap[i].error);
+}
+
+static void top_k_add_with_error(top_k_p top, const char* key, uint64_t count, uint64_t error){
+	size_t* index = dict_get_ptr(top->candidates, key);
+	if (index != NULL) {
+		top->heap[*index].count += count;
+		top->heap[*index].error += error;
+		top_k_sift_down(top, *index);
+		return;
+	}
+	
+	char* key_copy = malloc(strlen(key) + 1);
+	if (key_copy == NULL)
+		return;
+	strcpy(key_copy, key);
+	
+	if (top->length < top->k) {
+		top->heap[top->length] = (top_k_item_t){ key_copy, count, error };
+		dict_put(top->candidates, key_copy, size_t, top->length);
+		top->length++;
+		top_k_sift_up(top, top->length - 1);
+		return;
+	}
+	
+	// Replace the candidate with the smallest count
+	top_k_item_t* min = &top->heap[0];
+	dict_remove(top->candidates, min->key);
+	free((char*)min->key);
+	top->deleted_slots++;
+	
+	*min = (top_k_item_t){ key_copy, min->count + count, min->count + error };
+	dict_put(top->candidates, key_copy, size_t, 0);
+	top_k_sift_down(top, 0);
+	
+	// Replacing candidates leaves deleted slots behind, get rid of them from time to time
+	if (top->deleted_slots > top->candidates->capacity * TOP_K_REBUILD_LOAD) {
+		dict_resize(top->candidates, top->candidates->capacity);
+		top->deleted_slots = 0;
+	}
+}
+
+static void top_k_swap(top_k_p top, size_t a, size_t b){
+	top_k_item_t temp = top->heap[a];
+	top->heap[a] = top->heap[b];
+	top->heap[b] = temp;
+	
+	dict_put(top->candidates, top->heap[a].key, size_t, a);
+	dict_put(top->candidates, top->heap[b].key, size_t, b);
+}
+
+static void top_k_sift_up(top_k_p top, size_t index){
+	while(index > 0) {
+		size_t parent = (index - 1) / 2;
+		if (top->heap[parent].count <= top->heap[index].count)
+			break;
+		
+		top_k_swap(top, parent, index);
+		index = parent;
+	}
+}
+
+static void top_k_sift_down(top_k_p top, size_t index){
+	while(true) {
+		size_t smallest = index;
+		size_t left = 2 * index + 1, right = 2 * index + 2;
+		if (left < top->length && top->heap[left].count < top->heap[smallest].count)
+			smallest = left;
+		if (right < top->length && top->heap[right].count < top->heap[smallest].count)
+			smallest = right;
+		
+		if (smallest == index)
+			break;
+		
+		top_k_swap(top, smallest, index);
+		index = smallest;
+	}
+}
+
+
+//
+// Hash mixing
+//
+
+static uint64_t sketch_mix(uint64_t h){
+	h ^= h >> 33;
+	h *= UINT64_C(0xff51afd7ed558ccd);
+	h ^= h >> 33;
+	h *= UINT64_C(0xc4ceb9fe1a85ec53);
+	h ^= h >> 33;
+	return h;
+}
\ No newline at end of file
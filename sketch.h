@@ -0,0 +1,100 @@
+#pragma once
+
+/**
+
+# Sketches for approximate counting of string keys
+
+Sketches answer "how often did this key appear?", "how many different keys were
+there?" and "which keys appeared most often?" approximately but with a fixed amount of
+memory, no matter how long the stream of keys is. All of them hash keys with the same
+function as dicts (dict_key_hash()).
+
+Sketches of the same size can be merged, e.g. one sketch per thread that are merged
+once all threads are done.
+
+
+// Count-min sketch: Frequency estimates. Never underestimates, overestimates by at most
+// epsilon * total count with a probability of 1 - delta.
+
+count_min_p cm = count_min_for_error(0.001, 0.01);   // or count_min_new(width, depth)
+count_min_add(cm, "foo", 1);
+count_min_estimate(cm, "foo");    // -> 1 (or a bit more)
+count_min_merge(cm, other_cm);
+count_min_destroy(cm);
+
+
+// HyperLogLog: Number of distinct keys with a standard error of about
+// 1.04 / sqrt(2^precision) using 2^precision bytes.
+
+hyperloglog_p hll = hyperloglog_new(14);   // 16 KiB, about 0.8% error
+hyperloglog_add(hll, "foo");
+hyperloglog_count(hll);           // -> 1
+hyperloglog_merge(hll, other_hll);
+hyperloglog_destroy(hll);
+
+
+// Space-saving top-k: Tracks the k most frequent keys. Keys are copied. A key counted
+// more than total / k times is guaranteed to be in there. The count of each key is an
+// overestimate by at most its `error`.
+
+top_k_p top = top_k_new(100);
+top_k_add(top, "foo", 1);
+
+top_k_item_t items[10];
+size_t n = top_k_list(top, items, 10);   // most frequent first
+items[0].key, items[0].count, items[0].error;
+
+top_k_merge(top, other_top);
+top_k_destroy(top);
+
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "hash.h"
+
+
+typedef struct {
+	size_t width, depth;
+	uint64_t total;
+	uint64_t* counters;
+} count_min_t, *count_min_p;
+
+count_min_p count_min_new(size_t width, size_t depth);
+count_min_p count_min_for_error(double epsilon, double delta);
+void        count_min_destroy(count_min_p cm);
+uint64_t    count_min_add(count_min_p cm, const char* key, uint64_t count);
+uint64_t    count_min_estimate(count_min_p cm, const char* key);
+bool        count_min_merge(count_min_p dest, count_min_p src);
+
+
+typedef struct {
+	uint8_t precision;
+	size_t register_count;
+	uint8_t* registers;
+} hyperloglog_t, *hyperloglog_p;
+
+hyperloglog_p hyperloglog_new(uint8_t precision);
+void          hyperloglog_destroy(hyperloglog_p hll);
+void          hyperloglog_add(hyperloglog_p hll, const char* key);
+uint64_t      hyperloglog_count(hyperloglog_p hll);
+bool          hyperloglog_merge(hyperloglog_p dest, hyperloglog_p src);
+
+
+typedef struct {
+	const char* key;
+	uint64_t count, error;
+} top_k_item_t;
+
+typedef struct {
+	size_t k, length, deleted_slots;
+	dict_p candidates;
+	top_k_item_t* heap;
+} top_k_t, *top_k_p;
+
+top_k_p top_k_new(size_t k);
+void    top_k_destroy(top_k_p top);
+void    top_k_add(top_k_p top, const char* key, uint64_t count);
+size_t  top_k_list(top_k_p top, top_k_item_t* items, size_t n);
+void    top_k_merge(top_k_p dest, top_k_p src);
\ No newline at end of file
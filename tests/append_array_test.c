@@ -0,0 +1,154 @@
+#include <stdint.h>
+#include <pthread.h>
+#include "testing.h"
+#include "../append_array.h"
+
+void test_new(){
+	append_array_p a = append_array_of(int);
+	check_not_null(a);
+	check_int(a->first_chunk_bits, 6);
+	check_int(append_array_sealed_length(a), 0);
+	append_array_destroy(a);
+}
+
+void test_append(){
+	append_array_p a = append_array_new(4, sizeof(int));
+	for(int i = 0; i < 100; i++) {
+		ssize_t index = append_array_append(a, &i);
+		check_int(index, i);
+	}
+	
+	check_int(append_array_sealed_length(a), 100);
+	for(int i = 0; i < 100; i++)
+		check_int(append_array_elem(a, int, i), i);
+	
+	append_array_destroy(a);
+}
+
+void test_reserve_write_commit(){
+	append_array_p a = append_array_new(4, sizeof(int));
+	int values[20];
+	for(int i = 0; i < 20; i++)
+		values[i] = i;
+	
+	size_t first, second;
+	check( append_array_reserve(a, 3, &first) );
+	// Spans the chunks of 4, 8 and 16 elements
+	check( append_array_reserve(a, 17, &second) );
+	check_int(first, 0);
+	check_int(second, 3);
+	
+	append_array_write(a, second, values + 3, 17);
+	append_array_write(a, first, values, 3);
+	check_int(append_array_sealed_length(a), 0);
+	check( append_array_commit(a, first, 3) );
+	check_int(append_array_sealed_length(a), 3);
+	check( append_array_commit(a, second, 17) );
+	check_int(append_array_sealed_length(a), 20);
+	
+	for(int i = 0; i < 20; i++)
+		check_int(append_array_elem(a, int, i), i);
+	
+	append_array_destroy(a);
+}
+
+void test_failed_reserve(){
+	append_array_p a = append_array_new(4, sizeof(int));
+	check_int(a->failed_start, SIZE_MAX);
+	
+	size_t first, second, third;
+	check( append_array_reserve(a, 3, &first) );
+	check( append_array_reserve(a, 5, &second) );
+	check( append_array_reserve(a, 2, &third) );
+	
+	// Pretend the chunk allocation of the second range failed
+	a->failed_start = second;
+	check( !append_array_commit(a, third, 2) );
+	check( append_array_commit(a, first, 3) );
+	check_int(append_array_sealed_length(a), 3);
+	check( !append_array_commit(a, third, 2) );
+	check_int(append_array_sealed_length(a), 3);
+	
+	append_array_destroy(a);
+}
+
+
+#define THREADS             4
+#define APPENDS_PER_THREAD  20000
+
+typedef struct {
+	append_array_p array;
+	uint32_t thread;
+} writer_t;
+
+typedef struct {
+	uint32_t thread, seq;
+} entry_t;
+
+static void* writer(void* arg){
+	writer_t* w = arg;
+	entry_t batch[7];
+	for(uint32_t seq = 0; seq < APPENDS_PER_THREAD; ) {
+		// Mix single appends and batches that cross chunk boundaries
+		if (seq % 2 == 0 || seq + 7 > APPENDS_PER_THREAD) {
+			entry_t entry = { w->thread + 1, seq++ };
+			append_array_append(w->array, &entry);
+		} else {
+			size_t start;
+			for(uint32_t i = 0; i < 7; i++)
+				batch[i] = (entry_t){ w->thread + 1, seq++ };
+			append_array_reserve(w->array, 7, &start);
+			append_array_write(w->array, start, batch, 7);
+			append_array_commit(w->array, start, 7);
+		}
+	}
+	return NULL;
+}
+
+void test_concurrent_appends(){
+	append_array_p a = append_array_new(16, sizeof(entry_t));
+	writer_t writers[THREADS];
+	pthread_t threads[THREADS];
+	for(uint32_t i = 0; i < THREADS; i++) {
+		writers[i] = (writer_t){ a, i };
+		pthread_create(&threads[i], NULL, writer, &writers[i]);
+	}
+	
+	// Everything below the sealed length has to be written already
+	size_t unwritten = 0;
+	size_t sealed = 0;
+	while (sealed < THREADS * APPENDS_PER_THREAD) {
+		sealed = append_array_sealed_length(a);
+		for(size_t i = (sealed > 100) ? sealed - 100 : 0; i < sealed; i++)
+			unwritten += (append_array_elem(a, entry_t, i).thread == 0);
+	}
+	
+	for(uint32_t i = 0; i < THREADS; i++)
+		pthread_join(threads[i], NULL);
+	check_int(unwritten, 0);
+	
+	// Each thread's entries have to be there exactly once and in order
+	uint32_t next_seq[THREADS] = { 0 };
+	size_t out_of_order = 0;
+	for(size_t i = 0; i < append_array_sealed_length(a); i++) {
+		entry_t entry = append_array_elem(a, entry_t, i);
+		out_of_order += (entry.seq != next_seq[entry.thread - 1]);
+		next_seq[entry.thread - 1] = entry.seq + 1;
+	}
+	check_int(out_of_order, 0);
+	for(uint32_t i = 0; i < THREADS; i++)
+		check_int(next_seq[i], APPENDS_PER_THREAD);
+	
+	append_array_destroy(a);
+}
+
+
+int main(){
+	run(test_new);
+	run(test_append);
+	run(test_reserve_write_commit);
+	run(test_failed_reserve);
+	run(test_concurrent_appends);
+	
+	return show_report();
+}
\ No newline at end of file
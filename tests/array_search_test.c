@@ -0,0 +1,260 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include "testing.h"
+#include "../array_search.h"
+
+// Every test runs with all instruction sets the CPU supports
+static array_search_isa_t max_isa(){
+	array_search_limit_isa(ARRAY_SEARCH_AVX512);
+	return array_search_isa();
+}
+
+void test_find_int32(){
+	array_p a = array_of(int32_t);
+	for(int32_t i = 0; i < 100; i++)
+		array_append(a, int32_t, i % 10);
+	
+	for(array_search_isa_t isa = ARRAY_SEARCH_SCALAR; isa <= max_isa(); isa++) {
+		array_search_limit_isa(isa);
+		check_int(array_find_first(a, ARRAY_INT32, &(int32_t){ 3 }), 3);
+		check_int(array_find_last(a, ARRAY_INT32, &(int32_t){ 3 }), 93);
+		check_int(array_count(a, ARRAY_INT32, &(int32_t){ 3 }), 10);
+		check_int(array_find_first(a, ARRAY_INT32, &(int32_t){ 10 }), -1);
+		check_int(array_find_last(a, ARRAY_INT32, &(int32_t){ 10 }), -1);
+		check_int(array_count(a, ARRAY_INT32, &(int32_t){ 10 }), 0);
+		
+		array_p indices = array_of(size_t);
+		size_t matches = array_find_all(a, ARRAY_INT32, &(int32_t){ 7 }, indices);
+		check_int(matches, 10);
+		check_int(indices->length, 10);
+		for(size_t i = 0; i < indices->length; i++)
+			check_int(array_elem(indices, size_t, i), i * 10 + 7);
+		array_destroy(indices);
+	}
+	
+	array_destroy(a);
+}
+
+void test_find_empty(){
+	array_p a = array_of(int64_t);
+	check_int(array_find_first(a, ARRAY_INT64, &(int64_t){ 0 }), -1);
+	check_int(array_find_last(a, ARRAY_INT64, &(int64_t){ 0 }), -1);
+	check_int(array_count(a, ARRAY_INT64, &(int64_t){ 0 }), 0);
+	array_destroy(a);
+}
+
+// Zeros in the partially filled last block must not be found when searching for 0
+void test_find_in_last_block(){
+	array_p a = array_of(int8_t);
+	for(size_t i = 0; i < 70; i++)
+		array_append(a, int8_t, 1);
+	
+	for(array_search_isa_t isa = ARRAY_SEARCH_SCALAR; isa <= max_isa(); isa++) {
+		array_search_limit_isa(isa);
+		check_int(array_count(a, ARRAY_INT8, &(int8_t){ 0 }), 0);
+		check_int(array_count(a, ARRAY_INT8, &(int8_t){ 1 }), 70);
+		check_int(array_find_last(a, ARRAY_INT8, &(int8_t){ 1 }), 69);
+	}
+	
+	array_destroy(a);
+}
+
+#define CHECK_AGAINST_LOOP(type, type_tag)  do {                                  \
+	for(size_t length = 0; length < 300; length += 7) {                           \
+		array_p a = array_of(type);                                               \
+		for(size_t i = 0; i < length; i++)                                        \
+			array_append(a, type, (type)(rand() % 4 - 2));                        \
+		                                                                          \
+		for(int v = -3; v <= 2; v++) {                                            \
+			type value = v;                                                       \
+			ssize_t first = -1, last = -1;                                        \
+			size_t count = 0;                                                     \
+			for(size_t i = 0; i < length; i++) {                                  \
+				if (array_elem(a, type, i) == value) {                            \
+					if (first == -1)                                              \
+						first = i;                                                \
+					last = i;                                                     \
+					count++;                                                      \
+				}                                                                 \
+			}                                                                     \
+			                                                                      \
+			ssize_t found_first = array_find_first(a, type_tag, &value);          \
+			ssize_t found_last = array_find_last(a, type_tag, &value);            \
+			size_t found_count = array_count(a, type_tag, &value);                \
+			check_int(found_first, first);                                        \
+			check_int(found_last, last);                                          \
+			check_int(found_count, count);                                        \
+		}                                                                         \
+		                                                                          \
+		array_destroy(a);                                                         \
+	}                                                                             \
+} while(0)
+
+void test_all_types(){
+	srand(1);
+	for(array_search_isa_t isa = ARRAY_SEARCH_SCALAR; isa <= max_isa(); isa++) {
+		array_search_limit_isa(isa);
+		CHECK_AGAINST_LOOP(int8_t, ARRAY_INT8);
+		CHECK_AGAINST_LOOP(int16_t, ARRAY_INT16);
+		CHECK_AGAINST_LOOP(int32_t, ARRAY_INT32);
+		CHECK_AGAINST_LOOP(int64_t, ARRAY_INT64);
+		CHECK_AGAINST_LOOP(uint8_t, ARRAY_UINT8);
+		CHECK_AGAINST_LOOP(uint64_t, ARRAY_UINT64);
+		CHECK_AGAINST_LOOP(float, ARRAY_FLOAT);
+		CHECK_AGAINST_LOOP(double, ARRAY_DOUBLE);
+	}
+}
+
+// Only the upper half of the 64 bit value differs, SSE2 compares the halves separately
+void test_find_int64_halves(){
+	array_p a = array_of(int64_t);
+	array_append(a, int64_t, 1);
+	array_append(a, int64_t, 1 + ((int64_t)1 << 32));
+	array_append(a, int64_t, 1);
+	
+	for(array_search_isa_t isa = ARRAY_SEARCH_SCALAR; isa <= max_isa(); isa++) {
+		array_search_limit_isa(isa);
+		check_int(array_count(a, ARRAY_INT64, &(int64_t){ 1 }), 2);
+		check_int(array_find_first(a, ARRAY_INT64, &(int64_t){ 1 + ((int64_t)1 << 32) }), 1);
+	}
+	
+	array_destroy(a);
+}
+
+void test_find_float_semantics(){
+	array_p a = array_of(double);
+	array_append(a, double, 1.0);
+	array_append(a, double, -0.0);
+	array_append(a, double, NAN);
+	
+	for(array_search_isa_t isa = ARRAY_SEARCH_SCALAR; isa <= max_isa(); isa++) {
+		array_search_limit_isa(isa);
+		check_int(array_find_first(a, ARRAY_DOUBLE, &(double){ 0.0 }), 1);
+		check_int(array_find_first(a, ARRAY_DOUBLE, &(double){ NAN }), -1);
+	}
+	
+	array_destroy(a);
+}
+
+typedef struct {
+	int32_t x, y, z;
+} point_t;
+
+void test_find_records(){
+	array_p a = array_of(point_t);
+	for(int32_t i = 0; i < 20; i++)
+		array_append(a, point_t, ((point_t){ i % 5, i, 0 }));
+	array_append(a, point_t, ((point_t){ 1, 1, 0 }));
+	
+	point_t p = { 1, 1, 0 };
+	check_int(array_find_first(a, ARRAY_RECORD, &p), 1);
+	check_int(array_find_last(a, ARRAY_RECORD, &p), 20);
+	check_int(array_count(a, ARRAY_RECORD, &p), 2);
+	
+	array_p indices = array_of(size_t);
+	check_int(array_find_all(a, ARRAY_RECORD, &p, indices), 2);
+	check_int(array_elem(indices, size_t, 0), 1);
+	check_int(array_elem(indices, size_t, 1), 20);
+	array_destroy(indices);
+	
+	p.z = 1;
+	check_int(array_find_first(a, ARRAY_RECORD, &p), -1);
+	
+	array_destroy(a);
+}
+
+void test_bounds(){
+	array_p a = array_of(int64_t);
+	int64_t values[] = { -5, 1, 3, 3, 3, 8, 10 };
+	for(size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+		array_append(a, int64_t, values[i]);
+	
+	check_int(array_lower_bound(a, ARRAY_INT64, &(int64_t){ 3 }), 2);
+	check_int(array_upper_bound(a, ARRAY_INT64, &(int64_t){ 3 }), 5);
+	check_int(array_lower_bound(a, ARRAY_INT64, &(int64_t){ -10 }), 0);
+	check_int(array_lower_bound(a, ARRAY_INT64, &(int64_t){ 11 }), 7);
+	check_int(array_upper_bound(a, ARRAY_INT64, &(int64_t){ 10 }), 7);
+	check_int(array_lower_bound(a, ARRAY_INT64, &(int64_t){ 4 }), 5);
+	
+	size_t start = 0;
+	size_t n = array_equal_range(a, ARRAY_INT64, &(int64_t){ 3 }, &start);
+	check_int(n, 3);
+	check_int(start, 2);
+	n = array_equal_range(a, ARRAY_INT64, &(int64_t){ 2 }, &start);
+	check_int(n, 0);
+	check_int(start, 2);
+	
+	array_destroy(a);
+	
+	a = array_of(int64_t);
+	check_int(array_lower_bound(a, ARRAY_INT64, &(int64_t){ 3 }), 0);
+	check_int(array_upper_bound(a, ARRAY_INT64, &(int64_t){ 3 }), 0);
+	array_destroy(a);
+}
+
+// Compares the binary search and the Eytzinger index with a linear search for all lengths
+// up to a few complete trees
+void test_bounds_against_loop(){
+	for(size_t length = 0; length < 140; length++) {
+		array_p a = array_of(uint32_t);
+		for(size_t i = 0; i < length; i++)
+			array_append(a, uint32_t, i * 2 - i % 3);
+		array_eytzinger_p index = array_build_eytzinger(a, ARRAY_UINT32);
+		check_not_null(index);
+		
+		size_t errors = 0;
+		for(uint32_t value = 0; value < length * 2 + 2; value++) {
+			size_t lower = 0, upper = 0;
+			while (lower < length && array_elem(a, uint32_t, lower) < value)
+				lower++;
+			while (upper < length && array_elem(a, uint32_t, upper) <= value)
+				upper++;
+			
+			errors += array_lower_bound(a, ARRAY_UINT32, &value) != lower;
+			errors += array_upper_bound(a, ARRAY_UINT32, &value) != upper;
+			errors += array_eytzinger_lower_bound(index, &value) != lower;
+		}
+		check_int(errors, 0);
+		
+		array_eytzinger_destroy(index);
+		array_destroy(a);
+	}
+}
+
+void test_eytzinger_layout(){
+	array_p a = array_of(int16_t);
+	for(int16_t i = 1; i <= 7; i++)
+		array_append(a, int16_t, i * 10);
+	
+	array_eytzinger_p index = array_build_eytzinger(a, ARRAY_INT16);
+	int16_t* keys = index->keys;
+	int16_t expected[] = { 0, 40, 20, 60, 10, 30, 50, 70 };
+	for(size_t k = 1; k <= 7; k++) {
+		check_int(keys[k], expected[k]);
+		check_int(index->indices[k], (size_t)(expected[k] / 10 - 1));
+	}
+	check_int((uintptr_t)index->keys % 64, 0);
+	
+	check_int(array_eytzinger_lower_bound(index, &(int16_t){ 35 }), 3);
+	check_int(array_eytzinger_lower_bound(index, &(int16_t){ 70 }), 6);
+	check_int(array_eytzinger_lower_bound(index, &(int16_t){ 71 }), 7);
+	
+	array_eytzinger_destroy(index);
+	array_destroy(a);
+}
+
+
+int main(){
+	run(test_find_int32);
+	run(test_find_empty);
+	run(test_find_in_last_block);
+	run(test_all_types);
+	run(test_find_int64_halves);
+	run(test_find_float_semantics);
+	run(test_find_records);
+	run(test_bounds);
+	run(test_bounds_against_loop);
+	run(test_eytzinger_layout);
+	
+	return show_report();
+}
\ No newline at end of file
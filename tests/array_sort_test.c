@@ -0,0 +1,147 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include "testing.h"
+#include "../array_sort.h"
+
+static uint64_t random_state = 1;
+
+static uint64_t next_random(){
+	random_state = random_state * 6364136223846793005 + 1442695040888963407;
+	return random_state >> 11;
+}
+
+void test_sort_ints(){
+	array_p a = array_of(int32_t);
+	int32_t values[] = { 5, -3, 0, 1000000, -1000000, 7, 5, -1, 2147483647, -2147483647 - 1 };
+	for(size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+		array_append(a, int32_t, values[i]);
+	
+	check( array_sort(a, ARRAY_INT32, 0) );
+	int32_t expected[] = { -2147483647 - 1, -1000000, -3, -1, 0, 5, 5, 7, 1000000, 2147483647 };
+	for(size_t i = 0; i < a->length; i++)
+		check_int(array_elem(a, int32_t, i), expected[i]);
+	
+	array_destroy(a);
+}
+
+#define CHECK_SORTED(type, type_tag)  do {                                     \
+	array_p a = array_of(type);                                                \
+	for(size_t i = 0; i < 5000; i++)                                           \
+		array_append(a, type, (type)(int64_t)(next_random() - (1ull << 52)));  \
+	                                                                           \
+	check( array_sort(a, type_tag, 0) );                                       \
+	size_t unsorted = 0;                                                       \
+	for(size_t i = 1; i < a->length; i++)                                      \
+		unsorted += array_elem(a, type, i - 1) > array_elem(a, type, i);       \
+	check_int(unsorted, 0);                                                    \
+	array_destroy(a);                                                          \
+} while(0)
+
+void test_sort_all_types(){
+	CHECK_SORTED(int8_t, ARRAY_INT8);
+	CHECK_SORTED(int16_t, ARRAY_INT16);
+	CHECK_SORTED(int32_t, ARRAY_INT32);
+	CHECK_SORTED(int64_t, ARRAY_INT64);
+	CHECK_SORTED(uint8_t, ARRAY_UINT8);
+	CHECK_SORTED(uint16_t, ARRAY_UINT16);
+	CHECK_SORTED(uint32_t, ARRAY_UINT32);
+	CHECK_SORTED(uint64_t, ARRAY_UINT64);
+	CHECK_SORTED(float, ARRAY_FLOAT);
+	CHECK_SORTED(double, ARRAY_DOUBLE);
+}
+
+void test_sort_floats(){
+	array_p a = array_of(double);
+	double values[] = { 1.5, -0.0, -2.25, 0.0, INFINITY, -INFINITY, 1e-300, -1e300 };
+	for(size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+		array_append(a, double, values[i]);
+	
+	check( array_sort(a, ARRAY_DOUBLE, 0) );
+	double expected[] = { -INFINITY, -1e300, -2.25, -0.0, 0.0, 1e-300, 1.5, INFINITY };
+	for(size_t i = 0; i < a->length; i++)
+		check(array_elem(a, double, i) == expected[i]);
+	check( signbit(array_elem(a, double, 3)) );
+	check( !signbit(array_elem(a, double, 4)) );
+	
+	array_destroy(a);
+}
+
+typedef struct {
+	uint32_t id;
+	int16_t score;
+	char name[10];
+} record_t;
+
+// Sorting by a field has to keep the order of records with equal keys
+void test_sort_by_field(){
+	array_p a = array_of(record_t);
+	for(uint32_t i = 0; i < 1000; i++)
+		array_append(a, record_t, ((record_t){ i, (int16_t)(next_random() % 50) - 25, "x" }));
+	
+	check( array_sort_by(a, record_t, score, ARRAY_INT16) );
+	size_t unstable = 0;
+	for(size_t i = 1; i < a->length; i++) {
+		record_t* prev = array_elem_ptr(a, i - 1);
+		record_t* elem = array_elem_ptr(a, i);
+		if (prev->score > elem->score || (prev->score == elem->score && prev->id > elem->id))
+			unstable++;
+	}
+	check_int(unstable, 0);
+	
+	array_destroy(a);
+}
+
+static int compare_records(const void* a, const void* b){
+	const record_t *ra = a, *rb = b;
+	return (ra->score > rb->score) - (ra->score < rb->score);
+}
+
+void test_sort_func(){
+	size_t lengths[] = { 0, 1, 2, 15, 16, 17, 100, 5000, 50000 };
+	size_t threads[] = { 0, 1, 3, 4 };
+	
+	for(size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+		for(size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+			array_p a = array_of(record_t);
+			for(uint32_t i = 0; i < lengths[l]; i++)
+				array_append(a, record_t, ((record_t){ i, (int16_t)(next_random() % 1000), "x" }));
+			
+			check( array_sort_func(a, compare_records, threads[t]) );
+			size_t unstable = 0;
+			for(size_t i = 1; i < a->length; i++) {
+				record_t* prev = array_elem_ptr(a, i - 1);
+				record_t* elem = array_elem_ptr(a, i);
+				if (prev->score > elem->score || (prev->score == elem->score && prev->id > elem->id))
+					unstable++;
+			}
+			check_int(a->length, lengths[l]);
+			check_int(unstable, 0);
+			
+			array_destroy(a);
+		}
+	}
+}
+
+void test_sort_presorted(){
+	array_p a = array_of(uint64_t);
+	for(uint64_t i = 0; i < 10000; i++)
+		array_append(a, uint64_t, 10000 - i);
+	
+	check( array_sort(a, ARRAY_UINT64, 0) );
+	check_int(array_elem(a, uint64_t, 0), 1);
+	check_int(array_elem(a, uint64_t, 9999), 10000);
+	
+	array_destroy(a);
+}
+
+
+int main(){
+	run(test_sort_ints);
+	run(test_sort_all_types);
+	run(test_sort_floats);
+	run(test_sort_by_field);
+	run(test_sort_func);
+	run(test_sort_presorted);
+	
+	return show_report();
+}
\ No newline at end of file
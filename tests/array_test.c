@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdint.h>
+#include <unistd.h>
 #include "testing.h"
 #include "../array.h"
 
@@ -171,6 +172,295 @@ void test_array_remove_func(){
 	array_destroy(a);
 }
 
+bool array_mask_is_odd(array_p array, size_t index){ return array_elem(array, uint32_t, index) % 2 == 1; }
+
+void test_array_mask_func(){
+	array_p a = array_of(uint32_t);
+	for(uint32_t i = 0; i < 70; i++)
+		array_append(a, uint32_t, i);
+	
+	uint64_t mask[2];
+	size_t odd = array_mask_func(a, array_mask_is_odd, mask);
+	check_int(odd, 35);
+	check(mask[0] == 0xaaaaaaaaaaaaaaaa);
+	check(mask[1] == 0x2a);
+	
+	array_remove_mask(a, mask);
+	check_int(a->length, 35);
+	for(size_t i = 0; i < a->length; i++)
+		check_int(array_elem(a, uint32_t, i), i * 2);
+	
+	array_destroy(a);
+}
+
+// Compares array_remove_mask() against a plain loop for different element sizes, lengths
+// and masks (runs of kept and removed elements as well as random bits)
+void test_array_remove_mask(){
+	size_t element_sizes[] = { 1, 2, 4, 8, 12, 24 };
+	size_t lengths[] = { 0, 1, 63, 64, 65, 200, 1000 };
+	uint64_t random = 42;
+	
+	for(size_t s = 0; s < sizeof(element_sizes) / sizeof(element_sizes[0]); s++) {
+		for(size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+			for(size_t pattern = 0; pattern < 4; pattern++) {
+				size_t size = element_sizes[s], length = lengths[l];
+				array_p a = array_new(length, size);
+				array_p expected = array_new(0, size);
+				uint64_t mask[1000 / 64 + 1] = { 0 };
+				
+				for(size_t i = 0; i < length * size; i++)
+					((uint8_t*)a->data)[i] = i * 7 + i / 256;
+				
+				for(size_t i = 0; i < length; i++) {
+					random = random * 6364136223846793005 + 1442695040888963407;
+					bool remove;
+					switch(pattern) {
+						case 0:  remove = (random >> 33) % 2;  break;  // random
+						case 1:  remove = (i / 100) % 2;       break;  // long runs
+						case 2:  remove = (random >> 33) % 16 == 0;  break;  // few removed
+						default: remove = true;
+					}
+					
+					if (remove)
+						mask[i / 64] |= (uint64_t)1 << (i % 64);
+					else
+						memcpy(array_append_ptr(expected), array_elem_ptr(a, i), size);
+				}
+				
+				array_remove_mask(a, mask);
+				check_int(a->length, expected->length);
+				check(a->length == 0 || memcmp(a->data, expected->data, a->length * size) == 0);
+				
+				array_destroy(a);
+				array_destroy(expected);
+			}
+		}
+	}
+}
+
+bool array_compact_is_multiple_of_3(array_p array, size_t index){ return array_elem(array, uint32_t, index) % 3 == 0; }
+
+// More elements than array_compact_threshold() evaluates in one chunk
+void test_array_compact_large(){
+	array_p a = array_of(uint32_t);
+	for(uint32_t i = 0; i < 10000; i++)
+		array_append(a, uint32_t, i);
+	
+	array_compact_threshold(a, 1, array_compact_is_multiple_of_3);
+	check_int(a->length, 6666);
+	check_int(array_elem(a, uint32_t, 0), 1);
+	check_int(array_elem(a, uint32_t, 1), 2);
+	check_int(array_elem(a, uint32_t, 2), 4);
+	check_int(array_elem(a, uint32_t, 6665), 9998);
+	
+	array_compact_threshold(a, 1, array_compact_is_multiple_of_3);
+	check_int(a->length, 6666);
+	
+	array_destroy(a);
+}
+
+static array_p array_of_range(int count){
+	array_p a = array_of(int);
+	for(int i = 0; i < count; i++)
+		array_append(a, int, i);
+	return a;
+}
+
+void test_array_slice(){
+	array_p a = array_of_range(20);
+	
+	array_view_t v = array_slice(a, 5, 10);
+	check_int(v.length, 10);
+	check_int(v.storage, ARRAY_VIEW);
+	check_int(array_elem(&v, int, 0), 5);
+	check_int(array_elem(&v, int, 9), 14);
+	
+	// Views share the data of the array
+	array_elem(&v, int, 0) = 100;
+	check_int(array_elem(a, int, 5), 100);
+	array_elem(a, int, 5) = 5;
+	
+	v = array_slice(a, 0, 0);
+	check_int(v.length, 20);
+	v = array_slice(a, 15, 0);
+	check_int(v.length, 5);
+	check_int(array_elem(&v, int, 0), 15);
+	v = array_slice(a, -1, 5);
+	check_int(v.length, 5);
+	check_int(array_elem(&v, int, 0), 15);
+	v = array_slice(a, -3, 0);
+	check_int(v.length, 18);
+	check_int(array_elem(&v, int, 17), 17);
+	
+	// Cut off at the ends
+	v = array_slice(a, 18, 10);
+	check_int(v.length, 2);
+	v = array_slice(a, 25, 0);
+	check_int(v.length, 0);
+	v = array_slice(a, -30, 5);
+	check_int(v.length, 0);
+	
+	// Views can't grow
+	v = array_slice(a, 0, 4);
+	check_null(array_append_ptr(&v));
+	check_int(v.length, 4);
+	check( !array_reserve(&v, 10) );
+	
+	array_destroy(a);
+}
+
+bool array_slice_is_odd(array_p array, size_t index){ return array_elem(array, int, index) % 2 == 1; }
+
+// Removing on a view compacts within the data of the array
+void test_array_slice_remove(){
+	array_p a = array_of_range(10);
+	
+	array_view_t v = array_slice(a, 2, 6);
+	array_remove_func(&v, array_slice_is_odd);
+	check_int(v.length, 3);
+	// The elements between the end of the view and index 8 are undefined now
+	int expected[] = { 0, 1, 2, 4, 6 };
+	for(size_t i = 0; i < 5; i++)
+		check_int(array_elem(a, int, i), expected[i]);
+	check_int(array_elem(a, int, 8), 8);
+	check_int(array_elem(a, int, 9), 9);
+	
+	array_destroy(a);
+}
+
+void test_array_copy_slice(){
+	array_p a = array_of_range(10);
+	
+	array_p c = array_copy_slice(a, -1, 3);
+	check_not_null(c);
+	check_int(c->length, 3);
+	check_int(c->storage, ARRAY_MALLOC);
+	check_int(array_elem(c, int, 0), 7);
+	check_int(array_elem(c, int, 2), 9);
+	array_append(c, int, 10);
+	check_int(c->length, 4);
+	array_destroy(c);
+	
+	c = array_copy_slice(a, 20, 0);
+	check_not_null(c);
+	check_int(c->length, 0);
+	array_destroy(c);
+	
+	array_destroy(a);
+}
+
+void test_array_remove_slice(){
+	array_p a = array_of_range(10);
+	
+	array_remove_slice(a, 2, 3);
+	check_int(a->length, 7);
+	int expected[] = { 0, 1, 5, 6, 7, 8, 9 };
+	for(size_t i = 0; i < a->length; i++)
+		check_int(array_elem(a, int, i), expected[i]);
+	
+	array_remove_slice(a, -1, 2);
+	check_int(a->length, 5);
+	check_int(array_elem(a, int, 4), 7);
+	
+	array_remove_slice(a, 10, 0);
+	check_int(a->length, 5);
+	
+	array_remove_slice(a, 0, 0);
+	check_int(a->length, 0);
+	
+	array_destroy(a);
+}
+
+bool array_find_in_is_even(array_p array, size_t index){ return array_elem(array, int, index) % 2 == 0; }
+
+void test_array_find_in(){
+	array_p a = array_of_range(10);
+	
+	check_int(array_find_in(a, array_find_in_is_even, 0, 0), 0);
+	check_int(array_find_in(a, array_find_in_is_even, 3, 0), 4);
+	check_int(array_find_in(a, array_find_in_is_even, 3, 1), -1);
+	check_int(array_find_in(a, array_find_in_is_even, -1, 0), 8);
+	check_int(array_find_in(a, array_find_in_is_even, -3, 5), 6);
+	check_int(array_find_in(a, array_find_in_is_even, -1, 1), -1);
+	check_int(array_find_in(a, array_find_in_is_even, 10, 0), -1);
+	
+	array_destroy(a);
+}
+
+void test_array_append_n(){
+	array_p a = array_of(int);
+	int values[] = { 1, 2, 3, 4, 5 };
+	
+	int* appended = array_append_n(a, values, 5);
+	check(appended == array_data(a, int));
+	appended = array_append_n(a, values, 3);
+	check(appended == array_data(a, int) + 5);
+	check_int(a->length, 8);
+	check_int(a->reallocs, 2);
+	check_int(array_elem(a, int, 7), 3);
+	
+	// Uninitialized and empty appends
+	check_not_null(array_append_n(a, NULL, 2));
+	check_int(a->length, 10);
+	check_not_null(array_append_n(a, values, 0));
+	check_int(a->length, 10);
+	
+	array_destroy(a);
+}
+
+void test_array_insert_n(){
+	array_p a = array_of_range(5);
+	int values[] = { 10, 11, 12 };
+	
+	check_not_null(array_insert_n(a, 2, values, 3));
+	int expected[] = { 0, 1, 10, 11, 12, 2, 3, 4 };
+	check_int(a->length, 8);
+	for(size_t i = 0; i < a->length; i++)
+		check_int(array_elem(a, int, i), expected[i]);
+	
+	check_not_null(array_insert_n(a, 0, values, 1));
+	check_int(array_elem(a, int, 0), 10);
+	check_not_null(array_insert_n(a, a->length, values + 2, 1));
+	check_int(array_elem(a, int, 9), 12);
+	check_null(array_insert_n(a, 20, values, 1));
+	check_int(a->length, 10);
+	
+	array_destroy(a);
+}
+
+void test_array_remove_indices(){
+	array_p a = array_of_range(10);
+	
+	size_t indices[] = { 0, 3, 4, 4, 9, 12 };
+	array_remove_indices(a, indices, 6);
+	int expected[] = { 1, 2, 5, 6, 7, 8 };
+	check_int(a->length, 6);
+	for(size_t i = 0; i < a->length; i++)
+		check_int(array_elem(a, int, i), expected[i]);
+	
+	array_remove_indices(a, indices, 0);
+	check_int(a->length, 6);
+	
+	array_destroy(a);
+}
+
+void test_array_swap_remove(){
+	array_p a = array_of_range(5);
+	
+	array_swap_remove(a, 1);
+	check_int(a->length, 4);
+	check_int(array_elem(a, int, 1), 4);
+	
+	array_swap_remove(a, 3);
+	check_int(a->length, 3);
+	check_int(array_elem(a, int, 2), 2);
+	
+	array_swap_remove(a, 3);
+	check_int(a->length, 3);
+	
+	array_destroy(a);
+}
+
 typedef struct {
 	int a, b, c;
 } stuff_t, *stuff_p;
@@ -215,6 +505,249 @@ void test_array_elem_ptr(){
 	array_destroy(a);
 }
 
+void test_array_reserve_and_shrink_to_fit(){
+	array_p a = array_of(int);
+	
+	check( array_reserve(a, 100) );
+	check_int(a->capacity, 100);
+	check_int(a->length, 0);
+	// Reserving less never shrinks
+	check( array_reserve(a, 10) );
+	check_int(a->capacity, 100);
+	
+	// Appending within the reserved capacity doesn't move the data
+	void* data = a->data;
+	for(int i = 0; i < 100; i++)
+		array_append(a, int, i);
+	check(a->data == data);
+	
+	array_resize(a, 30);
+	check_int(a->capacity, 100);
+	check( array_shrink_to_fit(a) );
+	check_int(a->capacity, 30);
+	check_int(array_elem(a, int, 29), 29);
+	
+	array_resize(a, 0);
+	check( array_shrink_to_fit(a) );
+	check_int(a->capacity, 0);
+	array_append(a, int, 7);
+	check_int(array_elem(a, int, 0), 7);
+	
+	array_destroy(a);
+}
+
+void test_array_mmap(){
+	array_p a = array_of_mmap(int);
+	check_int(a->storage, ARRAY_MMAP);
+	check_int(a->capacity, 0);
+	
+	// The capacity is always a multiple of the page size
+	size_t page_size = sysconf(_SC_PAGESIZE);
+	array_append(a, int, 0);
+	check(a->capacity >= page_size / sizeof(int) && (a->capacity * sizeof(int)) % page_size == 0);
+	
+	for(int i = 1; i < 100000; i++)
+		array_append(a, int, i);
+	check_int(a->length, 100000);
+	size_t mismatches = 0;
+	for(int i = 0; i < 100000; i++)
+		mismatches += (array_elem(a, int, i) != i);
+	check_int(mismatches, 0);
+	
+	check( array_reserve(a, 1000000) );
+	check(a->capacity >= 1000000);
+	check_int(array_elem(a, int, 99999), 99999);
+	
+	array_resize(a, 5000);
+	check( array_shrink_to_fit(a) );
+	check(a->capacity >= 5000 && a->capacity < 5000 + page_size / sizeof(int));
+	check_int(array_elem(a, int, 4999), 4999);
+	
+	array_destroy(a);
+	
+	array_p b = array_new_mmap(10, sizeof(double));
+	check_int(b->length, 10);
+	check(b->capacity >= 10);
+	array_destroy(b);
+}
+
+#define ARRAY_TEST_FILE  "/tmp/array_test_open_mmap.bin"
+
+static bool is_77777(array_p array, size_t index){
+	return array_elem(array, int, index) == 77777;
+}
+
+static long file_size(const char* path){
+	FILE* f = fopen(path, "rb");
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f);
+	fclose(f);
+	return size;
+}
+
+void test_array_open_mmap(){
+	array_p a = array_open_mmap(ARRAY_TEST_FILE, sizeof(int), ARRAY_FILE_TRUNCATE);
+	check_not_null(a);
+	check_int(a->storage, ARRAY_FILE);
+	check_int(a->length, 0);
+	
+	check( array_advise(a, ARRAY_ADVICE_SEQUENTIAL) );
+	for(int i = 0; i < 100000; i++)
+		array_append(a, int, i);
+	size_t page_size = sysconf(_SC_PAGESIZE);
+	check(a->capacity >= 100000 && (a->capacity * sizeof(int)) % page_size == 0);
+	check( array_flush(a) );
+	check( array_advise(a, ARRAY_ADVICE_DONTNEED) );
+	check_int(array_elem(a, int, 77777), 77777);
+	array_destroy(a);
+	// The unused capacity is cut off again
+	check_int(file_size(ARRAY_TEST_FILE), 100000 * sizeof(int));
+	
+	// Read only, the array can't grow
+	array_p b = array_open_mmap(ARRAY_TEST_FILE, sizeof(int), ARRAY_FILE_READ);
+	check_not_null(b);
+	check_int(b->length, 100000);
+	check_int(array_find(b, is_77777), 77777);
+	check( array_advise(b, ARRAY_ADVICE_RANDOM) );
+	check( !array_reserve(b, 200000) );
+	array_destroy(b);
+	
+	// Keeps the contents, removing elements shrinks the file
+	array_p c = array_open_mmap(ARRAY_TEST_FILE, sizeof(int), ARRAY_FILE_WRITE);
+	check_int(c->length, 100000);
+	array_remove_slice(c, 0, 90000);
+	check_int(c->length, 10000);
+	check_int(array_elem(c, int, 0), 90000);
+	check( array_shrink_to_fit(c) );
+	check_int(array_elem(c, int, 9999), 99999);
+	array_destroy(c);
+	check_int(file_size(ARRAY_TEST_FILE), 10000 * sizeof(int));
+	
+	// Other storage can't be advised and has nothing to flush
+	array_p d = array_of(int);
+	check( !array_advise(d, ARRAY_ADVICE_WILLNEED) );
+	check( array_flush(d) );
+	array_destroy(d);
+	
+	check_null(array_open_mmap("/nonexistent/array", sizeof(int), ARRAY_FILE_READ));
+	remove(ARRAY_TEST_FILE);
+}
+
+void test_array_policy(){
+	array_p a = array_of(int);
+	array_set_policy(a, 1.5, 0, 0);
+	
+	// Grows by at least one element while 1.5 times the capacity rounds down to it
+	size_t capacities[] = { 1, 2, 3, 4, 6, 9, 13, 19 };
+	for(size_t i = 0; i < sizeof(capacities) / sizeof(capacities[0]); i++) {
+		array_resize(a, capacities[i]);
+		check_int(a->capacity, capacities[i]);
+	}
+	check_int(a->reallocs, 8);
+	
+	// Never shrinks with a threshold of 0
+	array_resize(a, 0);
+	check_int(a->capacity, 19);
+	check_int(a->reallocs, 8);
+	
+	array_destroy(a);
+	
+	// The capacity stays above the minimum
+	array_p b = array_of(int);
+	array_set_policy(b, 2, 0.25, 16);
+	array_append(b, int, 1);
+	check_int(b->capacity, 16);
+	array_resize(b, 100);
+	check_int(b->capacity, 128);
+	array_resize(b, 0);
+	check_int(b->capacity, 16);
+	
+	array_destroy(b);
+	
+	// Thresholds above 0.5 are clamped, the capacity never drops below the length
+	array_p c = array_of(int);
+	array_set_policy(c, 2, 0.9, 0);
+	check(c->shrink_threshold == 0.5);
+	for(int i = 0; i < 100; i++)
+		array_append(c, int, i);
+	array_resize(c, 80);
+	check_int(c->length, 80);
+	check(c->capacity >= c->length);
+	array_resize(c, 50);
+	check_int(c->capacity, 64);
+	for(int i = 0; i < 50; i++)
+		check_int(array_elem(c, int, i), i);
+	
+	array_destroy(c);
+}
+
+void test_array_realloc_counters(){
+	array_p a = array_of(int);
+	check_int(a->reallocs, 0);
+	check_int(a->bytes_copied, 0);
+	
+	for(int i = 0; i < 1000; i++)
+		array_append(a, int, i);
+	// 0 -> 1 -> 2 -> 4 -> ... -> 1024
+	check_int(a->reallocs, 11);
+	check(a->bytes_copied <= 1023 * sizeof(int));
+	
+	array_destroy(a);
+	
+	// Remapped pages are not counted as copied
+	array_p b = array_of_mmap(int);
+	for(int i = 0; i < 100000; i++)
+		array_append(b, int, i);
+	check(b->reallocs > 0);
+	check_int(b->bytes_copied, 0);
+	array_destroy(b);
+}
+
+void test_array_inline(){
+	array_p a = array_of_inline(int, 8);
+	check_int(a->storage, ARRAY_INLINE);
+	check_int(a->length, 0);
+	check_int(a->capacity, 8);
+	// The elements are stored in the same memory block right after the array_t
+	check((char*)a->data >= (char*)(a + 1) && (char*)a->data < (char*)(a + 1) + 16);
+	
+	for(int i = 0; i < 8; i++)
+		array_append(a, int, i);
+	check_int(a->storage, ARRAY_INLINE);
+	check_int(a->reallocs, 0);
+	
+	// Outgrowing the inline storage moves the elements into their own block
+	array_append(a, int, 8);
+	check_int(a->storage, ARRAY_MALLOC);
+	check_int(a->capacity, 16);
+	check_int(a->reallocs, 1);
+	check_int(a->bytes_copied, 8 * sizeof(int));
+	for(int i = 0; i < 9; i++)
+		check_int(array_elem(a, int, i), i);
+	
+	array_destroy(a);
+	
+	// Removing elements from inline arrays doesn't reallocate
+	array_p b = array_of_inline(int, 4);
+	array_append(b, int, 1);
+	array_append(b, int, 2);
+	array_remove(b, 0);
+	check_int(b->length, 1);
+	check_int(array_elem(b, int, 0), 2);
+	check_int(b->storage, ARRAY_INLINE);
+	array_destroy(b);
+}
+
+void test_array_of_without_data(){
+	array_p a = array_of(int);
+	// Empty arrays don't allocate any data until the first append
+	check_null(a->data);
+	check_int(a->capacity, 0);
+	array_append(a, int, 1);
+	check_not_null(a->data);
+	array_destroy(a);
+}
+
 // Only test the features requireing GNU extention when we're compiling in GNU C mode
 #ifndef __STRICT_ANSI__
 
@@ -300,8 +833,27 @@ int main(){
 	run(test_array_find);
 	run(test_array_remove);
 	run(test_array_remove_func);
+	run(test_array_mask_func);
+	run(test_array_remove_mask);
+	run(test_array_compact_large);
+	run(test_array_slice);
+	run(test_array_slice_remove);
+	run(test_array_copy_slice);
+	run(test_array_remove_slice);
+	run(test_array_find_in);
+	run(test_array_append_n);
+	run(test_array_insert_n);
+	run(test_array_remove_indices);
+	run(test_array_swap_remove);
 	run(test_array_append_ptr);
 	run(test_array_elem_ptr);
+	run(test_array_reserve_and_shrink_to_fit);
+	run(test_array_mmap);
+	run(test_array_open_mmap);
+	run(test_array_policy);
+	run(test_array_realloc_counters);
+	run(test_array_inline);
+	run(test_array_of_without_data);
 	
 #	ifndef __STRICT_ANSI__
 	run(test_array_find_val);
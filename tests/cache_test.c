@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include "testing.h"
+#include "../cache.h"
+
+void test_alloc(){
+	cache_p c = cache_of(10, float, CACHE_LRU);
+	
+	check_not_null(c);
+	check_not_null(c->dict);
+	check_int(c->max_length, 10);
+	check_int(c->value_size, sizeof(float));
+	check(c->dict->capacity > 10);
+	check_null(c->head);
+	check_null(c->tail);
+	
+	cache_destroy(c);
+}
+
+void test_put_and_get(){
+	cache_p c = cache_of(10, int, CACHE_LRU);
+	
+	cache_put(c, "foo", int, 1);
+	cache_put(c, "bar", int, 2);
+	check_int(c->dict->length, 2);
+	check_int(c->inserts, 2);
+	
+	// check_int() evaluates its arguments twice, so read the values first
+	int foo = cache_get(c, "foo", int), bar = cache_get(c, "bar", int);
+	void* baz = cache_get_ptr(c, "baz");
+	check_int(foo, 1);
+	check_int(bar, 2);
+	check_null(baz);
+	check_int(c->hits, 2);
+	check_int(c->misses, 1);
+	check_float(cache_hit_ratio(c), 2.0 / 3.0, 0.001);
+	
+	// Overwriting doesn't insert a new entry
+	cache_put(c, "foo", int, 3);
+	check_int(c->dict->length, 2);
+	check_int( cache_get(c, "foo", int), 3 );
+	
+	cache_remove(c, "foo");
+	check_int(c->dict->length, 1);
+	check( !cache_contains(c, "foo") );
+	check( cache_contains(c, "bar") );
+	
+	cache_destroy(c);
+}
+
+void test_lru_eviction(){
+	cache_p c = cache_of(3, int, CACHE_LRU);
+	
+	cache_put(c, "a", int, 1);
+	cache_put(c, "b", int, 2);
+	cache_put(c, "c", int, 3);
+	
+	// Use "a" so "b" is the least recently used entry
+	cache_get_ptr(c, "a");
+	cache_put(c, "d", int, 4);
+	check_int(c->dict->length, 3);
+	check_int(c->evictions, 1);
+	check( cache_contains(c, "a") );
+	check( !cache_contains(c, "b") );
+	check( cache_contains(c, "c") );
+	check( cache_contains(c, "d") );
+	
+	cache_put(c, "e", int, 5);
+	check( !cache_contains(c, "c") );
+	
+	cache_destroy(c);
+}
+
+void test_sieve_eviction(){
+	cache_p c = cache_of(3, int, CACHE_SIEVE);
+	
+	cache_put(c, "a", int, 1);
+	cache_put(c, "b", int, 2);
+	cache_put(c, "c", int, 3);
+	
+	// "a" is visited so the hand skips it and evicts "b"
+	cache_get_ptr(c, "a");
+	cache_put(c, "d", int, 4);
+	check( cache_contains(c, "a") );
+	check( !cache_contains(c, "b") );
+	check( cache_contains(c, "c") );
+	check( cache_contains(c, "d") );
+	
+	// The hand continues at "c" which wasn't visited
+	cache_put(c, "e", int, 5);
+	check( cache_contains(c, "a") );
+	check( !cache_contains(c, "c") );
+	
+	cache_destroy(c);
+}
+
+size_t evicted_sum = 0;
+void evict_counter(const char* key, void* value, void* context){
+	(void)key;
+	evicted_sum += *(int*)value;
+	(*(size_t*)context)++;
+}
+
+void test_evict_callback(){
+	size_t evict_calls = 0;
+	evicted_sum = 0;
+	cache_p c = cache_of(2, int, CACHE_LRU);
+	cache_on_evict(c, evict_counter, &evict_calls);
+	
+	cache_put(c, "a", int, 1);
+	cache_put(c, "b", int, 2);
+	cache_put(c, "c", int, 4);
+	check_int(evict_calls, 1);
+	check_int(evicted_sum, 1);
+	
+	// Destroy calls the callback for the remaining entries
+	cache_destroy(c);
+	check_int(evict_calls, 3);
+	check_int(evicted_sum, 7);
+}
+
+/**
+ * Many evictions leave deleted slots behind. The cache has to rebuild its dict from
+ * time to time and keep the recency order intact. The rebuilds only swap the dict with
+ * the spare dict and never allocate a new one.
+ */
+void test_many_evictions(){
+	char keys[1000][8];
+	cache_p c = cache_of(10, int, CACHE_LRU);
+	dict_p dict = c->dict, spare = c->spare;
+	
+	for(int i = 0; i < 1000; i++) {
+		snprintf(keys[i], sizeof(keys[i]), "%d", i);
+		cache_put(c, keys[i], int, i);
+		check(c->dict->length <= 10);
+		check(c->dict->length + c->deleted_slots <= c->dict->capacity);
+		check( (c->dict == dict && c->spare == spare) || (c->dict == spare && c->spare == dict) );
+	}
+	
+	check_int(c->dict->length, 10);
+	check_int(c->evictions, 990);
+	size_t capacity = c->dict->capacity;
+	
+	for(int i = 0; i < 1000; i++)
+		check( cache_contains(c, keys[i]) == (i >= 990) );
+	
+	// The recency order survived the rebuilds, "990" is the least recently used entry
+	cache_get_ptr(c, keys[991]);
+	cache_put(c, "new", int, 0);
+	check( !cache_contains(c, keys[990]) );
+	check( cache_contains(c, keys[991]) );
+	check_int(c->dict->capacity, capacity);
+	
+	cache_destroy(c);
+}
+
+/**
+ * Puts that reuse a deleted slot have to lower the deleted slot count again, otherwise
+ * it only grows and the cache rebuilds far too often.
+ */
+void test_deleted_slots(){
+	cache_p c = cache_of(100, int, CACHE_LRU);
+	
+	cache_put(c, "a", int, 1);
+	cache_remove(c, "a");
+	check_int(c->deleted_slots, 1);
+	
+	// Same key, same probe sequence, so it lands in the deleted slot
+	cache_put(c, "a", int, 2);
+	check_int(c->deleted_slots, 0);
+	check_int(cache_get(c, "a", int), 2);
+	
+	cache_destroy(c);
+}
+
+void test_length_for_budget(){
+	size_t length = cache_length_for_budget(1024 * 1024, sizeof(int));
+	// Two slot arrays with about 48 bytes per slot
+	check(length > 5000);
+	check(length < 1024 * 1024 / sizeof(int));
+	check_int(cache_length_for_budget(0, sizeof(int)), 0);
+}
+
+
+int main(){
+	run(test_alloc);
+	run(test_put_and_get);
+	run(test_lru_eviction);
+	run(test_sieve_eviction);
+	run(test_evict_callback);
+	run(test_many_evictions);
+	run(test_deleted_slots);
+	run(test_length_for_budget);
+	
+	return show_report();
+}
\ No newline at end of file
@@ -0,0 +1,179 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include "testing.h"
+#include "../delta_array.h"
+
+static delta_array_p delta_array_from(const int64_t* values, size_t n){
+	delta_array_p a = delta_array_new();
+	check( delta_array_append_n(a, values, n) );
+	return a;
+}
+
+static void check_round_trip(delta_array_p a, const int64_t* values, size_t n){
+	check_int(a->length, n);
+	check_int(delta_array_block_count(a), (n + DELTA_ARRAY_BLOCK - 1) / DELTA_ARRAY_BLOCK);
+	
+	int64_t decoded[DELTA_ARRAY_BLOCK];
+	size_t index = 0;
+	for(size_t b = 0; b < delta_array_block_count(a); b++) {
+		size_t count = delta_array_decode_block(a, b, decoded);
+		for(size_t i = 0; i < count; i++) {
+			int64_t value = delta_array_get(a, index);
+			check(decoded[i] == values[index]);
+			check(value == values[index]);
+			
+			// Finds the first occurrence, also in unsorted and wide blocks
+			if (index % 16 == 0) {
+				ssize_t found = delta_array_find(a, values[index]);
+				check(found >= 0 && (size_t)found <= index && values[found] == values[index]);
+			}
+			index++;
+		}
+	}
+	check_int(index, n);
+}
+
+void test_new(){
+	delta_array_p a = delta_array_new();
+	check_not_null(a);
+	check_int(a->length, 0);
+	check_int(delta_array_block_count(a), 0);
+	check_int(delta_array_find(a, 0), -1);
+	check_int(delta_array_lower_bound(a, 0), 0);
+	delta_array_destroy(a);
+}
+
+void test_sorted(){
+	size_t n = 10000;
+	int64_t* values = malloc(n * sizeof(int64_t));
+	int64_t value = -5000;
+	for(size_t i = 0; i < n; i++) {
+		value += 1 + i % 7 + (i % 1000 == 0 ? 3000 : 0);
+		values[i] = value;
+	}
+	
+	// Append in uneven pieces so full blocks are built from pending and from the input
+	delta_array_p a = delta_array_new();
+	size_t appended = 0;
+	for(size_t piece = 1; appended < n; piece = piece * 3 % 301) {
+		size_t count = (n - appended < piece) ? n - appended : piece;
+		check( delta_array_append_n(a, values + appended, count) );
+		appended += count;
+	}
+	check_round_trip(a, values, n);
+	
+	// Small gaps take a lot less than 64 bits per value
+	check(delta_array_memory(a) < n * sizeof(int64_t) / 3);
+	
+	delta_array_destroy(a);
+	free(values);
+}
+
+void test_constant_and_dense(){
+	int64_t values[1000];
+	for(size_t i = 0; i < 1000; i++)
+		values[i] = 42;
+	delta_array_p a = delta_array_from(values, 1000);
+	check_round_trip(a, values, 1000);
+	check_int(a->packed->length, 0);
+	delta_array_destroy(a);
+	
+	for(size_t i = 0; i < 1000; i++)
+		values[i] = 100 + 3 * i;
+	a = delta_array_from(values, 1000);
+	check_round_trip(a, values, 1000);
+	check_int(a->packed->length, 0);
+	delta_array_destroy(a);
+}
+
+void test_unsorted_and_extreme(){
+	size_t n = 1000;
+	int64_t values[1000];
+	srand(1);
+	for(size_t i = 0; i < n; i++)
+		values[i] = rand() % 2000 - 1000;
+	delta_array_p a = delta_array_from(values, n);
+	check_round_trip(a, values, n);
+	delta_array_destroy(a);
+	
+	// Deltas that need more than 32 bits and overflow when computed as signed numbers
+	for(size_t i = 0; i < n; i++) {
+		switch (i % 4) {
+			case 0:  values[i] = INT64_MIN;                           break;
+			case 1:  values[i] = INT64_MAX;                           break;
+			case 2:  values[i] = ((int64_t)rand() << 32) ^ rand();    break;
+			default: values[i] = -(int64_t)i;                         break;
+		}
+	}
+	a = delta_array_from(values, n);
+	check_round_trip(a, values, n);
+	delta_array_destroy(a);
+	
+	// Every width from 0 to 64 bits
+	for(size_t bits = 0; bits <= 64; bits++) {
+		for(size_t i = 0; i < DELTA_ARRAY_BLOCK; i++)
+			values[i] = (bits == 0 || i % 2 == 0) ? 0 : (int64_t)(UINT64_MAX >> (64 - bits));
+		a = delta_array_from(values, DELTA_ARRAY_BLOCK);
+		check_round_trip(a, values, DELTA_ARRAY_BLOCK);
+		delta_array_destroy(a);
+	}
+}
+
+void test_partial_block(){
+	int64_t values[DELTA_ARRAY_BLOCK + 5];
+	for(size_t i = 0; i < DELTA_ARRAY_BLOCK + 5; i++)
+		values[i] = i * i;
+	
+	delta_array_p a = delta_array_new();
+	for(size_t i = 0; i < 5; i++)
+		check( delta_array_append(a, values[i]) );
+	check_int(a->blocks->length, 0);
+	check_int(a->pending_length, 5);
+	check_round_trip(a, values, 5);
+	
+	check( delta_array_append_n(a, values + 5, DELTA_ARRAY_BLOCK) );
+	check_int(a->blocks->length, 1);
+	check_int(a->pending_length, 5);
+	check_round_trip(a, values, DELTA_ARRAY_BLOCK + 5);
+	delta_array_destroy(a);
+}
+
+void test_find_and_lower_bound(){
+	size_t n = 1000;
+	int64_t values[1000];
+	for(size_t i = 0; i < n; i++)
+		values[i] = (int64_t)(i / 3) * 10 - 2000;
+	delta_array_p a = delta_array_from(values, n);
+	
+	for(int64_t value = -2050; value < 1400; value += 1) {
+		ssize_t expected_index = -1;
+		size_t expected_bound = n;
+		for(size_t i = 0; i < n; i++) {
+			if (expected_index == -1 && values[i] == value)
+				expected_index = i;
+			if (values[i] >= value) {
+				expected_bound = i;
+				break;
+			}
+		}
+		
+		ssize_t index = delta_array_find(a, value);
+		size_t bound = delta_array_lower_bound(a, value);
+		check_int(index, expected_index);
+		check_int(bound, expected_bound);
+	}
+	
+	delta_array_destroy(a);
+}
+
+
+int main(){
+	run(test_new);
+	run(test_sorted);
+	run(test_constant_and_dense);
+	run(test_unsorted_and_extreme);
+	run(test_partial_block);
+	run(test_find_and_lower_bound);
+	
+	return show_report();
+}
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include "testing.h"
+#include "../deque.h"
+
+void test_new(){
+	deque_p d = deque_of(int);
+	check_not_null(d);
+	check_int(d->length, 0);
+	check_int(d->buffer->capacity, 0);
+	check_null(deque_pop_front_ptr(d));
+	check_null(deque_pop_back_ptr(d));
+	deque_destroy(d);
+}
+
+void test_fifo(){
+	deque_p d = deque_of(int);
+	for(int i = 0; i < 100; i++)
+		deque_push_back(d, int, i);
+	check_int(d->length, 100);
+	check_int(d->buffer->capacity, 128);
+	
+	for(int i = 0; i < 100; i++) {
+		int value = deque_pop_front(d, int);
+		check_int(value, i);
+	}
+	check_int(d->length, 0);
+	
+	deque_destroy(d);
+}
+
+void test_both_ends(){
+	deque_p d = deque_of(int);
+	for(int i = 1; i <= 5; i++) {
+		deque_push_back(d, int, i);
+		deque_push_front(d, int, -i);
+	}
+	
+	int expected[] = { -5, -4, -3, -2, -1, 1, 2, 3, 4, 5 };
+	check_int(d->length, 10);
+	for(size_t i = 0; i < d->length; i++)
+		check_int(deque_elem(d, int, i), expected[i]);
+	
+	int back = deque_pop_back(d, int), front = deque_pop_front(d, int);
+	check_int(back, 5);
+	check_int(front, -5);
+	check_int(d->length, 8);
+	
+	deque_destroy(d);
+}
+
+// Keeps the deque at the same length while the head wanders around the buffer
+void test_wrap_around(){
+	deque_p d = deque_of(int);
+	for(int i = 0; i < 6; i++)
+		deque_push_back(d, int, i);
+	
+	for(int i = 6; i < 1000; i++) {
+		int value = deque_pop_front(d, int);
+		check_int(value, i - 6);
+		deque_push_back(d, int, i);
+	}
+	check_int(d->buffer->capacity, 8);
+	for(size_t i = 0; i < d->length; i++)
+		check_int(deque_elem(d, int, i), 994 + (int)i);
+	
+	deque_destroy(d);
+}
+
+// Growing a wrapped buffer has to move either the head or the wrapped part
+void test_grow_wrapped(){
+	for(int pushed_front = 0; pushed_front <= 8; pushed_front++) {
+		deque_p d = deque_of(int);
+		for(int i = 0; i < 8 - pushed_front; i++)
+			deque_push_back(d, int, i);
+		for(int i = 0; i < pushed_front; i++)
+			deque_push_front(d, int, -1 - i);
+		check_int(d->buffer->capacity, 8);
+		
+		deque_push_back(d, int, 100);
+		check_int(d->buffer->capacity, 16);
+		check_int(d->length, 9);
+		for(int i = 0; i < pushed_front; i++)
+			check_int(deque_elem(d, int, i), i - pushed_front);
+		for(int i = pushed_front; i < 8; i++)
+			check_int(deque_elem(d, int, i), i - pushed_front);
+		check_int(deque_elem(d, int, 8), 100);
+		
+		deque_destroy(d);
+	}
+}
+
+void test_reserve(){
+	deque_p d = deque_of(int);
+	check( deque_reserve(d, 100) );
+	check_int(d->buffer->capacity, 128);
+	check( deque_reserve(d, 10) );
+	check_int(d->buffer->capacity, 128);
+	deque_destroy(d);
+}
+
+void test_views(){
+	deque_p d = deque_of(int);
+	array_view_t first, second;
+	check_int(deque_views(d, &first, &second), 0);
+	check_int(first.length, 0);
+	check_int(second.length, 0);
+	
+	for(int i = 0; i < 8; i++)
+		deque_push_back(d, int, i);
+	deque_pop_front_n(d, 5);
+	for(int i = 8; i < 12; i++)
+		deque_push_back(d, int, i);
+	
+	// Elements 5, 6, 7 at the end of the buffer, 8 to 11 wrapped around to the start
+	check_int(deque_views(d, &first, &second), 7);
+	check_int(first.length, 3);
+	check_int(second.length, 4);
+	check_int(array_elem(&first, int, 0), 5);
+	check_int(array_elem(&second, int, 0), 8);
+	check_int(array_elem(&second, int, 3), 11);
+	
+	deque_pop_front_n(d, first.length + second.length);
+	check_int(d->length, 0);
+	deque_push_back(d, int, 12);
+	check_int(deque_views(d, &first, &second), 1);
+	check_int(first.length, 1);
+	check_int(second.length, 0);
+	check_int(array_elem(&first, int, 0), 12);
+	
+	deque_pop_back_n(d, 10);
+	check_int(d->length, 0);
+	
+	deque_destroy(d);
+}
+
+
+int main(){
+	run(test_new);
+	run(test_fifo);
+	run(test_both_ends);
+	run(test_wrap_around);
+	run(test_grow_wrapped);
+	run(test_reserve);
+	run(test_views);
+	
+	return show_report();
+}
\ No newline at end of file
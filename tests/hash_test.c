@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include "testing.h"
 #include "../hash.h"
 
@@ -322,6 +323,361 @@ void test_hash_get_ptr_bug0(){
 	hash_destroy(element_infos);
 }
 
+void test_get_and_put_elem(){
+	dict_p d = dict_of(int);
+	
+	dict_elem_t e = dict_put_elem(d, "foo");
+	check_not_null(e);
+	check_str(dict_key(e), "foo");
+	dict_value(e, int) = 7;
+	check_int(d->length, 1);
+	
+	check( dict_get_elem(d, "foo") == e );
+	check( dict_put_elem(d, "foo") == e );
+	check_null( dict_get_elem(d, "bar") );
+	check_int(d->length, 1);
+	check_int( dict_get(d, "foo", int), 7 );
+	
+	dict_destroy(d);
+}
+
+void test_put_elem_tracked_and_clear(){
+	hash_p h = hash_with(11, int);
+	bool reused_deleted = true;
+	
+	hash_elem_t e = hash_put_elem_tracked(h, 3, &reused_deleted);
+	check( !reused_deleted );
+	hash_remove_elem(h, e);
+	
+	// Key 3 finds its old slot marked as deleted first
+	check( hash_put_elem_tracked(h, 3, &reused_deleted) == e );
+	check( reused_deleted );
+	// Existing keys don't use a new slot at all
+	hash_put_elem_tracked(h, 3, &reused_deleted);
+	check( !reused_deleted );
+	
+	hash_remove_elem(h, e);
+	hash_put(h, 4, int, 4);
+	hash_clear(h);
+	check_int(h->length, 0);
+	check_int(h->capacity, 11);
+	check( !hash_contains(h, 4) );
+	check_null( hash_start(h) );
+	
+	// Clearing also dropped the deleted slot
+	hash_put_elem_tracked(h, 3, &reused_deleted);
+	check( !reused_deleted );
+	
+	hash_destroy(h);
+}
+
+void test_multi_put_and_get(){
+	multi_hash_p m = hash_multi_of(int);
+	check_not_null(m);
+	check_int(m->value_size, sizeof(int));
+	
+	for(int i = 0; i < 10; i++)
+		hash_multi_put(m, 7, int, i);
+	hash_multi_put(m, 8, int, 100);
+	check_int(m->length, 11);
+	check_int(m->keys->length, 2);
+	
+	size_t count = 0;
+	int* values = hash_multi_get(m, 7, &count);
+	check_int(count, 10);
+	for(int i = 0; i < 10; i++)
+		check_int(values[i], i);
+	
+	values = hash_multi_get(m, 8, &count);
+	check_int(count, 1);
+	check_int(values[0], 100);
+	
+	values = hash_multi_get(m, 9, &count);
+	check_null(values);
+	check_int(count, 0);
+	check_int(hash_multi_count(m, 7), 10);
+	check_int(hash_multi_count(m, 9), 0);
+	
+	hash_multi_destroy(m);
+}
+
+void test_multi_remove(){
+	multi_dict_p m = dict_multi_of(int);
+	dict_multi_put(m, "foo", int, 1);
+	dict_multi_put(m, "foo", int, 2);
+	dict_multi_put(m, "foo", int, 3);
+	dict_multi_put(m, "bar", int, 4);
+	check_int(m->length, 4);
+	
+	// Removing one value keeps the order of the others
+	dict_multi_remove_one(m, "foo", 0);
+	size_t count = 0;
+	int* values = dict_multi_get(m, "foo", &count);
+	check_int(count, 2);
+	check_int(values[0], 2);
+	check_int(values[1], 3);
+	check_int(m->length, 3);
+	
+	// Removing the last value removes the key
+	dict_multi_remove_one(m, "bar", 0);
+	check( !dict_contains(m->keys, "bar") );
+	check_int(m->length, 2);
+	
+	dict_multi_remove_all(m, "foo");
+	check_int(m->length, 0);
+	check_int(m->keys->length, 0);
+	check_int(dict_multi_count(m, "foo"), 0);
+	
+	dict_multi_destroy(m);
+}
+
+void test_multi_iteration(){
+	multi_hash_p m = hash_multi_of(int);
+	hash_multi_put(m, 1, int, 10);
+	hash_multi_put(m, 2, int, 20);
+	hash_multi_put(m, 2, int, 21);
+	
+	size_t keys = 0, values = 0;
+	int sum = 0;
+	for(hash_elem_t e = hash_start(m->keys); e != NULL; e = hash_next(m->keys, e)) {
+		size_t count = 0;
+		int* v = hash_multi_values(e, &count);
+		for(size_t i = 0; i < count; i++)
+			sum += v[i];
+		values += count;
+		keys++;
+	}
+	
+	check_int(keys, 2);
+	check_int(values, 3);
+	check_int(sum, 51);
+	
+	hash_multi_destroy(m);
+}
+
+void sum_combine(void* dest_value, const void* src_value){
+	*(int*)dest_value += *(const int*)src_value;
+}
+
+void test_merge(){
+	hash_p a = hash_of(int);
+	hash_p b = hash_of(int);
+	for(int i = 0; i < 100; i++)
+		hash_put(a, i, int, 1);
+	for(int i = 50; i < 150; i++)
+		hash_put(b, i, int, 2);
+	
+	hash_merge(a, b, sum_combine);
+	check_int(a->length, 150);
+	check_int(b->length, 100);
+	check(a->length <= a->capacity * 0.75);
+	for(int i = 0; i < 150; i++) {
+		int value = hash_get(a, i, int);
+		check_int(value, (i < 50) ? 1 : (i < 100) ? 3 : 2);
+	}
+	
+	// Without combine function the source values overwrite the destination values
+	hash_put(b, 0, int, 7);
+	hash_merge(a, b, NULL);
+	check_int(a->length, 150);
+	check_int(hash_get(a, 0, int), 7);
+	check_int(hash_get(a, 60, int), 2);
+	
+	hash_destroy(a);
+	hash_destroy(b);
+}
+
+void test_intersect_and_difference(){
+	dict_p a = dict_of(int);
+	dict_p b = dict_of(int);
+	dict_put(a, "foo", int, 1);
+	dict_put(a, "bar", int, 2);
+	dict_put(a, "baz", int, 3);
+	dict_put(b, "bar", int, 10);
+	dict_put(b, "baz", int, 20);
+	dict_put(b, "qux", int, 30);
+	
+	dict_p c = dict_copy(a);
+	
+	dict_intersect(a, b, sum_combine);
+	check_int(a->length, 2);
+	check( !dict_contains(a, "foo") );
+	check_int( dict_get(a, "bar", int), 12 );
+	check_int( dict_get(a, "baz", int), 23 );
+	
+	dict_difference(c, b);
+	check_int(c->length, 1);
+	check_int( dict_get(c, "foo", int), 1 );
+	
+	// Difference where the other dict is the smaller one
+	dict_put(c, "a", int, 0);
+	dict_put(c, "b", int, 0);
+	dict_put(c, "c", int, 0);
+	dict_p d = dict_of(int);
+	dict_put(d, "a", int, 0);
+	dict_difference(c, d);
+	check_int(c->length, 3);
+	check( !dict_contains(c, "a") );
+	check( dict_contains(c, "b") );
+	
+	dict_destroy(a);
+	dict_destroy(b);
+	dict_destroy(c);
+	dict_destroy(d);
+}
+
+
+void test_snapshot(){
+	char path[64];
+	snprintf(path, sizeof(path), "/tmp/hash_test_snapshot_%d", (int)getpid());
+	
+	hash_p h = hash_of(int);
+	for(int i = 0; i < 1000; i++)
+		hash_put(h, i, int, i * 2);
+	hash_remove(h, 500);
+	
+	check( hash_save(h, path) );
+	hash_p loaded = hash_load(path);
+	check_not_null(loaded);
+	check_int(loaded->length, 999);
+	// Sized for all elements up front, so no resize was necessary while loading
+	check_int(loaded->capacity, snap_to_prime(999 / 0.75 + 1));
+	check_int( hash_get(loaded, 0, int), 0 );
+	check_int( hash_get(loaded, 999, int), 1998 );
+	check( !hash_contains(loaded, 500) );
+	hash_destroy(loaded);
+	
+	// The child writes the hash as it was during the fork, later changes are not in it
+	pid_t pid = hash_snapshot_async(h, path);
+	check(pid > 0);
+	hash_put(h, 0, int, -1);
+	hash_put(h, 5000, int, 1);
+	check( hash_snapshot_wait(pid) );
+	
+	loaded = hash_load(path);
+	check_not_null(loaded);
+	check_int(loaded->length, 999);
+	check_int( hash_get(loaded, 0, int), 0 );
+	check( !hash_contains(loaded, 5000) );
+	hash_destroy(loaded);
+	
+	// Wrong key type and missing files
+	char* keys = NULL;
+	check_null( dict_load(path, &keys) );
+	check_null(keys);
+	remove(path);
+	check_null( hash_load(path) );
+	
+	hash_destroy(h);
+}
+
+void test_dict_snapshot(){
+	char path[64];
+	snprintf(path, sizeof(path), "/tmp/dict_test_snapshot_%d", (int)getpid());
+	
+	dict_p d = dict_of(double);
+	dict_put(d, "foo", double, 1.5);
+	dict_put(d, "bar", double, 2.5);
+	dict_put(d, "", double, 3.5);
+	
+	pid_t pid = dict_snapshot_async(d, path);
+	check(pid > 0);
+	check( dict_snapshot_wait(pid) );
+	
+	char* keys = NULL;
+	dict_p loaded = dict_load(path, &keys);
+	check_not_null(loaded);
+	check_not_null(keys);
+	check_int(loaded->length, 3);
+	check( dict_get(loaded, "foo", double) == 1.5 );
+	check( dict_get(loaded, "bar", double) == 2.5 );
+	check( dict_get(loaded, "", double) == 3.5 );
+	// The keys of the loaded dict point into the key storage
+	check( dict_key(dict_get_elem(loaded, "foo")) >= keys );
+	check( dict_key(dict_get_elem(loaded, "foo")) < keys + 8 );
+	dict_destroy(loaded);
+	free(keys);
+	
+	// Without key storage the keys would leak
+	check_null( dict_load(path, NULL) );
+	
+	// Snapshots of an empty dict
+	dict_p empty = dict_of(double);
+	check( dict_save(empty, path) );
+	loaded = dict_load(path, &keys);
+	check_not_null(loaded);
+	check_int(loaded->length, 0);
+	dict_destroy(loaded);
+	free(keys);
+	dict_destroy(empty);
+	
+	remove(path);
+	dict_destroy(d);
+}
+
+
+void test_ranges(){
+	hash_p h = hash_of(int);
+	for(int i = 0; i < 1000; i++)
+		hash_put(h, i, int, i);
+	
+	// For any number of ranges each element is visited exactly once
+	for(size_t ranges = 1; ranges <= 8; ranges++) {
+		int visits[1000] = { 0 };
+		for(size_t range = 0; range < ranges; range++) {
+			for(hash_elem_t e = hash_range_start(h, range, ranges); e != NULL; e = hash_range_next(h, e, range, ranges))
+				visits[hash_key(e)]++;
+		}
+		
+		size_t visited_once = 0;
+		for(size_t i = 0; i < 1000; i++)
+			visited_once += (visits[i] == 1);
+		check_msg(visited_once == 1000, "only %zu of 1000 elements visited once with %zu ranges", visited_once, ranges);
+	}
+	
+	// More ranges than slots, most ranges are empty
+	hash_p small = hash_of(int);
+	hash_put(small, 1, int, 1);
+	size_t count = 0;
+	for(size_t range = 0; range < 16; range++) {
+		for(hash_elem_t e = hash_range_start(small, range, 16); e != NULL; e = hash_range_next(small, e, range, 16))
+			count++;
+	}
+	check_int(count, 1);
+	
+	// 0 ranges are one range with all slots
+	count = 0;
+	for(hash_elem_t e = hash_range_start(small, 0, 0); e != NULL; e = hash_range_next(small, e, 0, 0))
+		count++;
+	check_int(count, 1);
+	
+	hash_destroy(small);
+	hash_destroy(h);
+}
+
+void sum_in_range(hash_elem_t element, size_t range, void* context){
+	int64_t* sums = context;
+	sums[range] += hash_value(element, int);
+}
+
+void test_parallel_for(){
+	hash_p h = hash_of(int);
+	for(int i = 1; i <= 10000; i++)
+		hash_put(h, i, int, i);
+	
+	// One sum per range, so the threads never write to the same counter
+	int64_t sums[4] = { 0 };
+	hash_parallel_for(h, sum_in_range, sums, 4);
+	check(sums[0] > 0 && sums[1] > 0 && sums[2] > 0 && sums[3] > 0);
+	check(sums[0] + sums[1] + sums[2] + sums[3] == 50005000);
+	
+	int64_t sum = 0;
+	hash_parallel_for(h, sum_in_range, &sum, 1);
+	check(sum == 50005000);
+	
+	hash_destroy(h);
+}
+
 
 int main(){
 	run(test_alloc);
@@ -338,6 +694,17 @@ int main(){
 	run(test_dict);
 	run(test_dict_resize);
 	run(test_hash_get_ptr_bug0);
+	run(test_get_and_put_elem);
+	run(test_put_elem_tracked_and_clear);
+	run(test_multi_put_and_get);
+	run(test_multi_remove);
+	run(test_multi_iteration);
+	run(test_merge);
+	run(test_intersect_and_difference);
+	run(test_snapshot);
+	run(test_dict_snapshot);
+	run(test_ranges);
+	run(test_parallel_for);
 	
 	return show_report();
 }
\ No newline at end of file
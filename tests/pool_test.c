@@ -0,0 +1,194 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "testing.h"
+#include "../pool.h"
+
+void test_deque(){
+	pool_deque_t* deque = calloc(1, sizeof(pool_deque_t));
+	pool_task_t tasks[3];
+	
+	check_null(pool_deque_take(deque));
+	check_null(pool_deque_steal(deque));
+	for(size_t i = 0; i < 3; i++)
+		check( pool_deque_push(deque, &tasks[i]) );
+	
+	// The owner takes from the bottom, thieves steal from the top
+	check(pool_deque_take(deque) == &tasks[2]);
+	check(pool_deque_steal(deque) == &tasks[0]);
+	check(pool_deque_take(deque) == &tasks[1]);
+	check_null(pool_deque_take(deque));
+	check_null(pool_deque_steal(deque));
+	
+	for(size_t i = 0; i < POOL_DEQUE_CAPACITY; i++)
+		pool_deque_push(deque, &tasks[0]);
+	check( !pool_deque_push(deque, &tasks[0]) );
+	
+	free(deque);
+}
+
+
+#define STEAL_TASKS  100000
+#define THIEVES      3
+
+typedef struct {
+	pool_deque_t* deque;
+	pool_task_t* tasks;
+	size_t* taken;
+	bool done;
+} steal_test_t;
+
+static void* thief(void* arg){
+	steal_test_t* test = arg;
+	while ( !__atomic_load_n(&test->done, __ATOMIC_RELAXED) ) {
+		pool_task_t* task = pool_deque_steal(test->deque);
+		if (task != NULL)
+			__atomic_add_fetch(&test->taken[task - test->tasks], 1, __ATOMIC_RELAXED);
+	}
+	return NULL;
+}
+
+// Every task has to be taken exactly once, either by the owner or by one thief
+void test_deque_concurrent_steal(){
+	pool_deque_t* deque = calloc(1, sizeof(pool_deque_t));
+	pool_task_t* tasks = calloc(STEAL_TASKS, sizeof(pool_task_t));
+	steal_test_t test = { deque, tasks, calloc(STEAL_TASKS, sizeof(size_t)), false };
+	
+	pthread_t thieves[THIEVES];
+	for(size_t i = 0; i < THIEVES; i++)
+		pthread_create(&thieves[i], NULL, thief, &test);
+	
+	for(size_t i = 0; i < STEAL_TASKS; i++) {
+		while ( !pool_deque_push(deque, &tasks[i]) ) { }
+		// Take every other task, the rest is left to the thieves
+		if (i % 2 == 0) {
+			pool_task_t* task = pool_deque_take(deque);
+			if (task != NULL)
+				__atomic_add_fetch(&test.taken[task - tasks], 1, __ATOMIC_RELAXED);
+		}
+	}
+	pool_task_t* task;
+	while ( (task = pool_deque_take(deque)) != NULL )
+		__atomic_add_fetch(&test.taken[task - tasks], 1, __ATOMIC_RELAXED);
+	
+	__atomic_store_n(&test.done, true, __ATOMIC_RELAXED);
+	for(size_t i = 0; i < THIEVES; i++)
+		pthread_join(thieves[i], NULL);
+	
+	size_t wrong = 0;
+	for(size_t i = 0; i < STEAL_TASKS; i++)
+		wrong += (test.taken[i] != 1);
+	check_int(wrong, 0);
+	
+	free(test.taken);
+	free(tasks);
+	free(deque);
+}
+
+
+static void count_calls(void* context, size_t start, size_t end){
+	uint32_t* calls = context;
+	for(size_t i = start; i < end; i++)
+		__atomic_add_fetch(&calls[i], 1, __ATOMIC_RELAXED);
+}
+
+void test_parallel_for(){
+	size_t threads[] = { 1, 2, 4 };
+	size_t grains[] = { 0, 1, 7, 1000, 100000 };
+	
+	for(size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+		pool_p pool = pool_new(threads[t]);
+		check_int(pool->worker_count, threads[t] - 1);
+		
+		for(size_t g = 0; g < sizeof(grains) / sizeof(grains[0]); g++) {
+			uint32_t* calls = calloc(10003, sizeof(uint32_t));
+			pool_parallel_for(pool, 3, 10003, grains[g], count_calls, calls);
+			
+			size_t wrong = 0;
+			for(size_t i = 0; i < 10003; i++)
+				wrong += (calls[i] != (i >= 3 ? 1 : 0));
+			check_int(wrong, 0);
+			free(calls);
+		}
+		
+		pool_parallel_for(pool, 5, 5, 1, count_calls, NULL);
+		pool_destroy(pool);
+	}
+}
+
+static void sum_range(void* context, size_t start, size_t end, void* result){
+	(void)context;
+	for(size_t i = start; i < end; i++)
+		*(uint64_t*)result += i;
+}
+
+static void add(void* context, void* result, const void* other){
+	(void)context;
+	*(uint64_t*)result += *(const uint64_t*)other;
+}
+
+void test_parallel_reduce(){
+	pool_p pool = pool_new(4);
+	uint64_t identity = 0, sum = 1;
+	
+	pool_parallel_reduce(pool, 0, 1000000, 1000, sizeof(uint64_t), &identity, sum_range, add, NULL, &sum);
+	check(sum == 1000000ull * 999999 / 2);
+	pool_parallel_reduce(pool, 10, 11, 1000, sizeof(uint64_t), &identity, sum_range, add, NULL, &sum);
+	check(sum == 10);
+	pool_parallel_reduce(pool, 10, 10, 1000, sizeof(uint64_t), &identity, sum_range, add, NULL, &sum);
+	check(sum == 0);
+	
+	pool_destroy(pool);
+}
+
+
+typedef struct {
+	uint32_t n;
+	uint64_t result;
+} fib_t;
+
+static void fib(pool_p pool, void* arg){
+	fib_t* f = arg;
+	if (f->n < 2) {
+		f->result = f->n;
+		return;
+	}
+	
+	fib_t a = { f->n - 1, 0 }, b = { f->n - 2, 0 };
+	pool_group_t group = { 0 };
+	pool_task_t task = { fib, &a, NULL };
+	pool_spawn(pool, &group, &task);
+	fib(pool, &b);
+	pool_wait(pool, &group);
+	f->result = a.result + b.result;
+}
+
+void test_spawn_recursive(){
+	pool_p pool = pool_new(3);
+	fib_t f = { 22, 0 };
+	pool_run(pool, fib, &f);
+	check_int(f.result, 17711);
+	pool_destroy(pool);
+	
+	// Outside of pool_run() spawned tasks are run right away
+	pool = pool_new(2);
+	fib_t a = { 10, 0 };
+	pool_group_t group = { 0 };
+	pool_task_t task = { fib, &a, NULL };
+	pool_spawn(pool, &group, &task);
+	check_int(group.pending, 0);
+	pool_wait(pool, &group);
+	check_int(a.result, 55);
+	pool_destroy(pool);
+}
+
+
+int main(){
+	run(test_deque);
+	run(test_deque_concurrent_steal);
+	run(test_parallel_for);
+	run(test_parallel_reduce);
+	run(test_spawn_recursive);
+	
+	return show_report();
+}
\ No newline at end of file
@@ -0,0 +1,258 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include "testing.h"
+#include "../queue.h"
+
+typedef struct {
+	uint32_t producer;
+	uint32_t seq;
+	char payload[8];
+} record_t;
+
+void test_spsc_push_pop(){
+	spsc_queue_p q = spsc_queue_of(5, int);
+	check_int(q->capacity, 8);
+	
+	int value = 0;
+	check( !spsc_queue_pop(q, &value) );
+	for(int i = 0; i < 8; i++)
+		check( spsc_queue_push(q, &i) );
+	check( !spsc_queue_push(q, &value) );
+	
+	for(int i = 0; i < 8; i++) {
+		check( spsc_queue_pop(q, &value) );
+		check_int(value, i);
+	}
+	check( !spsc_queue_pop(q, &value) );
+	
+	spsc_queue_destroy(q);
+}
+
+void test_spsc_batches(){
+	spsc_queue_p q = spsc_queue_of(8, int);
+	int in[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 }, out[11] = { 0 };
+	
+	size_t pushed = spsc_queue_push_n(q, in, 5);
+	size_t popped = spsc_queue_pop_n(q, out, 3);
+	check_int(pushed, 5);
+	check_int(popped, 3);
+	
+	// Wraps around the end of the ring, afterwards only one more record fits
+	pushed = spsc_queue_push_n(q, in + 5, 5);
+	check_int(pushed, 5);
+	pushed = spsc_queue_push_n(q, in, 10);
+	check_int(pushed, 1);
+	
+	popped = spsc_queue_pop_n(q, out + 3, 10);
+	check_int(popped, 8);
+	for(int i = 0; i < 10; i++)
+		check_int(out[i], i);
+	check_int(out[10], 0);
+	
+	spsc_queue_destroy(q);
+}
+
+void test_spsc_reserve_peek(){
+	spsc_queue_p q = spsc_queue_of(8, int);
+	int value = 0;
+	for(int i = 0; i < 6; i++)
+		spsc_queue_push(q, &i);
+	for(int i = 0; i < 6; i++)
+		spsc_queue_pop(q, &value);
+	
+	// Only two slots left until the end of the ring
+	size_t n = 5;
+	int* space = spsc_queue_reserve(q, &n);
+	check_int(n, 2);
+	space[0] = 10;
+	space[1] = 11;
+	spsc_queue_publish(q, n);
+	
+	n = 5;
+	space = spsc_queue_reserve(q, &n);
+	check_int(n, 5);
+	for(int i = 0; i < 5; i++)
+		space[i] = 12 + i;
+	spsc_queue_publish(q, n);
+	
+	n = 100;
+	int* records = spsc_queue_peek(q, &n);
+	check_int(n, 2);
+	check_int(records[0], 10);
+	check_int(records[1], 11);
+	spsc_queue_consume(q, n);
+	
+	n = 100;
+	records = spsc_queue_peek(q, &n);
+	check_int(n, 5);
+	check_int(records[4], 16);
+	spsc_queue_consume(q, n);
+	
+	n = 100;
+	spsc_queue_peek(q, &n);
+	check_int(n, 0);
+	
+	spsc_queue_destroy(q);
+}
+
+void test_mpmc_push_pop(){
+	mpmc_queue_p q = mpmc_queue_of(4, record_t);
+	check_int(q->capacity, 4);
+	check_int(q->slot_size, 24);
+	
+	record_t record = { 0, 0, "abc" };
+	for(uint32_t round = 0; round < 3; round++) {
+		for(uint32_t i = 0; i < 4; i++) {
+			record.seq = round * 4 + i;
+			check( mpmc_queue_push(q, &record) );
+		}
+		check( !mpmc_queue_push(q, &record) );
+		
+		for(uint32_t i = 0; i < 4; i++) {
+			check( mpmc_queue_pop(q, &record) );
+			check_int(record.seq, round * 4 + i);
+			check_str(record.payload, "abc");
+		}
+		check( !mpmc_queue_pop(q, &record) );
+	}
+	
+	mpmc_queue_destroy(q);
+	
+	// A single slot can't tell a full queue from an empty one, the capacity is at least 2
+	q = mpmc_queue_of(1, record_t);
+	check_int(q->capacity, 2);
+	for(uint32_t i = 0; i < 2; i++) {
+		record.seq = i;
+		check( mpmc_queue_push(q, &record) );
+	}
+	check( !mpmc_queue_push(q, &record) );
+	for(uint32_t i = 0; i < 2; i++) {
+		check( mpmc_queue_pop(q, &record) );
+		check_int(record.seq, i);
+	}
+	check( !mpmc_queue_pop(q, &record) );
+	
+	mpmc_queue_destroy(q);
+}
+
+
+#define THREADED_RECORDS  100000
+#define THREADS           3
+
+typedef struct {
+	void* queue;
+	uint32_t producer;
+	size_t out_of_order;
+	uint64_t sum;
+	size_t* remaining;
+} worker_t;
+
+static void* spsc_producer(void* arg){
+	worker_t* worker = arg;
+	uint32_t batch[16];
+	for(uint32_t seq = 0; seq < THREADED_RECORDS; ) {
+		size_t n = 0;
+		while (n < 16 && seq + n < THREADED_RECORDS) {
+			batch[n] = seq + n;
+			n++;
+		}
+		size_t pushed = spsc_queue_push_n(worker->queue, batch, n);
+		if (pushed == 0)
+			sched_yield();
+		seq += pushed;
+	}
+	return NULL;
+}
+
+void test_spsc_threads(){
+	worker_t producer = { spsc_queue_of(64, uint32_t), 0, 0, 0, NULL };
+	pthread_t thread;
+	pthread_create(&thread, NULL, spsc_producer, &producer);
+	
+	size_t out_of_order = 0;
+	for(uint32_t expected = 0; expected < THREADED_RECORDS; ) {
+		size_t n = 32;
+		uint32_t* records = spsc_queue_peek(producer.queue, &n);
+		if (n == 0)
+			sched_yield();
+		for(size_t i = 0; i < n; i++, expected++)
+			out_of_order += (records[i] != expected);
+		spsc_queue_consume(producer.queue, n);
+	}
+	
+	pthread_join(thread, NULL);
+	check_int(out_of_order, 0);
+	spsc_queue_destroy(producer.queue);
+}
+
+static void* mpmc_producer(void* arg){
+	worker_t* worker = arg;
+	for(uint32_t seq = 0; seq < THREADED_RECORDS; seq++) {
+		record_t record = { worker->producer, seq, "x" };
+		while ( !mpmc_queue_push(worker->queue, &record) )
+			sched_yield();
+	}
+	return NULL;
+}
+
+// Records of each producer have to arrive in order at each consumer
+static void* mpmc_consumer(void* arg){
+	worker_t* worker = arg;
+	int64_t last_seq[THREADS] = { -1, -1, -1 };
+	record_t record;
+	
+	while (__atomic_load_n(worker->remaining, __ATOMIC_RELAXED) > 0) {
+		if ( !mpmc_queue_pop(worker->queue, &record) ) {
+			sched_yield();
+			continue;
+		}
+		__atomic_sub_fetch(worker->remaining, 1, __ATOMIC_RELAXED);
+		if ((int64_t)record.seq <= last_seq[record.producer])
+			worker->out_of_order++;
+		last_seq[record.producer] = record.seq;
+		worker->sum += record.seq;
+	}
+	return NULL;
+}
+
+void test_mpmc_threads(){
+	mpmc_queue_p q = mpmc_queue_of(128, record_t);
+	size_t remaining = THREADS * THREADED_RECORDS;
+	worker_t producers[THREADS], consumers[THREADS];
+	pthread_t producer_threads[THREADS], consumer_threads[THREADS];
+	
+	for(uint32_t i = 0; i < THREADS; i++) {
+		producers[i] = (worker_t){ q, i, 0, 0, &remaining };
+		consumers[i] = (worker_t){ q, i, 0, 0, &remaining };
+		pthread_create(&producer_threads[i], NULL, mpmc_producer, &producers[i]);
+		pthread_create(&consumer_threads[i], NULL, mpmc_consumer, &consumers[i]);
+	}
+	
+	uint64_t sum = 0;
+	size_t out_of_order = 0;
+	for(uint32_t i = 0; i < THREADS; i++) {
+		pthread_join(producer_threads[i], NULL);
+		pthread_join(consumer_threads[i], NULL);
+		sum += consumers[i].sum;
+		out_of_order += consumers[i].out_of_order;
+	}
+	
+	check_int(out_of_order, 0);
+	check(sum == (uint64_t)THREADS * THREADED_RECORDS * (THREADED_RECORDS - 1) / 2);
+	mpmc_queue_destroy(q);
+}
+
+
+int main(){
+	run(test_spsc_push_pop);
+	run(test_spsc_batches);
+	run(test_spsc_reserve_peek);
+	run(test_mpmc_push_pop);
+	run(test_spsc_threads);
+	run(test_mpmc_threads);
+	
+	return show_report();
+}
\ No newline at end of file
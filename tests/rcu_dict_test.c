@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "testing.h"
+#include "../rcu_dict.h"
+
+void test_alloc(){
+	rcu_dict_p d = rcu_dict_new(10, sizeof(float));
+	
+	check_not_null(d);
+	check_not_null(d->current);
+	check_int(d->current->capacity, 10);
+	check_int(d->current->value_size, sizeof(float));
+	
+	rcu_dict_destroy(d);
+	
+	d = rcu_dict_of(int);
+	check_not_null(d);
+	check_int(d->current->value_size, sizeof(int));
+	rcu_dict_destroy(d);
+}
+
+void test_cache_line_alignment(){
+	rcu_dict_p d = rcu_dict_of(int);
+	check_int((uintptr_t)d % RCU_DICT_CACHE_LINE, 0);
+	check_int(offsetof(rcu_dict_t, readers), RCU_DICT_CACHE_LINE);
+	
+	// Each reader has its own cache line
+	rcu_dict_reader_p a = rcu_dict_register(d), b = rcu_dict_register(d);
+	check_int(sizeof(rcu_dict_reader_t), RCU_DICT_CACHE_LINE);
+	check_int((uintptr_t)a % RCU_DICT_CACHE_LINE, 0);
+	check_int((uintptr_t)b % RCU_DICT_CACHE_LINE, 0);
+	
+	rcu_dict_unregister(d, a);
+	rcu_dict_destroy(d);
+}
+
+void test_copy(){
+	dict_p d = dict_of(int);
+	dict_put(d, "foo", int, 1);
+	dict_put(d, "bar", int, 2);
+	dict_remove(d, "foo");
+	
+	dict_p c = dict_copy(d);
+	check_not_null(c);
+	check(c != d);
+	check(c->slots != d->slots);
+	check_int(c->length, 1);
+	check_int(c->capacity, d->capacity);
+	check( !dict_contains(c, "foo") );
+	check_int( dict_get(c, "bar", int), 2 );
+	
+	// Changing the copy doesn't change the original
+	dict_put(c, "bar", int, 3);
+	check_int( dict_get(d, "bar", int), 2 );
+	
+	dict_destroy(c);
+	dict_destroy(d);
+}
+
+void test_put_and_read(){
+	rcu_dict_p d = rcu_dict_of(int);
+	rcu_dict_reader_p r = rcu_dict_register(d);
+	check_not_null(r);
+	
+	int x = 7;
+	check( rcu_dict_put(d, "foo", &x) );
+	x = 8;
+	check( rcu_dict_put(d, "bar", &x) );
+	
+	dict_p snapshot = rcu_dict_read_lock(d, r);
+	check_int(snapshot->length, 2);
+	check_int( dict_get(snapshot, "foo", int), 7 );
+	check_int( dict_get(snapshot, "bar", int), 8 );
+	rcu_dict_read_unlock(r);
+	
+	check( rcu_dict_remove(d, "foo") );
+	snapshot = rcu_dict_read_lock(d, r);
+	check_int(snapshot->length, 1);
+	check( !dict_contains(snapshot, "foo") );
+	rcu_dict_read_unlock(r);
+	
+	rcu_dict_unregister(d, r);
+	rcu_dict_destroy(d);
+}
+
+void test_batch_write(){
+	rcu_dict_p d = rcu_dict_of(int);
+	rcu_dict_reader_p r = rcu_dict_register(d);
+	
+	dict_p copy = rcu_dict_write_begin(d);
+	dict_put(copy, "foo", int, 1);
+	dict_put(copy, "bar", int, 2);
+	
+	// Not visible before the commit
+	dict_p snapshot = rcu_dict_read_lock(d, r);
+	check_int(snapshot->length, 0);
+	rcu_dict_read_unlock(r);
+	
+	rcu_dict_write_commit(d, copy);
+	snapshot = rcu_dict_read_lock(d, r);
+	check_int(snapshot->length, 2);
+	rcu_dict_read_unlock(r);
+	
+	// An aborted write doesn't change anything
+	copy = rcu_dict_write_begin(d);
+	dict_remove(copy, "foo");
+	rcu_dict_write_abort(d, copy);
+	snapshot = rcu_dict_read_lock(d, r);
+	check_int(snapshot->length, 2);
+	rcu_dict_read_unlock(r);
+	
+	rcu_dict_destroy(d);
+}
+
+
+//
+// Concurrent readers: the writer always updates "a" and "b" together in one commit.
+// Readers must never see a state where both values differ.
+//
+
+typedef struct {
+	rcu_dict_p dict;
+	volatile bool stop;
+	size_t inconsistent_reads;
+} concurrent_test_t;
+
+static void* concurrent_reader(void* arg){
+	concurrent_test_t* test = arg;
+	rcu_dict_reader_p reader = rcu_dict_register(test->dict);
+	
+	while( !__atomic_load_n(&test->stop, __ATOMIC_RELAXED) ) {
+		dict_p snapshot = rcu_dict_read_lock(test->dict, reader);
+		int* a = dict_get_ptr(snapshot, "a");
+		int* b = dict_get_ptr(snapshot, "b");
+		if (a == NULL || b == NULL || *a != *b)
+			__atomic_add_fetch(&test->inconsistent_reads, 1, __ATOMIC_RELAXED);
+		rcu_dict_read_unlock(reader);
+	}
+	
+	rcu_dict_unregister(test->dict, reader);
+	return NULL;
+}
+
+void test_concurrent_readers(){
+	concurrent_test_t test = { rcu_dict_of(int), false, 0 };
+	dict_p copy = rcu_dict_write_begin(test.dict);
+	dict_put(copy, "a", int, 0);
+	dict_put(copy, "b", int, 0);
+	rcu_dict_write_commit(test.dict, copy);
+	
+	pthread_t readers[4];
+	for(size_t i = 0; i < 4; i++)
+		pthread_create(&readers[i], NULL, concurrent_reader, &test);
+	
+	for(int i = 1; i <= 500; i++) {
+		copy = rcu_dict_write_begin(test.dict);
+		dict_put(copy, "a", int, i);
+		dict_put(copy, "b", int, i);
+		rcu_dict_write_commit(test.dict, copy);
+	}
+	
+	__atomic_store_n(&test.stop, true, __ATOMIC_RELAXED);
+	for(size_t i = 0; i < 4; i++)
+		pthread_join(readers[i], NULL);
+	
+	check_int(test.inconsistent_reads, 0);
+	check_int( dict_get(test.dict->current, "a", int), 500 );
+	
+	rcu_dict_destroy(test.dict);
+}
+
+
+int main(){
+	run(test_alloc);
+	run(test_cache_line_alignment);
+	run(test_copy);
+	run(test_put_and_read);
+	run(test_batch_write);
+	run(test_concurrent_readers);
+	
+	return show_report();
+}
\ No newline at end of file
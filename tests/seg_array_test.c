@@ -0,0 +1,112 @@
+#include <stdint.h>
+#include "testing.h"
+#include "../seg_array.h"
+
+void test_new(){
+	seg_array_p a = seg_array_of(int);
+	check_not_null(a);
+	check_int(a->length, 0);
+	check_int(a->capacity, 0);
+	check_int(a->first_chunk_bits, 4);
+	seg_array_destroy(a);
+	
+	a = seg_array_new(5, sizeof(int));
+	check_int(a->first_chunk_bits, 3);
+	seg_array_destroy(a);
+}
+
+void test_append_and_index(){
+	seg_array_p a = seg_array_new(4, sizeof(uint32_t));
+	for(uint32_t i = 0; i < 1000; i++)
+		seg_array_append(a, uint32_t, i);
+	
+	check_int(a->length, 1000);
+	// Chunks of 4, 8, 16, ..., 512 elements hold 1020
+	check_int(a->chunk_count, 8);
+	check_int(a->capacity, 1020);
+	for(uint32_t i = 0; i < 1000; i++)
+		check_int(seg_array_elem(a, uint32_t, i), i);
+	
+	seg_array_destroy(a);
+}
+
+void test_stable_pointers(){
+	seg_array_p a = seg_array_of(uint64_t);
+	uint64_t* first = seg_array_append_ptr(a);
+	*first = 42;
+	uint64_t* hundredth = NULL;
+	for(uint64_t i = 1; i < 10000; i++) {
+		uint64_t* elem = seg_array_append_ptr(a);
+		*elem = i;
+		if (i == 100)
+			hundredth = elem;
+	}
+	
+	check(first == seg_array_elem_ptr(a, 0));
+	check(hundredth == seg_array_elem_ptr(a, 100));
+	check_int(*first, 42);
+	check_int(*hundredth, 100);
+	
+	seg_array_destroy(a);
+}
+
+void test_chunk_iteration(){
+	seg_array_p a = seg_array_new(2, sizeof(int));
+	for(int i = 0; i < 20; i++)
+		seg_array_append(a, int, i);
+	
+	// Chunks of 2, 4, 8 and 16 elements, the last one only partially used
+	size_t expected_lengths[] = { 2, 4, 8, 6 };
+	int next = 0;
+	check_int(a->chunk_count, 4);
+	for(size_t c = 0; c < a->chunk_count; c++) {
+		size_t n;
+		int* elements = seg_array_chunk(a, c, &n);
+		check_int(n, expected_lengths[c]);
+		for(size_t i = 0; i < n; i++, next++)
+			check_int(elements[i], next);
+	}
+	check_int(next, 20);
+	
+	size_t n = 1;
+	check_null(seg_array_chunk(a, 4, &n));
+	check_int(n, 0);
+	
+	seg_array_destroy(a);
+}
+
+void test_resize_and_shrink(){
+	seg_array_p a = seg_array_new(4, sizeof(int));
+	check( seg_array_reserve(a, 100) );
+	check_int(a->length, 0);
+	check_int(a->capacity, 124);
+	check_int(a->chunk_count, 5);
+	
+	check( seg_array_resize(a, 10) );
+	check_int(a->length, 10);
+	seg_array_shrink_to_fit(a);
+	check_int(a->chunk_count, 2);
+	check_int(a->capacity, 12);
+	
+	// Shrinking keeps the chunks
+	check( seg_array_resize(a, 1) );
+	check_int(a->chunk_count, 2);
+	
+	check( seg_array_resize(a, 0) );
+	seg_array_shrink_to_fit(a);
+	check_int(a->chunk_count, 0);
+	check_int(a->capacity, 0);
+	
+	seg_array_destroy(a);
+}
+
+
+int main(){
+	run(test_new);
+	run(test_append_and_index);
+	run(test_stable_pointers);
+	run(test_chunk_iteration);
+	run(test_resize_and_shrink);
+	
+	return show_report();
+}
\ No newline at end of file
@@ -0,0 +1,152 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "testing.h"
+#include "../shm_hash.h"
+
+void test_create(){
+	shm_hash_p h = shm_hash_create(NULL, 100, sizeof(int), 0);
+	
+	check_not_null(h);
+	check_int(h->header->capacity, 100);
+	check_int(h->header->length, 0);
+	check_int(h->header->value_size, sizeof(int));
+	// Hash and key are 64 bit each, values are padded to 8 bytes
+	check_int(h->slot_size, 24);
+	
+	shm_hash_close(h);
+}
+
+void test_hash_put_and_get(){
+	shm_hash_p h = shm_hash_create(NULL, 100, sizeof(int), 0);
+	
+	shm_hash_put(h, 7, int, 42);
+	shm_hash_put(h, 0, int, 1);
+	check_int(h->header->length, 2);
+	check_int(shm_hash_get(h, 7, int), 42);
+	check_int(shm_hash_get(h, 0, int), 1);
+	check(shm_hash_contains(h, 7));
+	check(!shm_hash_contains(h, 8));
+	check_null(shm_hash_get_ptr(h, 8));
+	
+	shm_hash_put(h, 7, int, 43);
+	check_int(h->header->length, 2);
+	check_int(shm_hash_get(h, 7, int), 43);
+	
+	shm_hash_remove(h, 7);
+	check_int(h->header->length, 1);
+	check(!shm_hash_contains(h, 7));
+	check_int(shm_hash_get(h, 0, int), 1);
+	
+	shm_hash_close(h);
+}
+
+void test_dict_put_and_get(){
+	shm_dict_p d = shm_dict_create(NULL, 100, sizeof(int), 1024);
+	
+	shm_dict_put(d, "foo", int, 1);
+	shm_dict_put(d, "bar", int, 2);
+	check_int(d->header->length, 2);
+	check_int(d->header->heap_used, 8);
+	check_int(shm_dict_get(d, "foo", int), 1);
+	check_int(shm_dict_get(d, "bar", int), 2);
+	check(!shm_dict_contains(d, "baz"));
+	
+	// Keys are copied into the heap, putting an existing key doesn't copy it again
+	char key[] = "foo";
+	shm_dict_put(d, key, int, 3);
+	key[0] = 'x';
+	check_int(d->header->heap_used, 8);
+	check_int(shm_dict_get(d, "foo", int), 3);
+	
+	shm_dict_remove(d, "foo");
+	check(!shm_dict_contains(d, "foo"));
+	check_int(d->header->length, 1);
+	
+	shm_dict_close(d);
+}
+
+void test_full(){
+	shm_hash_p h = shm_hash_create(NULL, 4, sizeof(int), 0);
+	
+	// The table is never resized, puts fail above a load factor of 0.75
+	for(int i = 0; i < 3; i++)
+		check_not_null(shm_hash_put_ptr(h, i));
+	check_null(shm_hash_put_ptr(h, 3));
+	// Existing keys still work
+	check_not_null(shm_hash_put_ptr(h, 2));
+	
+	shm_hash_close(h);
+	
+	shm_dict_p d = shm_dict_create(NULL, 100, sizeof(int), 8);
+	check_not_null(shm_dict_put_ptr(d, "foo"));
+	check_not_null(shm_dict_put_ptr(d, "bar"));
+	check_null(shm_dict_put_ptr(d, "baz"));
+	check_int(d->header->length, 2);
+	
+	shm_dict_close(d);
+}
+
+void test_fork(){
+	shm_dict_p d = shm_dict_create(NULL, 100, sizeof(int), 1024);
+	shm_dict_put(d, "parent", int, 1);
+	
+	pid_t pid = fork();
+	if (pid == 0) {
+		// The child sees the parents entries and its changes are visible to the parent
+		int status = (shm_dict_get(d, "parent", int) == 1) ? 0 : 1;
+		shm_dict_write_lock(d);
+		shm_dict_put(d, "child", int, 2);
+		shm_dict_unlock(d);
+		_exit(status);
+	}
+	
+	int status = -1;
+	waitpid(pid, &status, 0);
+	check(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+	
+	shm_dict_read_lock(d);
+	check_int(d->header->length, 2);
+	check_int(shm_dict_get(d, "child", int), 2);
+	shm_dict_unlock(d);
+	
+	shm_dict_close(d);
+}
+
+void test_named(){
+	char name[64];
+	snprintf(name, sizeof(name), "/shm_hash_test_%d", (int)getpid());
+	
+	shm_hash_p h = shm_hash_create(name, 100, sizeof(double), 0);
+	check_not_null(h);
+	shm_hash_put(h, 1, double, 1.5);
+	
+	// Creating it again fails, opening maps the same table (usually at a different address)
+	check_null(shm_hash_create(name, 100, sizeof(double), 0));
+	shm_hash_p other = shm_hash_open(name);
+	check_not_null(other);
+	check(other->header != h->header);
+	check(shm_hash_get(other, 1, double) == 1.5);
+	shm_hash_put(other, 2, double, 2.5);
+	check(shm_hash_get(h, 2, double) == 2.5);
+	
+	shm_hash_close(other);
+	shm_hash_close(h);
+	
+	check(shm_hash_unlink(name));
+	check_null(shm_hash_open(name));
+	check(!shm_hash_unlink(name));
+}
+
+
+int main(){
+	run(test_create);
+	run(test_hash_put_and_get);
+	run(test_dict_put_and_get);
+	run(test_full);
+	run(test_fork);
+	run(test_named);
+	
+	return show_report();
+}
\ No newline at end of file
@@ -0,0 +1,186 @@
+#include <stdio.h>
+#include "testing.h"
+#include "../sketch.h"
+
+void test_count_min(){
+	count_min_p cm = count_min_new(1000, 4);
+	check_not_null(cm);
+	check_int(cm->width, 1000);
+	check_int(cm->depth, 4);
+	
+	count_min_add(cm, "foo", 1);
+	count_min_add(cm, "foo", 2);
+	count_min_add(cm, "bar", 5);
+	check_int(count_min_estimate(cm, "foo"), 3);
+	check_int(count_min_estimate(cm, "bar"), 5);
+	check_int(count_min_estimate(cm, "baz"), 0);
+	check_int(cm->total, 8);
+	
+	count_min_destroy(cm);
+}
+
+void test_count_min_error(){
+	count_min_p cm = count_min_for_error(0.01, 0.01);
+	check_not_null(cm);
+	check_int(cm->width, 272);
+	check_int(cm->depth, 5);
+	
+	// Key i appears i times, a lot more keys than counters in a row
+	char key[16];
+	for(int i = 1; i <= 2000; i++) {
+		snprintf(key, sizeof(key), "key %d", i);
+		count_min_add(cm, key, i);
+	}
+	
+	size_t underestimates = 0, large_errors = 0;
+	for(int i = 1; i <= 2000; i++) {
+		snprintf(key, sizeof(key), "key %d", i);
+		uint64_t estimate = count_min_estimate(cm, key);
+		if (estimate < (uint64_t)i)
+			underestimates++;
+		if (estimate - i > 0.01 * cm->total)
+			large_errors++;
+	}
+	check_int(underestimates, 0);
+	check_msg(large_errors <= 20, "%zu of 2000 estimates exceed the error bound", large_errors);
+	
+	count_min_destroy(cm);
+	check_null( count_min_for_error(0, 0.1) );
+}
+
+void test_count_min_merge(){
+	count_min_p a = count_min_new(100, 3);
+	count_min_p b = count_min_new(100, 3);
+	count_min_p c = count_min_new(50, 3);
+	
+	count_min_add(a, "foo", 3);
+	count_min_add(b, "foo", 4);
+	count_min_add(b, "bar", 1);
+	check( count_min_merge(a, b) );
+	check_int(count_min_estimate(a, "foo"), 7);
+	check_int(count_min_estimate(a, "bar"), 1);
+	check_int(a->total, 8);
+	check( !count_min_merge(a, c) );
+	
+	count_min_destroy(a);
+	count_min_destroy(b);
+	count_min_destroy(c);
+}
+
+void test_hyperloglog(){
+	hyperloglog_p hll = hyperloglog_new(14);
+	check_not_null(hll);
+	check_int(hll->register_count, 16384);
+	check_int(hyperloglog_count(hll), 0);
+	
+	hyperloglog_add(hll, "foo");
+	hyperloglog_add(hll, "foo");
+	hyperloglog_add(hll, "bar");
+	check_int(hyperloglog_count(hll), 2);
+	
+	// Standard error is about 0.8%, allow 3%
+	char key[16];
+	for(int i = 0; i < 100000; i++) {
+		snprintf(key, sizeof(key), "%d", i);
+		hyperloglog_add(hll, key);
+		hyperloglog_add(hll, key);
+	}
+	uint64_t count = hyperloglog_count(hll);
+	check_msg(count > 97000 && count < 103000, "estimated %lu distinct keys instead of 100002", (unsigned long)count);
+	
+	hyperloglog_destroy(hll);
+	check_null( hyperloglog_new(3) );
+	check_null( hyperloglog_new(19) );
+}
+
+void test_hyperloglog_merge(){
+	hyperloglog_p a = hyperloglog_new(12);
+	hyperloglog_p b = hyperloglog_new(12);
+	hyperloglog_p c = hyperloglog_new(10);
+	
+	// 0..29999 and 20000..49999 overlap, 50000 distinct keys in total
+	char key[16];
+	for(int i = 0; i < 30000; i++) {
+		snprintf(key, sizeof(key), "%d", i);
+		hyperloglog_add(a, key);
+		snprintf(key, sizeof(key), "%d", i + 20000);
+		hyperloglog_add(b, key);
+	}
+	
+	check( hyperloglog_merge(a, b) );
+	uint64_t count = hyperloglog_count(a);
+	check_msg(count > 47000 && count < 53000, "estimated %lu distinct keys instead of 50000", (unsigned long)count);
+	check( !hyperloglog_merge(a, c) );
+	
+	hyperloglog_destroy(a);
+	hyperloglog_destroy(b);
+	hyperloglog_destroy(c);
+}
+
+void test_top_k(){
+	top_k_p top = top_k_new(50);
+	check_not_null(top);
+	
+	// Two heavy hitters hidden in a lot of keys that only appear once. Both appear more
+	// often than total / k (11500 / 50) so they are guaranteed to be found.
+	char key[16];
+	for(int i = 0; i < 10000; i++) {
+		snprintf(key, sizeof(key), "noise %d", i);
+		top_k_add(top, key, 1);
+		if (i % 10 == 0)
+			top_k_add(top, "foo", 1);
+		if (i % 20 == 0)
+			top_k_add(top, "bar", 1);
+	}
+	check_int(top->length, 50);
+	check_int(top->candidates->length, 50);
+	
+	top_k_item_t items[3];
+	size_t n = top_k_list(top, items, 3);
+	check_int(n, 3);
+	check_str(items[0].key, "foo");
+	check_str(items[1].key, "bar");
+	// Counts are overestimates by at most the error
+	check(items[0].count >= 1000 && items[0].count - items[0].error <= 1000);
+	check(items[1].count >= 500 && items[1].count - items[1].error <= 500);
+	check(items[2].count <= items[1].count);
+	
+	top_k_destroy(top);
+}
+
+void test_top_k_merge(){
+	top_k_p a = top_k_new(3);
+	top_k_p b = top_k_new(3);
+	
+	top_k_add(a, "foo", 5);
+	top_k_add(a, "bar", 2);
+	top_k_add(b, "foo", 1);
+	top_k_add(b, "baz", 7);
+	top_k_merge(a, b);
+	
+	top_k_item_t items[5];
+	size_t n = top_k_list(a, items, 5);
+	check_int(n, 3);
+	check_str(items[0].key, "baz");
+	check_int(items[0].count, 7);
+	check_str(items[1].key, "foo");
+	check_int(items[1].count, 6);
+	check_str(items[2].key, "bar");
+	check_int(items[2].error, 0);
+	
+	top_k_destroy(a);
+	top_k_destroy(b);
+}
+
+
+int main(){
+	run(test_count_min);
+	run(test_count_min_error);
+	run(test_count_min_merge);
+	run(test_hyperloglog);
+	run(test_hyperloglog_merge);
+	run(test_top_k);
+	run(test_top_k_merge);
+	
+	return show_report();
+}
\ No newline at end of file
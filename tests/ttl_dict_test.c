@@ -0,0 +1,191 @@
+#include <stdio.h>
+#include "testing.h"
+#include "../ttl_dict.h"
+
+void test_alloc(){
+	ttl_dict_p d = ttl_dict_new(10, sizeof(float), 100);
+	
+	check_not_null(d);
+	check_not_null(d->dict);
+	check_not_null(d->timers);
+	check_int(d->dict->length, 0);
+	check_int(d->value_size, sizeof(float));
+	check(d->now == 100);
+	
+	ttl_dict_destroy(d);
+}
+
+void test_put_and_get(){
+	ttl_dict_p d = ttl_dict_of(int, 0);
+	
+	ttl_dict_put(d, "foo", int, 7, 10, 0);
+	ttl_dict_put(d, "bar", int, 8, 20, 0);
+	check_int(d->dict->length, 2);
+	check(ttl_dict_expires_at(d, "foo") == 10);
+	check(ttl_dict_expires_at(d, "bar") == 20);
+	check(ttl_dict_expires_at(d, "baz") == 0);
+	
+	int foo = ttl_dict_get(d, "foo", int, 5);
+	check_int(foo, 7);
+	check_null( ttl_dict_get_ptr(d, "baz", 5) );
+	
+	ttl_dict_remove(d, "foo");
+	check_int(d->dict->length, 1);
+	check_null( ttl_dict_get_ptr(d, "foo", 5) );
+	
+	ttl_dict_destroy(d);
+}
+
+void test_lazy_expiry(){
+	ttl_dict_p d = ttl_dict_of(int, 0);
+	ttl_dict_put(d, "foo", int, 7, 10, 0);
+	
+	check_not_null( ttl_dict_get_ptr(d, "foo", 9) );
+	check_null( ttl_dict_get_ptr(d, "foo", 10) );
+	check_int(d->dict->length, 0);
+	check_int(d->expirations, 1);
+	
+	// The timer is gone as well, advancing the wheel expires nothing
+	check_int(ttl_dict_expire(d, 100), 0);
+	
+	ttl_dict_destroy(d);
+}
+
+const char* expired_keys[10];
+size_t expired_count = 0;
+
+void record_expired(const char* key, void* value, void* context){
+	(void)context;
+	check_int(*(int*)value, 42);
+	expired_keys[expired_count++] = key;
+}
+
+void test_expire_callback(){
+	ttl_dict_p d = ttl_dict_of(int, 1000);
+	ttl_dict_on_expire(d, record_expired, NULL);
+	expired_count = 0;
+	
+	ttl_dict_put(d, "a", int, 42, 1, 1000);
+	ttl_dict_put(d, "b", int, 42, 50, 1000);
+	ttl_dict_put(d, "c", int, 42, 50, 1000);
+	
+	// check_int() evaluates its arguments twice, so expire first and check afterwards
+	size_t expired = ttl_dict_expire(d, 1000);
+	check_int(expired, 0);
+	expired = ttl_dict_expire(d, 1001);
+	check_int(expired, 1);
+	check_int(expired_count, 1);
+	check_str(expired_keys[0], "a");
+	
+	expired = ttl_dict_expire(d, 1049);
+	check_int(expired, 0);
+	expired = ttl_dict_expire(d, 1050);
+	check_int(expired, 2);
+	check_int(expired_count, 3);
+	check_int(d->dict->length, 0);
+	
+	ttl_dict_destroy(d);
+}
+
+void test_refresh_ttl(){
+	ttl_dict_p d = ttl_dict_of(int, 0);
+	
+	ttl_dict_put(d, "foo", int, 7, 10, 0);
+	// Putting it again moves the expiration time and keeps the value
+	ttl_dict_put_ptr(d, "foo", 10, 5);
+	check(ttl_dict_expires_at(d, "foo") == 15);
+	
+	size_t expired = ttl_dict_expire(d, 14);
+	check_int(expired, 0);
+	check_int( ttl_dict_get(d, "foo", int, 14), 7 );
+	expired = ttl_dict_expire(d, 15);
+	check_int(expired, 1);
+	check_null( ttl_dict_get_ptr(d, "foo", 15) );
+	
+	ttl_dict_destroy(d);
+}
+
+/**
+ * Entries with all kinds of TTLs, including ones that need to cascade through all
+ * levels and ones further away than the wheel covers. Each one has to expire exactly
+ * at its expiration time.
+ */
+void test_cascading(){
+	uint64_t ttls[] = { 1, 63, 64, 65, 100, 4095, 4096, 4097, 262144, 300000, 16777215, 16777216, 40000000 };
+	size_t count = sizeof(ttls) / sizeof(ttls[0]);
+	char keys[count][16];
+	
+	uint64_t start = 12345;
+	ttl_dict_p d = ttl_dict_of(uint64_t, start);
+	for(size_t i = 0; i < count; i++) {
+		snprintf(keys[i], sizeof(keys[i]), "%zu", i);
+		ttl_dict_put(d, keys[i], uint64_t, ttls[i], ttls[i], start);
+	}
+	
+	for(size_t i = 0; i < count; i++) {
+		// Advance in large steps to just before the expiration and then one tick
+		ttl_dict_expire(d, start + ttls[i] - 1);
+		check_msg(ttl_dict_expires_at(d, keys[i]) == start + ttls[i], "entry %zu expired too early", i);
+		ttl_dict_expire(d, start + ttls[i]);
+		check_msg(ttl_dict_expires_at(d, keys[i]) == 0, "entry %zu didn't expire", i);
+	}
+	
+	check_int(d->dict->length, 0);
+	check_int(d->expirations, count);
+	
+	ttl_dict_destroy(d);
+}
+
+void test_cascading_sweep(){
+	// Slot boundaries of all levels, relative to starts on and off those boundaries
+	uint64_t starts[] = { 0, 1, 62, 63, 64, 65, 4095, 4096, 4097, 12345 };
+	uint64_t ttls[] = { 1, 2, 62, 63, 64, 65, 127, 128, 129, 191, 4095, 4096, 4097, 4159, 4160, 8191, 262143, 262144, 262145 };
+	
+	for(size_t s = 0; s < sizeof(starts) / sizeof(starts[0]); s++) {
+		for(size_t t = 0; t < sizeof(ttls) / sizeof(ttls[0]); t++) {
+			uint64_t start = starts[s], expires_at = starts[s] + ttls[t];
+			ttl_dict_p d = ttl_dict_of(int, start);
+			ttl_dict_put(d, "foo", int, 7, ttls[t], start);
+			
+			size_t early = ttl_dict_expire(d, expires_at - 1);
+			size_t expired = ttl_dict_expire(d, expires_at);
+			check_msg(early == 0, "start %lu, ttl %lu expired too early", (unsigned long)start, (unsigned long)ttls[t]);
+			check_msg(expired == 1, "start %lu, ttl %lu didn't expire in time", (unsigned long)start, (unsigned long)ttls[t]);
+			
+			ttl_dict_destroy(d);
+		}
+	}
+}
+
+void test_timer_reuse(){
+	char keys[100][8];
+	ttl_dict_p d = ttl_dict_of(int, 0);
+	
+	for(uint64_t round = 0; round < 10; round++) {
+		for(int i = 0; i < 100; i++) {
+			snprintf(keys[i], sizeof(keys[i]), "%d", i);
+			ttl_dict_put(d, keys[i], int, i, 1 + i % 7, round * 10);
+		}
+		ttl_dict_expire(d, round * 10 + 8);
+		check_int(d->dict->length, 0);
+	}
+	
+	// Timers of expired entries are reused
+	check_int(d->timers->length, 100);
+	
+	ttl_dict_destroy(d);
+}
+
+
+int main(){
+	run(test_alloc);
+	run(test_put_and_get);
+	run(test_lazy_expiry);
+	run(test_expire_callback);
+	run(test_refresh_ttl);
+	run(test_cascading);
+	run(test_cascading_sweep);
+	run(test_timer_reuse);
+	
+	return show_report();
+}
\ No newline at end of file
@@ -0,0 +1,309 @@
+#include <stdlib.h>
+#include "ttl_dict.h"
+
+/**
+ * Layout of a dict value: the ttl_dict_entry_t followed by value_size bytes of the users
+ * value. Timers live in the `timers` array and are linked into the lists of the wheel
+ * slots by their index. Unused timers are linked into the free list via `next`.
+ */
+
+typedef struct {
+	uint64_t expires_at;
+	uint32_t timer;
+} ttl_dict_entry_t, *ttl_dict_entry_p;
+
+typedef struct {
+	const char* key;
+	uint64_t expires_at;
+	uint32_t prev, next;
+	uint32_t list;
+} ttl_dict_timer_t, *ttl_dict_timer_p;
+
+#define TTL_DICT_NIL  UINT32_MAX
+
+#define entry_value_ptr(entry)  ( (void*)((entry) + 1) )
+#define timer_ptr(dict, index)  ( &array_elem((dict)->timers, ttl_dict_timer_t, (index)) )
+
+static uint32_t ttl_dict_timer_new(ttl_dict_p dict, const char* key, uint64_t expires_at);
+static void     ttl_dict_timer_free(ttl_dict_p dict, uint32_t index);
+static void     ttl_dict_timer_link(ttl_dict_p dict, uint32_t index, uint64_t next_tick);
+static void     ttl_dict_timer_unlink(ttl_dict_p dict, uint32_t index);
+static void     ttl_dict_cascade(ttl_dict_p dict, uint32_t list, uint64_t tick);
+static void     ttl_dict_expire_elem(ttl_dict_p dict, dict_elem_t elem);
+static void     ttl_dict_shrink(ttl_dict_p dict);
+
+
+//
+// Creation and destruction functions
+//
+
+ttl_dict_p ttl_dict_new(size_t capacity, size_t value_size, uint64_t now){
+	ttl_dict_p dict = malloc(sizeof(ttl_dict_t));
+	if (dict == NULL)
+		return NULL;
+	
+	dict->dict = dict_new(capacity, sizeof(ttl_dict_entry_t) + value_size);
+	dict->timers = array_of(ttl_dict_timer_t);
+	if (dict->dict == NULL || dict->timers == NULL) {
+		if (dict->dict)
+			dict_destroy(dict->dict);
+		if (dict->timers)
+			array_destroy(dict->timers);
+		free(dict);
+		return NULL;
+	}
+	
+	dict->value_size = value_size;
+	dict->now = now;
+	dict->free_timers = TTL_DICT_NIL;
+	for(size_t i = 0; i < TTL_DICT_LEVELS * TTL_DICT_SLOTS; i++)
+		dict->wheel[i] = TTL_DICT_NIL;
+	dict->expire_func = NULL;
+	dict->expire_context = NULL;
+	dict->expirations = 0;
+	
+	return dict;
+}
+
+void ttl_dict_destroy(ttl_dict_p dict){
+	array_destroy(dict->timers);
+	dict_destroy(dict->dict);
+	free(dict);
+}
+
+void ttl_dict_on_expire(ttl_dict_p dict, ttl_dict_expire_func_t func, void* context){
+	dict->expire_func = func;
+	dict->expire_context = context;
+}
+
+
+//
+// Get and put functions
+//
+
+/**
+ * Returns a pointer to the value of `key` and sets its expiration time to `now + ttl`.
+ * New entries are inserted with an undefined value. Returns NULL if no memory for the
+ * timer could be allocated.
+ */
+void* ttl_dict_put_ptr(ttl_dict_p dict, const char* key, uint64_t ttl, uint64_t now){
+	uint64_t expires_at = now + ttl;
+	dict_elem_t elem = dict_get_elem(dict->dict, key);
+	
+	if (elem != NULL) {
+		ttl_dict_entry_p entry = dict_value_ptr(elem);
+		ttl_dict_timer_unlink(dict, entry->timer);
+		entry->expires_at = expires_at;
+		timer_ptr(dict, entry->timer)->expires_at = expires_at;
+		ttl_dict_timer_link(dict, entry->timer, dict->now + 1);
+		return entry_value_ptr(entry);
+	}
+	
+	uint32_t timer = ttl_dict_timer_new(dict, key, expires_at);
+	if (timer == TTL_DICT_NIL)
+		return NULL;
+	
+	ttl_dict_entry_p entry = dict_put_ptr(dict->dict, key);
+	entry->expires_at = expires_at;
+	entry->timer = timer;
+	ttl_dict_timer_link(dict, timer, dict->now + 1);
+	
+	return entry_value_ptr(entry);
+}
+
+/**
+ * Returns a pointer to the value of `key` or NULL if there is no such entry. If the entry
+ * expired at or before `now` it is expired right away and NULL is returned.
+ */
+void* ttl_dict_get_ptr(ttl_dict_p dict, const char* key, uint64_t now){
+	dict_elem_t elem = dict_get_elem(dict->dict, key);
+	if (elem == NULL)
+		return NULL;
+	
+	ttl_dict_entry_p entry = dict_value_ptr(elem);
+	if (entry->expires_at <= now) {
+		ttl_dict_expire_elem(dict, elem);
+		ttl_dict_shrink(dict);
+		return NULL;
+	}
+	
+	return entry_value_ptr(entry);
+}
+
+uint64_t ttl_dict_expires_at(ttl_dict_p dict, const char* key){
+	ttl_dict_entry_p entry = dict_get_ptr(dict->dict, key);
+	return (entry != NULL) ? entry->expires_at : 0;
+}
+
+void ttl_dict_remove(ttl_dict_p dict, const char* key){
+	ttl_dict_entry_p entry = dict_get_ptr(dict->dict, key);
+	if (entry == NULL)
+		return;
+	
+	ttl_dict_timer_unlink(dict, entry->timer);
+	ttl_dict_timer_free(dict, entry->timer);
+	dict_remove(dict->dict, key);
+}
+
+
+//
+// Timer wheel
+//
+
+/**
+ * Advances the timer wheel to `now` and expires all entries with an expiration time
+ * at or before `now`. Returns the number of expired entries.
+ */
+size_t ttl_dict_expire(ttl_dict_p dict, uint64_t now){
+	size_t expirations_before = dict->expirations;
+	
+	while(dict->now < now) {
+		// Nothing to expire, jump right to the target time
+		if (dict->dict->length == 0) {
+			dict->now = now;
+			break;
+		}
+		
+		uint64_t tick = dict->now + 1;
+		
+		// Move timers down from higher levels when we reach the start of their slot.
+		// Higher levels first so they can cascade further down in the same tick.
+		for(size_t level = TTL_DICT_LEVELS - 1; level > 0; level--) {
+			uint64_t level_shift = level * TTL_DICT_SLOT_BITS;
+			if ( (tick & ((UINT64_C(1) << level_shift) - 1)) == 0 )
+				ttl_dict_cascade(dict, level * TTL_DICT_SLOTS + ((tick >> level_shift) & (TTL_DICT_SLOTS - 1)), tick);
+		}
+		
+		// Detach the level 0 slot of this tick and expire all its timers
+		uint32_t list = tick & (TTL_DICT_SLOTS - 1);
+		uint32_t index = dict->wheel[list];
+		dict->wheel[list] = TTL_DICT_NIL;
+		dict->now = tick;
+		
+		while(index != TTL_DICT_NIL) {
+			ttl_dict_timer_p timer = timer_ptr(dict, index);
+			uint32_t next = timer->next;
+			timer->list = TTL_DICT_NIL;
+			
+			ttl_dict_expire_elem(dict, dict_get_elem(dict->dict, timer->key));
+			
+			index = next;
+		}
+	}
+	
+	ttl_dict_shrink(dict);
+	return dict->expirations - expirations_before;
+}
+
+/**
+ * Detaches all timers from a slot of a higher level and links them again. Relative to
+ * `tick` they now fall into lower levels. The level 0 slot of `tick` hasn't expired yet,
+ * so timers expiring at `tick` still go into it.
+ */
+static void ttl_dict_cascade(ttl_dict_p dict, uint32_t list, uint64_t tick){
+	uint32_t index = dict->wheel[list];
+	dict->wheel[list] = TTL_DICT_NIL;
+	
+	while(index != TTL_DICT_NIL) {
+		uint32_t next = timer_ptr(dict, index)->next;
+		ttl_dict_timer_link(dict, index, tick);
+		index = next;
+	}
+}
+
+/**
+ * Links a timer into the wheel slot for its expiration time. `next_tick` is the first
+ * tick whose level 0 slot hasn't expired yet, timers that expire before it go into that
+ * slot. Higher level slots are only used when they start after `next_tick`, otherwise
+ * they would be cascaded only one round later.
+ */
+static void ttl_dict_timer_link(ttl_dict_p dict, uint32_t index, uint64_t next_tick){
+	ttl_dict_timer_p timer = timer_ptr(dict, index);
+	uint64_t expires_at = timer->expires_at;
+	if (expires_at < next_tick)
+		expires_at = next_tick;
+	
+	// Find the lowest level that covers the time left until expiration. Timers further
+	// away than the wheel covers are parked in the last slot range of the highest level.
+	uint64_t delta = expires_at - next_tick;
+	size_t level = 0;
+	while(level < TTL_DICT_LEVELS - 1 && delta >= (UINT64_C(1) << ((level + 1) * TTL_DICT_SLOT_BITS)))
+		level++;
+	
+	uint64_t max_delta = (UINT64_C(1) << (TTL_DICT_LEVELS * TTL_DICT_SLOT_BITS)) - 1;
+	if (delta > max_delta)
+		expires_at = next_tick + max_delta;
+	
+	uint32_t list = level * TTL_DICT_SLOTS + ((expires_at >> (level * TTL_DICT_SLOT_BITS)) & (TTL_DICT_SLOTS - 1));
+	timer->list = list;
+	timer->prev = TTL_DICT_NIL;
+	timer->next = dict->wheel[list];
+	if (timer->next != TTL_DICT_NIL)
+		timer_ptr(dict, timer->next)->prev = index;
+	dict->wheel[list] = index;
+}
+
+static void ttl_dict_timer_unlink(ttl_dict_p dict, uint32_t index){
+	ttl_dict_timer_p timer = timer_ptr(dict, index);
+	if (timer->list == TTL_DICT_NIL)
+		return;
+	
+	if (timer->prev != TTL_DICT_NIL)
+		timer_ptr(dict, timer->prev)->next = timer->next;
+	else
+		dict->wheel[timer->list] = timer->next;
+	
+	if (timer->next != TTL_DICT_NIL)
+		timer_ptr(dict, timer->next)->prev = timer->prev;
+	
+	timer->list = TTL_DICT_NIL;
+}
+
+static uint32_t ttl_dict_timer_new(ttl_dict_p dict, const char* key, uint64_t expires_at){
+	uint32_t index = dict->free_timers;
+	
+	if (index != TTL_DICT_NIL) {
+		dict->free_timers = timer_ptr(dict, index)->next;
+	} else {
+		if (array_append_ptr(dict->timers) == NULL)
+			return TTL_DICT_NIL;
+		index = dict->timers->length - 1;
+	}
+	
+	ttl_dict_timer_p timer = timer_ptr(dict, index);
+	timer->key = key;
+	timer->expires_at = expires_at;
+	timer->list = TTL_DICT_NIL;
+	return index;
+}
+
+static void ttl_dict_timer_free(ttl_dict_p dict, uint32_t index){
+	timer_ptr(dict, index)->next = dict->free_timers;
+	dict->free_timers = index;
+}
+
+/**
+ * Removes the entry and its timer and then calls the expire callback. The entry is
+ * removed first so the callback can free the key. The slot is only marked as deleted
+ * so the value is still intact while the callback runs.
+ */
+static void ttl_dict_expire_elem(ttl_dict_p dict, dict_elem_t elem){
+	ttl_dict_entry_p entry = dict_value_ptr(elem);
+	
+	ttl_dict_timer_unlink(dict, entry->timer);
+	ttl_dict_timer_free(dict, entry->timer);
+	dict_remove_elem(dict->dict, elem);
+	dict->expirations++;
+	
+	if (dict->expire_func)
+		dict->expire_func(dict_key(elem), entry_value_ptr(entry), dict->expire_context);
+}
+
+/**
+ * Expiring only marks slots as deleted, so shrink the dict the same way dict_remove()
+ * would once it became mostly empty.
+ */
+static void ttl_dict_shrink(ttl_dict_p dict){
+	if (dict->dict->capacity > 5 && dict->dict->length < dict->dict->capacity * 0.2)
+		dict_resize(dict->dict, dict->dict->capacity / 2);
+}
\ No newline at end of file
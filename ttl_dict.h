@@ -0,0 +1,101 @@
+#pragma once
+
+/**
+
+# A dict with per entry time to live
+
+Each entry of a TTL dict has an expiration time. Expired entries are removed by
+ttl_dict_expire() which advances a hierarchical timer wheel. This costs O(expired
+entries + elapsed ticks) instead of scanning the entire dict. Lookups also check the
+expiration time and remove expired entries right away (lazy expiry).
+
+The dict doesn't read any clock. All time values are ticks of your choosing (e.g.
+milliseconds or seconds since some epoch) and you pass the current time to the
+functions that need it. ttl_dict_expire() walks every tick between the last and the
+current call, so choose a tick size that matches how often you call it.
+
+
+// Creating and destroying
+
+ttl_dict_p dict = ttl_dict_of(int, now);
+ttl_dict_destroy(dict);
+
+
+// Put and get. The value is alive for `ttl` ticks after `now`.
+
+ttl_dict_put(dict, "foo", int, 7, ttl, now);
+int* value = ttl_dict_get_ptr(dict, "foo", now);   // NULL if missing or expired
+ttl_dict_get(dict, "foo", int, now);               // -> 7, crashes if missing or expired
+ttl_dict_expires_at(dict, "foo");                  // -> now + ttl, 0 if missing
+ttl_dict_remove(dict, "foo");
+
+
+// Expire callback, called for every entry that expires (in ttl_dict_expire() or lazily
+// in ttl_dict_get_ptr()). Not called for ttl_dict_remove() or ttl_dict_destroy().
+
+void on_expire(const char* key, void* value, void* context){
+	free((char*)key);
+}
+ttl_dict_on_expire(dict, on_expire, NULL);
+
+
+// Periodically expire entries, e.g. once per tick
+
+ttl_dict_expire(dict, now);   // -> number of expired entries
+
+
+# Implementation notes
+
+The timer wheel has TTL_DICT_LEVELS levels with TTL_DICT_SLOTS slots each. Level 0
+slots cover one tick, level 1 slots TTL_DICT_SLOTS ticks, level 2 slots
+TTL_DICT_SLOTS^2 ticks and so on. When the wheel reaches the start of a higher level
+slot all timers in it are moved down into the lower levels (cascading). Timers that
+are further away than the wheel can cover are parked in the highest level and
+reinserted whenever they cascade.
+
+Timers are stored in an array and reference each other by index. The dict value of an
+entry contains the expiration time and the index of its timer followed by the users
+value. Since timers only store the key the dict can be resized freely.
+
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hash.h"
+#include "array.h"
+
+
+#define TTL_DICT_LEVELS     4
+#define TTL_DICT_SLOT_BITS  6
+#define TTL_DICT_SLOTS      (1 << TTL_DICT_SLOT_BITS)
+
+typedef void (*ttl_dict_expire_func_t)(const char* key, void* value, void* context);
+
+typedef struct {
+	dict_p dict;
+	size_t value_size;
+	uint64_t now;
+	
+	array_p timers;
+	uint32_t free_timers;
+	uint32_t wheel[TTL_DICT_LEVELS * TTL_DICT_SLOTS];
+	
+	ttl_dict_expire_func_t expire_func;
+	void* expire_context;
+	size_t expirations;
+} ttl_dict_t, *ttl_dict_p;
+
+
+#define  ttl_dict_of(type, now)    ttl_dict_new(5, sizeof(type), now)
+ttl_dict_p ttl_dict_new(size_t capacity, size_t value_size, uint64_t now);
+void       ttl_dict_destroy(ttl_dict_p dict);
+void       ttl_dict_on_expire(ttl_dict_p dict, ttl_dict_expire_func_t func, void* context);
+
+#define    ttl_dict_put(dict, key, type, value, ttl, now)  ( *((type*)ttl_dict_put_ptr(dict, key, ttl, now)) = (value) )
+#define    ttl_dict_get(dict, key, type, now)              ( *((type*)ttl_dict_get_ptr(dict, key, now)) )
+void*      ttl_dict_put_ptr(ttl_dict_p dict, const char* key, uint64_t ttl, uint64_t now);
+void*      ttl_dict_get_ptr(ttl_dict_p dict, const char* key, uint64_t now);
+uint64_t   ttl_dict_expires_at(ttl_dict_p dict, const char* key);
+void       ttl_dict_remove(ttl_dict_p dict, const char* key);
+
+size_t     ttl_dict_expire(ttl_dict_p dict, uint64_t now);
\ No newline at end of file